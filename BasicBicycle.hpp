@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Bicycle.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace mybicycles
+{
+
+/**
+ * A vendor name of at most @CAPACITY characters kept right in the object: it never allocates.
+ */
+template <size_t CAPACITY>
+class InlineVendor
+{
+public:
+    InlineVendor() noexcept = default;
+
+    explicit InlineVendor(std::string_view vendor)
+    {
+        if (vendor.size() > CAPACITY)
+        {
+            throw std::length_error("Vendor name is longer than " + std::to_string(CAPACITY) + " characters");
+        }
+        std::memcpy(mChars, vendor.data(), vendor.size());
+        mSize = static_cast<unsigned char>(vendor.size());
+    }
+
+    operator std::string_view() const noexcept
+    {
+        return std::string_view(mChars, mSize);
+    }
+
+    void clear() noexcept
+    {
+        mSize = 0;
+    }
+
+private:
+    static_assert(CAPACITY < 256, "The size is kept in a byte");
+
+    char mChars[CAPACITY];
+    unsigned char mSize = 0;
+};
+
+/**
+ * A leaner BicycleImpl for containers of many bicycles: no vptr & no debug flag, and the vendor name is
+ * of @VendorType, either an @InlineVendor or a std::basic_string whose allocator is the container's one.
+ *
+ * In the latter case BasicBicycle is allocator-aware (std::uses_allocator is true for it): a container
+ * with a scoped allocator (see MyScopedAllocator) constructs its bicycles with its own allocator, so the
+ * names longer than the small string buffer are in the container's segment too.
+ */
+template <typename VendorType>
+class BasicBicycle
+{
+public:
+    template <typename Alloc>
+    using EnableIfUsesAllocator = std::enable_if_t<std::uses_allocator<VendorType, Alloc>::value, int>;
+
+    BasicBicycle() = default;
+
+    explicit BasicBicycle(std::string_view vendor,
+                          int16_t pressureFront = CITY_BIKE_NORMAL_PRESSURE_PSI,
+                          int16_t pressureRear = CITY_BIKE_NORMAL_PRESSURE_PSI) :
+        mVendor(vendor),
+        mFrontTyre(pressureFront),
+        mRearTyre(pressureRear)
+    {
+    }
+
+    // Allocator-extended ctors, for uses-allocator construction:
+    template <typename Alloc, EnableIfUsesAllocator<Alloc> = 0>
+    BasicBicycle(std::allocator_arg_t, const Alloc& alloc, std::string_view vendor,
+                 int16_t pressureFront = CITY_BIKE_NORMAL_PRESSURE_PSI,
+                 int16_t pressureRear = CITY_BIKE_NORMAL_PRESSURE_PSI) :
+        mVendor(vendor, alloc),
+        mFrontTyre(pressureFront),
+        mRearTyre(pressureRear)
+    {
+    }
+
+    template <typename Alloc, EnableIfUsesAllocator<Alloc> = 0>
+    BasicBicycle(std::allocator_arg_t, const Alloc& alloc, const BasicBicycle& rhs) :
+        mVendor(rhs.mVendor, alloc),
+        mFrontTyre(rhs.mFrontTyre),
+        mRearTyre(rhs.mRearTyre)
+    {
+    }
+
+    // Steals the name if @alloc is equal to the one of @rhs, copies it otherwise
+    template <typename Alloc, EnableIfUsesAllocator<Alloc> = 0>
+    BasicBicycle(std::allocator_arg_t, const Alloc& alloc, BasicBicycle&& rhs) :
+        mVendor(std::move(rhs.mVendor), alloc),
+        mFrontTyre(rhs.mFrontTyre),
+        mRearTyre(rhs.mRearTyre)
+    {
+    }
+
+    BasicBicycle(const BasicBicycle& rhs) = default;
+    BasicBicycle& operator= (const BasicBicycle& rhs) = default;
+    BasicBicycle(BasicBicycle&& rhs) noexcept = default;
+    BasicBicycle& operator= (BasicBicycle&& rhs) noexcept = default;
+    ~BasicBicycle() = default;
+
+    bool operator<(const BasicBicycle& rhs) const
+    {
+        return getVendor() < rhs.getVendor();
+    }
+
+    void ringBell() const
+    {
+        std::cout << "Caution! Bike " << getVendor() << " is on its way!" << std::endl;
+    }
+
+    std::string_view getVendor() const noexcept
+    {
+        return mVendor;
+    }
+
+    int16_t getPressureFront() const
+    {
+        return mFrontTyre.pressure;
+    }
+
+    int16_t getPressureRear() const
+    {
+        return mRearTyre.pressure;
+    }
+
+private:
+    VendorType mVendor;
+    Tyre mFrontTyre;
+    Tyre mRearTyre;
+};
+
+template <typename VendorType>
+inline std::ostream& operator<<(std::ostream& os, const BasicBicycle<VendorType>& bc) {
+    os << bc.getVendor() << ", front tyre " << Tyre(bc.getPressureFront()) << ", rear tyre " << Tyre(bc.getPressureRear());
+    return os;
+}
+
+// A bicycle which never allocates (names up to 23 characters, 28 bytes in total)
+using InlineBicycle = BasicBicycle<InlineVendor<23>>;
+
+// A bicycle whose name is allocated by @Allocator (rebound to char)
+template <typename Allocator>
+using AllocBicycle = BasicBicycle<std::basic_string<char, std::char_traits<char>,
+                                                    typename std::allocator_traits<Allocator>::template rebind_alloc<char>>>;
+
+} // mybicycles
+
+namespace std
+{
+
+template <typename VendorType, typename Alloc>
+struct uses_allocator<mybicycles::BasicBicycle<VendorType>, Alloc> : uses_allocator<VendorType, Alloc>
+{
+};
+
+} // std
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "Report.hpp"
+#include "Traces.hpp"
+#include "MemoryManagement/SegmentManagerStats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+/**
+ * Replays a trace against segment managers of type @SegmentManagerType, one thread per traced thread.
+ *
+ * Every trace is replayed twice, each time with a fresh manager: first for throughput (no per-op timing),
+ * then for latencies & fragmentation, which are sampled by the first thread @samplesNum times over its ops.
+ * A thread freeing a block allocated by another thread waits (yielding) till the block is allocated;
+ * recorded traces are ordered by time, so the wait always ends. Otherwise the threads run freely, so
+ * in a multi-threaded replay a producer may get ahead of its consumer and hold more than the trace did.
+ */
+template <typename SegmentManagerType>
+class Replayer
+{
+public:
+    Replayer(const ReplayTrace& trace, size_t samplesNum) :
+        mTrace(trace),
+        mSamplesNum(samplesNum)
+    {
+    }
+
+    /**
+     * @makeManager returns a std::unique_ptr to a fresh manager.
+     */
+    template <typename Factory>
+    ReplayResult run(const std::string& managerName, Factory makeManager)
+    {
+        ReplayResult result;
+        result.trace = mTrace.name;
+        result.manager = managerName;
+        result.threadsNum = mTrace.threads.size();
+        result.opsNum = mTrace.opsNum;
+        result.peakLiveBytes = mTrace.peakLiveBytes;
+
+        {
+            std::unique_ptr<SegmentManagerType> manager = makeManager();
+            Pass<false> pass(mTrace, *manager, 0);
+            result.seconds = pass.run();
+            result.failedAllocsNum = pass.failedAllocsNum();
+        }
+        {
+            std::unique_ptr<SegmentManagerType> manager = makeManager();
+            Pass<true> pass(mTrace, *manager, mSamplesNum);
+            pass.run();
+            result.allocLatencyNs = summarize(pass.allocLatencies());
+            result.freeLatencyNs = summarize(pass.freeLatencies());
+            result.fragmentation = pass.samples();
+            result.peakFootprintBytes = manager->getStats().peakOccupiedBytes;
+        }
+        return result;
+    }
+
+private:
+    template <bool MEASURE>
+    class Pass
+    {
+    public:
+        Pass(const ReplayTrace& trace, SegmentManagerType& manager, size_t samplesNum) :
+            mTrace(trace),
+            mManager(manager),
+            mSlots(new std::atomic<void*>[trace.slotsNum]),
+            mThreads(trace.threads.size()),
+            mSampleStep(samplesNum != 0 && !trace.threads.empty() ?
+                        std::max<size_t>(1, trace.threads.front().size() / samplesNum) : 0),
+            mReady(0),
+            mGo(false)
+        {
+            for (size_t i = 0; i < trace.slotsNum; i++)
+            {
+                mSlots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Returns the wall time in seconds.
+         */
+        double run()
+        {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < mThreads.size(); t++)
+            {
+                threads.emplace_back(&Pass::replayThread, this, t);
+            }
+            while (mReady.load(std::memory_order_acquire) != threads.size())
+            {
+                std::this_thread::yield();
+            }
+            auto start = std::chrono::steady_clock::now();
+            mGo.store(true, std::memory_order_release);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        size_t failedAllocsNum() const
+        {
+            size_t failed = 0;
+            for (const auto& thread : mThreads)
+            {
+                failed += thread.failedAllocsNum;
+            }
+            return failed;
+        }
+
+        std::vector<uint32_t>& allocLatencies() { return merge(&ThreadData::allocLatencies); }
+        std::vector<uint32_t>& freeLatencies() { return merge(&ThreadData::freeLatencies); }
+        const std::vector<FragmentationSample>& samples() const { return mSamples; }
+
+    private:
+        struct ThreadData
+        {
+            size_t failedAllocsNum = 0;
+            std::vector<uint32_t> allocLatencies;
+            std::vector<uint32_t> freeLatencies;
+        };
+
+        // A slot of an allocation that failed, so the free is skipped
+        static void* failedBlock()
+        {
+            static char sFailed;
+            return &sFailed;
+        }
+
+        static uint32_t nsSince(std::chrono::steady_clock::time_point start)
+        {
+            return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - start).count());
+        }
+
+        void* tryAlloc(size_t size)
+        {
+            return mManager.alloc(size);
+        }
+
+        void replayThread(size_t t)
+        {
+            const std::vector<ReplayOp>& ops = mTrace.threads[t];
+            ThreadData& data = mThreads[t];
+            if (MEASURE)
+            {
+                data.allocLatencies.reserve(ops.size());
+                data.freeLatencies.reserve(ops.size());
+            }
+            mReady.fetch_add(1, std::memory_order_acq_rel);
+            while (!mGo.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            for (size_t i = 0; i < ops.size(); i++)
+            {
+                const ReplayOp& op = ops[i];
+                if (op.size != 0)
+                {
+                    auto start = MEASURE ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                    void* block = tryAlloc(op.size);
+                    if (MEASURE)
+                    {
+                        data.allocLatencies.push_back(nsSince(start));
+                    }
+                    if (nullptr == block)
+                    {
+                        data.failedAllocsNum++;
+                        block = failedBlock();
+                    }
+                    mSlots[op.slot].store(block, std::memory_order_release);
+                }
+                else
+                {
+                    void* block;
+                    while (nullptr == (block = mSlots[op.slot].load(std::memory_order_acquire)))
+                    {
+                        std::this_thread::yield(); // allocated by another thread, which lags behind
+                    }
+                    if (block != failedBlock())
+                    {
+                        auto start = MEASURE ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                        mManager.free(block);
+                        if (MEASURE)
+                        {
+                            data.freeLatencies.push_back(nsSince(start));
+                        }
+                    }
+                }
+
+                if (MEASURE && 0 == t && mSampleStep != 0 && ((i + 1) % mSampleStep == 0 || i + 1 == ops.size()))
+                {
+                    SegmentManagerStats stats = mManager.getStats();
+                    mSamples.push_back(FragmentationSample{i + 1, stats.occupiedBytes, stats.freeBytes,
+                                                           stats.largestFreeBlockBytes, stats.fragmentation});
+                }
+            }
+        }
+
+        std::vector<uint32_t>& merge(std::vector<uint32_t> ThreadData::* latencies)
+        {
+            std::vector<uint32_t>& merged = mThreads.front().*latencies;
+            for (size_t t = 1; t < mThreads.size(); t++)
+            {
+                merged.insert(merged.end(), (mThreads[t].*latencies).begin(), (mThreads[t].*latencies).end());
+                (mThreads[t].*latencies).clear();
+            }
+            return merged;
+        }
+
+        const ReplayTrace& mTrace;
+        SegmentManagerType& mManager;
+        std::unique_ptr<std::atomic<void*>[]> mSlots;
+        std::vector<ThreadData> mThreads;
+        size_t mSampleStep;
+        std::atomic<size_t> mReady;
+        std::atomic<bool> mGo;
+        std::vector<FragmentationSample> mSamples;
+    };
+
+    const ReplayTrace& mTrace;
+    size_t mSamplesNum;
+};
@@ -0,0 +1,101 @@
+#include "Report.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+    uint64_t percentile(std::vector<uint32_t>& latencies, double fraction)
+    {
+        size_t index = std::min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()));
+        std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+        return latencies[index];
+    }
+
+    void writeLatency(std::ostream& os, const LatencySummary& latency)
+    {
+        os << "{\"p50\":" << latency.p50 << ",\"p90\":" << latency.p90 << ",\"p99\":" << latency.p99
+           << ",\"p999\":" << latency.p999 << ",\"max\":" << latency.max << "}";
+    }
+
+    // Trace names come from file names, which may contain anything
+    void writeString(std::ostream& os, const std::string& str)
+    {
+        os << '"';
+        for (char c : str)
+        {
+            if ('"' == c || '\\' == c)
+            {
+                os << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                   << std::dec << std::setfill(' ');
+            }
+            else
+            {
+                os << c;
+            }
+        }
+        os << '"';
+    }
+}
+
+LatencySummary summarize(std::vector<uint32_t>& latencies)
+{
+    LatencySummary summary;
+    if (latencies.empty())
+    {
+        return summary;
+    }
+    summary.p50 = percentile(latencies, 0.5);
+    summary.p90 = percentile(latencies, 0.9);
+    summary.p99 = percentile(latencies, 0.99);
+    summary.p999 = percentile(latencies, 0.999);
+    summary.max = *std::max_element(latencies.begin(), latencies.end());
+    return summary;
+}
+
+void writeJsonLine(std::ostream& os, const ReplayResult& result)
+{
+    os << "{\"trace\":";
+    writeString(os, result.trace);
+    os << ",\"manager\":";
+    writeString(os, result.manager);
+    os << ",\"threads\":" << result.threadsNum << ",\"ops\":" << result.opsNum
+       << ",\"failedAllocs\":" << result.failedAllocsNum
+       << ",\"seconds\":" << std::setprecision(6) << result.seconds
+       << ",\"opsPerSecond\":" << std::fixed << std::setprecision(0)
+       << (result.seconds > 0 ? result.opsNum / result.seconds : 0.0) << std::defaultfloat
+       << ",\"allocLatencyNs\":";
+    writeLatency(os, result.allocLatencyNs);
+    os << ",\"freeLatencyNs\":";
+    writeLatency(os, result.freeLatencyNs);
+    os << ",\"peakLiveBytes\":" << result.peakLiveBytes << ",\"peakFootprintBytes\":" << result.peakFootprintBytes
+       << ",\"fragmentation\":[";
+    for (size_t i = 0; i < result.fragmentation.size(); i++)
+    {
+        const FragmentationSample& sample = result.fragmentation[i];
+        os << (i != 0 ? "," : "") << "{\"op\":" << sample.op << ",\"occupiedBytes\":" << sample.occupiedBytes
+           << ",\"freeBytes\":" << sample.freeBytes << ",\"largestFreeBlockBytes\":" << sample.largestFreeBlockBytes
+           << ",\"fragmentation\":" << std::setprecision(4) << sample.fragmentation << "}";
+    }
+    os << "]}\n";
+}
+
+void writeSummaryLine(std::ostream& os, const ReplayResult& result)
+{
+    double maxFragmentation = 0.0;
+    for (const auto& sample : result.fragmentation)
+    {
+        maxFragmentation = std::max(maxFragmentation, sample.fragmentation);
+    }
+    os << std::left << std::setw(16) << result.trace << std::setw(32) << result.manager << std::right
+       << std::fixed << std::setprecision(2) << std::setw(9) << result.opsNum / result.seconds / 1e6 << " Mops/s"
+       << "  alloc p50/p99 " << std::setw(5) << result.allocLatencyNs.p50 << "/" << std::setw(6) << result.allocLatencyNs.p99
+       << " ns  free p50/p99 " << std::setw(5) << result.freeLatencyNs.p50 << "/" << std::setw(6) << result.freeLatencyNs.p99
+       << " ns  footprint " << std::setw(8) << result.peakFootprintBytes / 1024 << "/" << result.peakLiveBytes / 1024
+       << " KB  max frag " << std::setprecision(3) << maxFragmentation
+       << "  failed " << result.failedAllocsNum << std::defaultfloat << "\n";
+}
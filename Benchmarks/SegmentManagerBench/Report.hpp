@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct LatencySummary
+{
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * The segment manager's state after the first @op ops of the trace (counted in the replay's first thread).
+ */
+struct FragmentationSample
+{
+    size_t op;
+    size_t occupiedBytes;
+    size_t freeBytes;
+    size_t largestFreeBlockBytes;
+    double fragmentation;
+};
+
+/**
+ * The outcome of replaying one trace against one segment manager.
+ * Footprint & fragmentation come from the manager's getStats(): they're all zeros for managers which
+ * don't manage a segment of their own (DummySegmentManager).
+ */
+struct ReplayResult
+{
+    std::string trace;
+    std::string manager;
+    size_t threadsNum = 0;
+    size_t opsNum = 0;
+    size_t failedAllocsNum = 0;
+    double seconds = 0.0; // wall time of the replay without per-op timing
+    LatencySummary allocLatencyNs;
+    LatencySummary freeLatencyNs;
+    uint64_t peakLiveBytes = 0; // requested by the trace
+    uint64_t peakFootprintBytes = 0; // occupied in the segment, the managers' overhead included
+    std::vector<FragmentationSample> fragmentation;
+};
+
+/**
+ * Computes the percentiles of @latencies (reorders them).
+ */
+LatencySummary summarize(std::vector<uint32_t>& latencies);
+
+/**
+ * Writes @result as a single line of JSON.
+ */
+void writeJsonLine(std::ostream& os, const ReplayResult& result);
+
+/**
+ * Writes a one-line human readable summary of @result.
+ */
+void writeSummaryLine(std::ostream& os, const ReplayResult& result);
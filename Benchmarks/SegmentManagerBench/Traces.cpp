@@ -0,0 +1,233 @@
+#include "Traces.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+using mybicycles::AllocEventType;
+using mybicycles::AllocTraceEvent;
+
+namespace
+{
+    const size_t UNIFORM_MIN_SZ = 16;
+    const size_t UNIFORM_MAX_SZ = 1024;
+    const size_t UNIFORM_LIVE_BLOCKS = 4096; // per thread, on average
+
+    const double POWER_LAW_SIZE_ALPHA = 1.5; // most blocks are small, a few are big
+    const size_t POWER_LAW_MIN_SZ = 16;
+    const size_t POWER_LAW_MAX_SZ = 64 * 1024;
+    const double POWER_LAW_LIFETIME_ALPHA = 0.5; // most blocks die young, a few live (almost) forever
+
+    const size_t MESSAGE_MIN_SZ = 64;
+    const size_t MESSAGE_MAX_SZ = 2048;
+    const size_t MAX_QUEUE_DEPTH = 1024;
+    const size_t MAX_BURST = 32;
+
+    // A trace being generated by one thread (or one pair of threads). Blocks are known by ids, which
+    // become the events' addresses, so they never repeat within the whole trace.
+    class Stream
+    {
+    public:
+        Stream(uint32_t streamId) : mNextId(static_cast<uint64_t>(streamId + 1) << 40) {}
+
+        uint64_t alloc(uint32_t threadId, size_t size)
+        {
+            uint64_t id = mNextId;
+            mNextId += 16;
+            mEvents.push_back(makeEvent(AllocEventType::Alloc, threadId, id, size));
+            return id;
+        }
+
+        void free(uint32_t threadId, uint64_t id)
+        {
+            mEvents.push_back(makeEvent(AllocEventType::Free, threadId, id, 0));
+        }
+
+        const std::vector<AllocTraceEvent>& events() const { return mEvents; }
+
+    private:
+        static AllocTraceEvent makeEvent(AllocEventType type, uint32_t threadId, uint64_t id, size_t size)
+        {
+            AllocTraceEvent event{};
+            event.address = id;
+            event.size = size;
+            event.threadId = threadId;
+            event.type = type;
+            return event;
+        }
+
+        uint64_t mNextId;
+        std::vector<AllocTraceEvent> mEvents;
+    };
+
+    // Interleaves the streams event by event, as if their threads ran in lockstep, and stamps the time
+    std::vector<AllocTraceEvent> interleave(const std::vector<Stream>& streams)
+    {
+        std::vector<AllocTraceEvent> events;
+        uint64_t timestamp = 0;
+        for (size_t i = 0;; i++)
+        {
+            bool anyLeft = false;
+            for (const auto& stream : streams)
+            {
+                if (i < stream.events().size())
+                {
+                    events.push_back(stream.events()[i]);
+                    events.back().timestampNs = timestamp++;
+                    anyLeft = true;
+                }
+            }
+            if (!anyLeft)
+            {
+                return events;
+            }
+        }
+    }
+
+    // Pareto distributed value >= @min, capped at @max
+    size_t pareto(std::mt19937_64& rng, double alpha, size_t min, size_t max)
+    {
+        double u = 1.0 - std::uniform_real_distribution<double>(0.0, 1.0)(rng); // (0, 1]
+        double value = min / std::pow(u, 1.0 / alpha);
+        return value < max ? static_cast<size_t>(value) : max;
+    }
+}
+
+ReplayTrace makeReplayTrace(const std::string& name, const std::vector<AllocTraceEvent>& events)
+{
+    ReplayTrace trace;
+    trace.name = name;
+    std::unordered_map<uint32_t, size_t> threadIndices; // traced ids are sparse if other threads traced too
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> live; // address -> slot & size
+    uint64_t liveBytes = 0;
+
+    for (const auto& event : events)
+    {
+        // In-place resizes aren't replayed: the replayer's blocks keep their allocated sizes
+        if (event.type != AllocEventType::Alloc && event.type != AllocEventType::Free)
+        {
+            continue;
+        }
+        ReplayOp op{};
+        if (AllocEventType::Alloc == event.type)
+        {
+            op.slot = static_cast<uint32_t>(trace.slotsNum++);
+            op.size = static_cast<uint32_t>(std::max<uint64_t>(1, event.size));
+            live[event.address] = {op.slot, op.size};
+            liveBytes += op.size;
+            trace.peakLiveBytes = std::max(trace.peakLiveBytes, liveBytes);
+        }
+        else
+        {
+            auto it = live.find(event.address);
+            if (it == live.end())
+            {
+                continue; // allocated before the trace's window
+            }
+            op.slot = it->second.first;
+            liveBytes -= it->second.second;
+            live.erase(it);
+        }
+
+        auto inserted = threadIndices.emplace(event.threadId, trace.threads.size());
+        if (inserted.second)
+        {
+            trace.threads.emplace_back();
+        }
+        trace.threads[inserted.first->second].push_back(op);
+        trace.opsNum++;
+    }
+    return trace;
+}
+
+std::vector<AllocTraceEvent> makeUniformTrace(size_t opsNum, size_t threadsNum, uint64_t seed)
+{
+    std::vector<Stream> streams;
+    for (uint32_t t = 0; t < threadsNum; t++)
+    {
+        std::mt19937_64 rng(seed + t);
+        std::uniform_int_distribution<size_t> sizes(UNIFORM_MIN_SZ, UNIFORM_MAX_SZ);
+        Stream stream(t);
+        std::vector<uint64_t> live;
+        for (size_t i = 0; i < opsNum / threadsNum; i++)
+        {
+            // Allocations prevail till there are UNIFORM_LIVE_BLOCKS blocks, then frees do
+            bool doAlloc = live.empty() || rng() % (live.size() < UNIFORM_LIVE_BLOCKS ? 3 : 5) < 2;
+            if (doAlloc)
+            {
+                live.push_back(stream.alloc(t, sizes(rng)));
+            }
+            else
+            {
+                size_t victim = rng() % live.size();
+                stream.free(t, live[victim]);
+                live[victim] = live.back();
+                live.pop_back();
+            }
+        }
+        streams.push_back(std::move(stream));
+    }
+    return interleave(streams);
+}
+
+std::vector<AllocTraceEvent> makePowerLawTrace(size_t opsNum, size_t threadsNum, uint64_t seed)
+{
+    using Death = std::pair<size_t, uint64_t>; // step & block id
+    std::vector<Stream> streams;
+    for (uint32_t t = 0; t < threadsNum; t++)
+    {
+        std::mt19937_64 rng(seed + t);
+        Stream stream(t);
+        std::priority_queue<Death, std::vector<Death>, std::greater<Death>> deaths;
+        size_t streamOps = opsNum / threadsNum;
+        for (size_t step = 0; step < streamOps; step++)
+        {
+            if (!deaths.empty() && deaths.top().first <= step)
+            {
+                stream.free(t, deaths.top().second);
+                deaths.pop();
+                continue;
+            }
+            uint64_t id = stream.alloc(t, pareto(rng, POWER_LAW_SIZE_ALPHA, POWER_LAW_MIN_SZ, POWER_LAW_MAX_SZ));
+            size_t lifetime = pareto(rng, POWER_LAW_LIFETIME_ALPHA, 1, streamOps);
+            deaths.emplace(step + lifetime, id);
+        }
+        streams.push_back(std::move(stream));
+    }
+    return interleave(streams);
+}
+
+std::vector<AllocTraceEvent> makeProducerConsumerTrace(size_t opsNum, size_t threadsNum, uint64_t seed)
+{
+    size_t pairsNum = std::max<size_t>(1, threadsNum / 2);
+    std::vector<Stream> streams;
+    for (uint32_t p = 0; p < pairsNum; p++)
+    {
+        std::mt19937_64 rng(seed + p);
+        std::uniform_int_distribution<size_t> sizes(MESSAGE_MIN_SZ, MESSAGE_MAX_SZ);
+        uint32_t producer = 2 * p;
+        uint32_t consumer = 2 * p + 1;
+        Stream stream(p);
+        std::deque<uint64_t> queue;
+        size_t streamOps = opsNum / pairsNum;
+        for (size_t ops = 0; ops < streamOps;)
+        {
+            for (size_t burst = 1 + rng() % MAX_BURST; burst != 0 && queue.size() < MAX_QUEUE_DEPTH; burst--, ops++)
+            {
+                queue.push_back(stream.alloc(producer, sizes(rng)));
+            }
+            for (size_t burst = 1 + rng() % MAX_BURST; burst != 0 && !queue.empty(); burst--, ops++)
+            {
+                stream.free(consumer, queue.front());
+                queue.pop_front();
+            }
+        }
+        streams.push_back(std::move(stream));
+    }
+    return interleave(streams);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MemoryManagement/AllocTracer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * One step of a trace replay: allocating or freeing the block known by its slot (a sequential number
+ * of the allocation within the trace).
+ */
+struct ReplayOp
+{
+    uint32_t slot;
+    uint32_t size; // 0 for a free
+};
+
+/**
+ * A trace ready to be replayed: the ops of every traced thread, each thread's ops in program order.
+ * A block may be freed by another thread than the one which allocated it.
+ */
+struct ReplayTrace
+{
+    std::string name;
+    std::vector<std::vector<ReplayOp>> threads;
+    size_t slotsNum = 0;
+    size_t opsNum = 0;
+    uint64_t peakLiveBytes = 0; // of the requested sizes, as the trace goes
+};
+
+/**
+ * Turns allocation events (as recorded by AllocTracer) into a replayable trace. Frees of blocks allocated
+ * before the trace started, failed allocations & segment events are dropped; blocks never freed are
+ * left allocated till the end of the replay.
+ */
+ReplayTrace makeReplayTrace(const std::string& name, const std::vector<mybicycles::AllocTraceEvent>& events);
+
+/**
+ * Synthetic traces of @opsNum allocations & frees in total. Each of @threadsNum threads runs its own
+ * stream, except for the producer/consumer trace, where the threads are split into pairs: the producer
+ * allocates messages, the consumer frees them in FIFO order.
+ */
+std::vector<mybicycles::AllocTraceEvent> makeUniformTrace(size_t opsNum, size_t threadsNum, uint64_t seed);
+std::vector<mybicycles::AllocTraceEvent> makePowerLawTrace(size_t opsNum, size_t threadsNum, uint64_t seed);
+std::vector<mybicycles::AllocTraceEvent> makeProducerConsumerTrace(size_t opsNum, size_t threadsNum, uint64_t seed);
@@ -0,0 +1,288 @@
+// Replays allocation traces against the segment managers, so that one can be picked on evidence.
+//
+// Usage: SegmentManagerBench [options] [trace files...]
+//   --synthetic <uniform|powerlaw|prodcons|all|none>  synthetic traces to replay (default: all)
+//   --ops <N>            ops per synthetic trace (default: 1000000)
+//   --threads <N>        threads of a synthetic trace (default: 1; producer/consumer pairs: N / 2, at least 1)
+//   --seed <N>           seed of the synthetic traces (default: 1)
+//   --segment-mb <N>     size of the managers' segment (default: 512)
+//   --samples <N>        fragmentation samples per replay (default: 20)
+//   --managers <a,b,..>  managers to replay against (default: all)
+//   --out <file>         where to write the results (default: stdout)
+//   --record <file>      instead of replaying anything, run a sample container workload through
+//                        MyAllocatorRecording & dump its trace into <file>
+//
+// Trace files are the ones written by AllocTracer::dump(), e.g. by a program whose containers use
+// MyAllocatorRecording. Results are JSON lines, one per trace & manager; a human readable summary
+// goes to stderr.
+
+#include "Replayer.hpp"
+#include "Report.hpp"
+#include "Traces.hpp"
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/FixedBlockSegmentManager.hpp"
+#include "MemoryManagement/GrowableSegmentManager.hpp"
+#include "MemoryManagement/MonotonicArenaSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorRecording.hpp"
+#include "MemoryManagement/PersistentSegmentManager.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/SlabSegmentManager.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+#include "MemoryManagement/ThreadCacheSegmentManager.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mybicycles;
+
+namespace
+{
+    const size_t FIXED_BLOCK_SZ = 1024;
+    const size_t GROWABLE_INITIAL_SZ = 1024 * 1024;
+
+    struct Options
+    {
+        std::string synthetic = "all";
+        size_t opsNum = 1000 * 1000;
+        size_t threadsNum = 1;
+        uint64_t seed = 1;
+        size_t segmentBytes = 512 * 1024 * 1024;
+        size_t samplesNum = 20;
+        std::string managers = "all";
+        std::string outPath;
+        std::string recordPath;
+        std::vector<std::string> tracePaths;
+    };
+
+    Options parseOptions(int argc, char* argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                {
+                    throw std::invalid_argument("No value for " + arg);
+                }
+                return argv[++i];
+            };
+            if ("--synthetic" == arg) options.synthetic = value();
+            else if ("--ops" == arg) options.opsNum = std::stoul(value());
+            else if ("--threads" == arg) options.threadsNum = std::max<size_t>(1, std::stoul(value()));
+            else if ("--seed" == arg) options.seed = std::stoull(value());
+            else if ("--segment-mb" == arg) options.segmentBytes = std::stoul(value()) * 1024 * 1024;
+            else if ("--samples" == arg) options.samplesNum = std::stoul(value());
+            else if ("--managers" == arg) options.managers = value();
+            else if ("--out" == arg) options.outPath = value();
+            else if ("--record" == arg) options.recordPath = value();
+            else if (0 == arg.rfind("--", 0)) throw std::invalid_argument("Unknown option " + arg);
+            else options.tracePaths.push_back(arg);
+        }
+        return options;
+    }
+
+    bool isSelected(const std::string& list, const std::string& name)
+    {
+        if ("all" == list)
+        {
+            return true;
+        }
+        std::stringstream ss(list);
+        for (std::string item; std::getline(ss, item, ',');)
+        {
+            if (item == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A few threads working with node & array containers, as a stand-in for a real program
+    void runRecordedWorkload(const std::string& path)
+    {
+        const size_t THREADS_NUM = 4;
+        const int ROUNDS_NUM = 20000;
+        const size_t SEG_SIZE = 256 * 1024 * 1024;
+
+        std::vector<char> segment(SEG_SIZE);
+        auto manager = makeShared<SimpleSegmentManager>(segment.data(), SEG_SIZE);
+        AllocTracer& tracer = AllocTracer::instance();
+        tracer.setKeepAllEvents(true);
+        tracer.clear();
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS_NUM; t++)
+        {
+            threads.emplace_back([&manager, t]() {
+                using Garage = std::map<int, BicycleImpl, std::less<int>,
+                                        MyAllocatorRecording<std::pair<const int, BicycleImpl>, SimpleSegmentManager>>;
+                using Log = std::list<int, MyAllocatorRecording<int, SimpleSegmentManager>>;
+                using Buffer = std::vector<char, MyAllocatorRecording<char, SimpleSegmentManager>>;
+
+                std::mt19937 rng(static_cast<unsigned>(t));
+                Garage garage(manager);
+                Log log(manager);
+                for (int round = 0; round < ROUNDS_NUM; round++)
+                {
+                    int key = static_cast<int>(rng() % 4096);
+                    if (rng() % 3 != 0)
+                    {
+                        garage.emplace(key, BicycleImpl("Bicycle", 50, 60));
+                    }
+                    else
+                    {
+                        garage.erase(key);
+                    }
+                    log.push_back(round);
+                    if (log.size() > 512)
+                    {
+                        log.pop_front();
+                    }
+                    if (round % 64 == 0)
+                    {
+                        Buffer buffer(manager);
+                        for (size_t i = rng() % 8192; i != 0; i--)
+                        {
+                            buffer.push_back('b');
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (!tracer.dump(path))
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        tracer.setKeepAllEvents(false);
+        std::cerr << "Recorded " << AllocTracer::load(path).size() << " events into " << path << std::endl;
+    }
+
+    template <typename SegmentManagerType, typename Factory>
+    void replayAgainst(const Options& options, const ReplayTrace& trace, const std::string& managerName,
+                       Factory makeManager, std::ostream& out)
+    {
+        if (!isSelected(options.managers, managerName))
+        {
+            return;
+        }
+        ReplayResult result = Replayer<SegmentManagerType>(trace, options.samplesNum).run(managerName, makeManager);
+        writeJsonLine(out, result);
+        out.flush();
+        writeSummaryLine(std::cerr, result);
+    }
+
+    void replayAgainstAll(const Options& options, const ReplayTrace& trace, std::vector<char>& segment,
+                          std::ostream& out)
+    {
+        char* seg = segment.data();
+        size_t size = segment.size();
+        replayAgainst<SimpleSegmentManager>(options, trace, "SimpleSegmentManager", [=]() {
+            return std::make_unique<SimpleSegmentManager>(seg, size);
+        }, out);
+        replayAgainst<DummySegmentManager>(options, trace, "DummySegmentManager", [=]() {
+            return std::make_unique<DummySegmentManager>(seg, size, false);
+        }, out);
+        replayAgainst<ThreadCacheSegmentManager>(options, trace, "ThreadCacheSegmentManager", [=]() {
+            return std::make_unique<ThreadCacheSegmentManager>(seg, size);
+        }, out);
+        replayAgainst<SmallObjectSegmentManager>(options, trace, "SmallObjectSegmentManager", [=]() {
+            return std::make_unique<SmallObjectSegmentManager>(seg, size);
+        }, out);
+        replayAgainst<SlabSegmentManager>(options, trace, "SlabSegmentManager", [=]() {
+            return std::make_unique<SlabSegmentManager>(seg, size);
+        }, out);
+        replayAgainst<FixedBlockSegmentManager<FIXED_BLOCK_SZ>>(options, trace, "FixedBlockSegmentManager", [=]() {
+            return std::make_unique<FixedBlockSegmentManager<FIXED_BLOCK_SZ>>(seg, size);
+        }, out);
+        replayAgainst<MonotonicArenaSegmentManager>(options, trace, "MonotonicArenaSegmentManager", [=]() {
+            return std::make_unique<MonotonicArenaSegmentManager>(seg, size);
+        }, out);
+        replayAgainst<GrowableSegmentManager>(options, trace, "GrowableSegmentManager", [=]() {
+            return std::make_unique<GrowableSegmentManager>(GROWABLE_INITIAL_SZ, size);
+        }, out);
+        replayAgainst<PersistentSegmentManager>(options, trace, "PersistentSegmentManager", [=]() {
+            std::memset(seg, 0, PersistentSegmentManager::HEADER_SIZE); // a fresh heap, not a restored one
+            return std::make_unique<PersistentSegmentManager>(seg, size);
+        }, out);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        Options options = parseOptions(argc, argv);
+        if (!options.recordPath.empty())
+        {
+            runRecordedWorkload(options.recordPath);
+            return 0;
+        }
+
+        std::vector<ReplayTrace> traces;
+        for (const auto& path : options.tracePaths)
+        {
+            traces.push_back(makeReplayTrace(path, AllocTracer::load(path)));
+        }
+        if (isSelected(options.synthetic, "uniform"))
+        {
+            traces.push_back(makeReplayTrace("uniform", makeUniformTrace(options.opsNum, options.threadsNum, options.seed)));
+        }
+        if (isSelected(options.synthetic, "powerlaw"))
+        {
+            traces.push_back(makeReplayTrace("powerlaw", makePowerLawTrace(options.opsNum, options.threadsNum, options.seed)));
+        }
+        if (isSelected(options.synthetic, "prodcons"))
+        {
+            traces.push_back(makeReplayTrace("prodcons",
+                                             makeProducerConsumerTrace(options.opsNum, options.threadsNum, options.seed)));
+        }
+
+        std::ofstream outFile;
+        if (!options.outPath.empty())
+        {
+            outFile.open(options.outPath, std::ios::trunc);
+            if (!outFile)
+            {
+                throw std::runtime_error("Cannot write " + options.outPath);
+            }
+        }
+        std::ostream& out = options.outPath.empty() ? std::cout : outFile;
+
+        std::vector<char> segment(options.segmentBytes); // shared by the runs, so it's paged in once
+        for (const auto& trace : traces)
+        {
+            if (trace.threads.empty())
+            {
+                std::cerr << trace.name << ": nothing to replay" << std::endl;
+                continue;
+            }
+            replayAgainstAll(options, trace, segment, out);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+/**
+ * A heap segment & the segment manager that manages it, to be shared by all benchmark threads.
+ */
+template <typename SegmentManagerType, size_t SEG_SIZE>
+struct SharedSegment
+{
+    std::vector<char> segment = std::vector<char>(SEG_SIZE);
+    SegmentManagerType manager = SegmentManagerType(segment.data(), SEG_SIZE);
+
+    // Thread 0 creates & destroys the instance, all the threads use it between the benchmark's
+    // start/stop barriers
+    static std::unique_ptr<SharedSegment> sInstance;
+};
+
+template <typename SegmentManagerType, size_t SEG_SIZE>
+std::unique_ptr<SharedSegment<SegmentManagerType, SEG_SIZE>> SharedSegment<SegmentManagerType, SEG_SIZE>::sInstance;
@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/AllocationAccounting.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <list>
+#include <memory>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr int NODES_NUM = 100 * 1000;
+}
+
+using namespace mybicycles;
+
+/**
+ * Filling & clearing a std::list whose allocator has the given accounting policy: what the accounting
+ * costs per allocation (with NoAccounting it's to be nothing).
+ */
+template <typename AccountingPolicy>
+static void BM_AccountingListFill(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto manager = makeShared<SmallObjectSegmentManager>(seg.get(), SEG_SIZE);
+    MyAllocatorNonOwning<int, SmallObjectSegmentManager, AccountingPolicy> allocator(manager, AccountingPolicy());
+
+    for (auto _ : state)
+    {
+        std::list<int, MyAllocatorNonOwning<int, SmallObjectSegmentManager, AccountingPolicy>> ints(allocator);
+        for (int i = 0; i < NODES_NUM; i++)
+        {
+            ints.push_back(i);
+        }
+        benchmark::DoNotOptimize(ints.back());
+    }
+    state.SetItemsProcessed(state.iterations() * NODES_NUM);
+}
+
+BENCHMARK_TEMPLATE(BM_AccountingListFill, NoAccounting)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_AccountingListFill, LabelAccounting)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MyAllocatorHandle.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr int KEYS_NUM = 100 * 1000;
+    constexpr int MAPS_NUM = 10 * 1000;
+    constexpr int KEYS_PER_MAP = 8;
+
+    template <template <typename, typename> class Allocator>
+    using IdsMap = std::map<int, int, std::less<int>, Allocator<std::pair<const int, int>, SmallObjectSegmentManager>>;
+
+    std::vector<int> makeKeys(int num)
+    {
+        std::vector<int> keys(num);
+        std::mt19937 rng(42);
+        for (auto& key : keys)
+        {
+            key = static_cast<int>(rng());
+        }
+        return keys;
+    }
+}
+
+using namespace mybicycles;
+
+/**
+ * Inserting KEYS_NUM random keys into a single std::map, then clearing it: the allocator is copied only
+ * when the map is constructed, so that's what the allocators cost when they're used the most.
+ */
+template <template <typename, typename> class Allocator>
+static void BM_HandleMapInsert(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SmallObjectSegmentManager> manager = makeShared<SmallObjectSegmentManager>(seg.get(), SEG_SIZE);
+    Allocator<std::pair<const int, int>, SmallObjectSegmentManager> allocator(manager);
+    const std::vector<int> keys = makeKeys(KEYS_NUM);
+
+    for (auto _ : state)
+    {
+        IdsMap<Allocator> ids(allocator);
+        for (int key : keys)
+        {
+            ids.emplace(key, key);
+        }
+        benchmark::DoNotOptimize(ids.size());
+    }
+    state.SetItemsProcessed(state.iterations() * KEYS_NUM);
+}
+
+/**
+ * Many small maps built, swapped & moved around, as in a table of per-object maps: each map construction,
+ * swap & move copies the allocator.
+ */
+template <template <typename, typename> class Allocator>
+static void BM_HandleManySmallMaps(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SmallObjectSegmentManager> manager = makeShared<SmallObjectSegmentManager>(seg.get(), SEG_SIZE);
+    Allocator<std::pair<const int, int>, SmallObjectSegmentManager> allocator(manager);
+    const std::vector<int> keys = makeKeys(KEYS_PER_MAP);
+
+    for (auto _ : state)
+    {
+        std::vector<IdsMap<Allocator>> table;
+        table.reserve(MAPS_NUM);
+        for (int i = 0; i < MAPS_NUM; i++)
+        {
+            IdsMap<Allocator> ids(allocator);
+            for (int key : keys)
+            {
+                ids.emplace(key, i);
+            }
+            IdsMap<Allocator> other(allocator);
+            other.swap(ids);
+            table.push_back(std::move(other));
+        }
+        benchmark::DoNotOptimize(table.data());
+    }
+    state.SetItemsProcessed(state.iterations() * MAPS_NUM * KEYS_PER_MAP);
+}
+
+BENCHMARK_TEMPLATE(BM_HandleMapInsert, MyAllocatorNonOwning)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HandleMapInsert, MyAllocatorHandle)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HandleManySmallMaps, MyAllocatorNonOwning)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HandleManySmallMaps, MyAllocatorHandle)->Unit(benchmark::kMillisecond);
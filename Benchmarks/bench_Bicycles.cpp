@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include "BasicBicycle.hpp"
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyAllocatorHandle.hpp"
+#include "MemoryManagement/MyScopedAllocator.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 512 * 1024 * 1024;
+    constexpr int BICYCLES_NUM = 1000 * 1000;
+
+    // Some of them beyond the small string buffer
+    const char* VENDORS[] = {"Bianchi", "Cannondale", "Giant", "Trek", "Fuji Bikes", "Santa Cruz Bicycles",
+                             "Specialized Bicycles", "Pinarello"};
+
+    std::vector<int> makeVendorIndices()
+    {
+        std::vector<int> indices(BICYCLES_NUM);
+        std::mt19937 rng(42);
+        for (auto& index : indices)
+        {
+            index = static_cast<int>(rng() % std::size(VENDORS));
+        }
+        return indices;
+    }
+}
+
+using namespace mybicycles;
+
+using SegmentBike = AllocBicycle<MyScopedAllocator<char, SmallObjectSegmentManager, MyAllocatorHandle>>;
+using SegmentBikes = std::vector<SegmentBike, MyScopedAllocator<SegmentBike, SmallObjectSegmentManager, MyAllocatorHandle>>;
+
+/**
+ * Growing a vector to BICYCLES_NUM bicycles without reserving (so all of them are moved ~20 times),
+ * then sorting it by vendor.
+ */
+template <typename Bicycles>
+static void runGrowAndSort(benchmark::State& state, const typename Bicycles::allocator_type& allocator)
+{
+    const std::vector<int> vendorIndices = makeVendorIndices();
+    for (auto _ : state)
+    {
+        Bicycles bicycles(allocator);
+        for (int i = 0; i < BICYCLES_NUM; i++)
+        {
+            bicycles.emplace_back(VENDORS[vendorIndices[i]], i, i);
+        }
+        std::sort(bicycles.begin(), bicycles.end());
+        benchmark::DoNotOptimize(bicycles.data());
+    }
+    state.SetItemsProcessed(state.iterations() * BICYCLES_NUM);
+}
+
+static void BM_BicyclesImplHeap(benchmark::State& state)
+{
+    runGrowAndSort<std::vector<BicycleImpl>>(state, {});
+}
+
+static void BM_BicyclesInlineHeap(benchmark::State& state)
+{
+    runGrowAndSort<std::vector<InlineBicycle>>(state, {});
+}
+
+static void BM_BicyclesInlineSegment(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SmallObjectSegmentManager manager(seg.get(), SEG_SIZE);
+    runGrowAndSort<std::vector<InlineBicycle, MyAllocatorHandle<InlineBicycle, SmallObjectSegmentManager>>>(
+                state, MyAllocatorHandle<InlineBicycle, SmallObjectSegmentManager>(&manager));
+}
+
+static void BM_BicyclesAllocSegment(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SmallObjectSegmentManager manager(seg.get(), SEG_SIZE);
+    runGrowAndSort<SegmentBikes>(state, SegmentBikes::allocator_type(
+                                            MyAllocatorHandle<SegmentBike, SmallObjectSegmentManager>(&manager)));
+}
+
+BENCHMARK(BM_BicyclesImplHeap)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BicyclesInlineHeap)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BicyclesInlineSegment)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BicyclesAllocSegment)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "Containers/BulkInsert.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 256 * 1024 * 1024;
+    constexpr int ELEMENTS_NUM = 1000 * 1000;
+
+    using BicyclesList = std::list<mybicycles::BicycleImpl,
+                                   mybicycles::MyAllocatorNonOwning<mybicycles::BicycleImpl, SimpleSegmentManager>>;
+    using IdsMap = std::map<int, int, std::less<int>,
+                            mybicycles::MyAllocatorNonOwning<std::pair<const int, int>, SimpleSegmentManager>>;
+
+    std::vector<mybicycles::BicycleImpl> makeSource(BicyclesList*)
+    {
+        return std::vector<mybicycles::BicycleImpl>(ELEMENTS_NUM, mybicycles::BicycleImpl("Bicycle", 50, 60));
+    }
+
+    std::vector<std::pair<const int, int>> makeSource(IdsMap*)
+    {
+        std::vector<std::pair<const int, int>> source;
+        source.reserve(ELEMENTS_NUM);
+        for (int i = 0; i < ELEMENTS_NUM; i++)
+        {
+            source.emplace_back(i, i);
+        }
+        return source;
+    }
+}
+
+using namespace mybicycles;
+
+/**
+ * Loading 1M elements into a node container: one allocation (and lock acquisition) per node
+ * vs a single batch for them all. Clearing is measured separately, in the same two ways.
+ */
+template <typename Container, bool BULK>
+static void BM_BulkLoad(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SimpleSegmentManager> manager = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    typename Container::allocator_type myal(manager);
+    const auto source = makeSource(static_cast<Container*>(nullptr));
+
+    for (auto _ : state)
+    {
+        Container container(myal);
+        if (BULK)
+        {
+            bulkInsert(container, source.begin(), source.end());
+        }
+        else
+        {
+            for (const auto& element : source)
+            {
+                container.insert(container.end(), element);
+            }
+        }
+        state.PauseTiming();
+        bulkClear(container);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENTS_NUM);
+}
+
+template <typename Container, bool BULK>
+static void BM_BulkClear(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SimpleSegmentManager> manager = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    typename Container::allocator_type myal(manager);
+    const auto source = makeSource(static_cast<Container*>(nullptr));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Container container(myal);
+        bulkInsert(container, source.begin(), source.end());
+        state.ResumeTiming();
+        if (BULK)
+        {
+            bulkClear(container);
+        }
+        else
+        {
+            container.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENTS_NUM);
+}
+
+BENCHMARK_TEMPLATE(BM_BulkLoad, BicyclesList, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkLoad, BicyclesList, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkLoad, IdsMap, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkLoad, IdsMap, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkClear, BicyclesList, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkClear, BicyclesList, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkClear, IdsMap, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BulkClear, IdsMap, true)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "Containers/ExpandableVector.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <vector>
+
+using namespace mybicycles;
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+
+    using MyBicyclesAllocator = MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager>;
+    using StdBicyclesVector = std::vector<BicycleImpl, MyBicyclesAllocator>;
+    using ExpandableBicyclesVector = ExpandableVector<BicycleImpl, MyBicyclesAllocator>;
+}
+
+/**
+ * Appends state.range(0) bicycles to a single vector: the memory after its buffer is always free.
+ */
+template <typename Vector>
+static void BM_AppendBicycles(benchmark::State& state)
+{
+    std::vector<char> seg(SEG_SIZE);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), SEG_SIZE);
+    MyBicyclesAllocator myal(ssm);
+    const BicycleImpl bike("Bicycle");
+
+    for (auto _ : state)
+    {
+        Vector vec(myal);
+        for (int64_t i = 0; i < state.range(0); i++)
+        {
+            vec.push_back(bike);
+        }
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Appends to two vectors in turn, so they get in the way of each other's in-place growth.
+ */
+template <typename Vector>
+static void BM_AppendBicyclesInterleaved(benchmark::State& state)
+{
+    std::vector<char> seg(SEG_SIZE);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), SEG_SIZE);
+    MyBicyclesAllocator myal(ssm);
+    const BicycleImpl bike("Bicycle");
+
+    for (auto _ : state)
+    {
+        Vector vec1(myal);
+        Vector vec2(myal);
+        for (int64_t i = 0; i < state.range(0); i++)
+        {
+            vec1.push_back(bike);
+            vec2.push_back(bike);
+        }
+        benchmark::DoNotOptimize(vec1.data());
+        benchmark::DoNotOptimize(vec2.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+BENCHMARK_TEMPLATE(BM_AppendBicycles, StdBicyclesVector)->Range(64, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_AppendBicycles, ExpandableBicyclesVector)->Range(64, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_AppendBicyclesInterleaved, StdBicyclesVector)->Range(64, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_AppendBicyclesInterleaved, ExpandableBicyclesVector)->Range(64, 64 * 1024);
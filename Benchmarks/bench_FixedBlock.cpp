@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include "SharedSegment.hpp"
+#include "MemoryManagement/FixedBlockSegmentManager.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 16 * 1024 * 1024;
+    constexpr size_t NODE_SZ = 64; // e.g. a std::list node of BicycleImpl
+    constexpr size_t BLOCKS_PER_ITERATION = 16; // alloc/free pairs per thread per iteration
+}
+
+/**
+ * Every thread allocates a handful of equally sized nodes and frees them again,
+ * all threads contending on one segment manager.
+ */
+template <typename SegmentManagerType>
+static void BM_FixedSizeAllocFree(benchmark::State& state)
+{
+    using Segment = SharedSegment<SegmentManagerType, SEG_SIZE>;
+    if (0 == state.thread_index())
+    {
+        Segment::sInstance = std::make_unique<Segment>();
+    }
+
+    void* blocks[BLOCKS_PER_ITERATION];
+    for (auto _ : state)
+    {
+        SegmentManagerType& manager = Segment::sInstance->manager;
+        for (size_t i = 0; i < BLOCKS_PER_ITERATION; i++)
+        {
+            blocks[i] = manager.alloc(NODE_SZ);
+            benchmark::DoNotOptimize(blocks[i]);
+        }
+        for (size_t i = 0; i < BLOCKS_PER_ITERATION; i++)
+        {
+            manager.free(blocks[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCKS_PER_ITERATION);
+
+    if (0 == state.thread_index())
+    {
+        Segment::sInstance.reset();
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_FixedSizeAllocFree, SimpleSegmentManager)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FixedSizeAllocFree, FixedBlockSegmentManager<NODE_SZ>)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/HeapProfiler.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <list>
+#include <memory>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr int LIVE_NUM = 64 * 1024;
+    constexpr int OPS_NUM = 1000 * 1000;
+
+    using BicyclesList = std::list<mybicycles::BicycleImpl,
+                                   mybicycles::MyAllocatorNonOwning<mybicycles::BicycleImpl, SmallObjectSegmentManager>>;
+}
+
+using namespace mybicycles;
+
+/**
+ * A FIFO of bicycles churning through a fast segment manager, with the heap profiler off (0)
+ * or sampling at the default interval (1).
+ */
+static void BM_HeapProfilerOverhead(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SmallObjectSegmentManager> manager = makeShared<SmallObjectSegmentManager>(seg.get(), SEG_SIZE);
+    BicyclesList bicycles(manager);
+    for (int i = 0; i < LIVE_NUM; i++)
+    {
+        bicycles.emplace_back("Bicycle", i, i);
+    }
+
+    HeapProfiler& profiler = HeapProfiler::instance();
+    profiler.clear();
+    if (state.range(0) != 0)
+    {
+        profiler.start();
+    }
+    for (auto _ : state)
+    {
+        for (int i = 0; i < OPS_NUM; i++)
+        {
+            bicycles.emplace_back("Bicycle", i, i);
+            bicycles.pop_front();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPS_NUM);
+    state.counters["sites"] = static_cast<double>(profiler.getSites().size());
+    profiler.stop();
+    bicycles.clear();
+    profiler.clear();
+}
+
+BENCHMARK(BM_HeapProfilerOverhead)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/HugePageSegment.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 256 * 1024 * 1024;
+    constexpr size_t RECORD_SZ = 64;
+
+    struct Record
+    {
+        Record* next;
+        uint64_t payload[RECORD_SZ / sizeof(uint64_t) - 1];
+    };
+
+    const char* pageModeName(HugePageSegment::PageMode mode)
+    {
+        switch (mode)
+        {
+        case HugePageSegment::PageMode::Regular: return "regular pages";
+        case HugePageSegment::PageMode::Transparent: return "transparent huge pages";
+        case HugePageSegment::PageMode::Explicit: return "explicit huge pages";
+        }
+        return "";
+    }
+
+    // Fills the segment with records linked in a random order, so walking them defeats caches & TLB alike
+    Record* buildRandomChain(SimpleSegmentManager& manager, size_t recordsNum)
+    {
+        std::vector<Record*> records(recordsNum);
+        for (auto& record : records)
+        {
+            record = static_cast<Record*>(manager.alloc(sizeof(Record)));
+        }
+        std::shuffle(records.begin(), records.end(), std::mt19937_64(42));
+        for (size_t i = 0; i + 1 < recordsNum; i++)
+        {
+            records[i]->next = records[i + 1];
+        }
+        records.back()->next = nullptr;
+        return records.front();
+    }
+}
+
+/**
+ * The first touch of every page of a fresh segment, as a request handler allocating from it would do.
+ */
+static void BM_SegmentFirstTouch(benchmark::State& state, HugePageSegment::PageMode mode, bool prefault)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto seg = std::make_unique<HugePageSegment>(SEG_SIZE, mode, prefault);
+        state.SetLabel(pageModeName(seg->getPageMode()));
+        state.ResumeTiming();
+
+        for (size_t offset = 0; offset < seg->size(); offset += 4096)
+        {
+            seg->data()[offset] = 1;
+        }
+        benchmark::ClobberMemory();
+
+        state.PauseTiming();
+        seg.reset(); // unmapping isn't what we measure
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(state.iterations() * SEG_SIZE);
+}
+
+/**
+ * Pointer chasing through records spread over the whole segment.
+ */
+static void BM_SegmentRandomAccess(benchmark::State& state, HugePageSegment::PageMode mode)
+{
+    HugePageSegment seg(SEG_SIZE, mode, true);
+    SimpleSegmentManager manager(seg.data(), seg.size());
+    const size_t recordsNum = SEG_SIZE / (RECORD_SZ + SimpleSegmentManager::BLOCK_OVERHEAD) - 1;
+    Record* head = buildRandomChain(manager, recordsNum);
+    state.SetLabel(pageModeName(seg.getPageMode()));
+
+    const size_t stepsPerIteration = 1024 * 1024;
+    Record* curr = head;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < stepsPerIteration; i++)
+        {
+            curr = curr->next != nullptr ? curr->next : head;
+        }
+        benchmark::DoNotOptimize(curr);
+    }
+    state.SetItemsProcessed(state.iterations() * stepsPerIteration);
+}
+
+BENCHMARK_CAPTURE(BM_SegmentFirstTouch, Regular, HugePageSegment::PageMode::Regular, false)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SegmentFirstTouch, Regular_Prefaulted, HugePageSegment::PageMode::Regular, true)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SegmentFirstTouch, Transparent, HugePageSegment::PageMode::Transparent, false)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SegmentFirstTouch, Explicit, HugePageSegment::PageMode::Explicit, false)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_SegmentRandomAccess, Regular, HugePageSegment::PageMode::Regular)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SegmentRandomAccess, Transparent, HugePageSegment::PageMode::Transparent)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SegmentRandomAccess, Explicit, HugePageSegment::PageMode::Explicit)
+    ->Unit(benchmark::kMillisecond);
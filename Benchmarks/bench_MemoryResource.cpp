@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SegmentMemoryResource.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <list>
+#include <memory>
+#include <memory_resource>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr int NODES_NUM = 100 * 1000;
+}
+
+using namespace mybicycles;
+
+/**
+ * Filling a std::list through MyAllocatorNonOwning: the segment manager's alloc/free are called directly
+ * (and may be inlined).
+ */
+template <typename SegmentManagerType>
+static void BM_ResourceListTemplated(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto manager = makeShared<SegmentManagerType>(seg.get(), SEG_SIZE);
+    MyAllocatorNonOwning<int, SegmentManagerType> allocator(manager);
+
+    for (auto _ : state)
+    {
+        std::list<int, MyAllocatorNonOwning<int, SegmentManagerType>> ints(allocator);
+        for (int i = 0; i < NODES_NUM; i++)
+        {
+            ints.push_back(i);
+        }
+        benchmark::DoNotOptimize(ints.back());
+    }
+    state.SetItemsProcessed(state.iterations() * NODES_NUM);
+}
+
+/**
+ * The same through std::pmr::list & SegmentMemoryResource: a virtual call per allocation & deallocation.
+ */
+template <typename SegmentManagerType>
+static void BM_ResourceListPmr(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SegmentMemoryResource<SegmentManagerType> resource(makeShared<SegmentManagerType>(seg.get(), SEG_SIZE));
+
+    for (auto _ : state)
+    {
+        std::pmr::list<int> ints(&resource);
+        for (int i = 0; i < NODES_NUM; i++)
+        {
+            ints.push_back(i);
+        }
+        benchmark::DoNotOptimize(ints.back());
+    }
+    state.SetItemsProcessed(state.iterations() * NODES_NUM);
+}
+
+BENCHMARK_TEMPLATE(BM_ResourceListTemplated, SimpleSegmentManager)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ResourceListPmr, SimpleSegmentManager)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ResourceListTemplated, SmallObjectSegmentManager)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ResourceListPmr, SmallObjectSegmentManager)->Unit(benchmark::kMillisecond);
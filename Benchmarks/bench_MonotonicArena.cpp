@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MonotonicArenaSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <list>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 1024 * 1024;
+    constexpr int BICYCLES_PER_REQUEST = 64;
+
+    template <typename SegmentManagerType>
+    void endRequest(SegmentManagerType& manager)
+    {
+        if constexpr (std::is_same<SegmentManagerType, MonotonicArenaSegmentManager>::value)
+        {
+            manager.reset();
+        }
+    }
+}
+
+using namespace mybicycles;
+
+/**
+ * A "request" builds a list of bicycles, uses it and throws everything away.
+ */
+template <typename SegmentManagerType>
+static void BM_RequestScopedList(benchmark::State& state)
+{
+    using MyBicyclesAllocator = MyAllocatorNonOwning<BicycleImpl, SegmentManagerType>;
+
+    std::vector<char> seg(SEG_SIZE);
+    SharedPtr<SegmentManagerType> manager = makeShared<SegmentManagerType>(seg.data(), SEG_SIZE);
+    MyBicyclesAllocator myal(manager);
+
+    for (auto _ : state)
+    {
+        {
+            std::list<BicycleImpl, MyBicyclesAllocator> lst(myal);
+            for (int i = 0; i < BICYCLES_PER_REQUEST; i++)
+            {
+                lst.emplace_back("Bicycle");
+            }
+            benchmark::DoNotOptimize(lst.back());
+        }
+        endRequest(*manager);
+    }
+    state.SetItemsProcessed(state.iterations() * BICYCLES_PER_REQUEST);
+}
+
+/**
+ * Bare allocator cost per request: allocate a number of small blocks, then release them all.
+ */
+template <typename SegmentManagerType>
+static void BM_RequestScopedAllocs(benchmark::State& state)
+{
+    std::vector<char> seg(SEG_SIZE);
+    SegmentManagerType manager(seg.data(), SEG_SIZE);
+    void* blocks[BICYCLES_PER_REQUEST];
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < BICYCLES_PER_REQUEST; i++)
+        {
+            blocks[i] = manager.alloc(64);
+            benchmark::DoNotOptimize(blocks[i]);
+        }
+        for (int i = 0; i < BICYCLES_PER_REQUEST; i++)
+        {
+            manager.free(blocks[i]);
+        }
+        endRequest(manager);
+    }
+    state.SetItemsProcessed(state.iterations() * BICYCLES_PER_REQUEST);
+}
+
+BENCHMARK_TEMPLATE(BM_RequestScopedList, SimpleSegmentManager);
+BENCHMARK_TEMPLATE(BM_RequestScopedList, MonotonicArenaSegmentManager);
+BENCHMARK_TEMPLATE(BM_RequestScopedAllocs, SimpleSegmentManager);
+BENCHMARK_TEMPLATE(BM_RequestScopedAllocs, MonotonicArenaSegmentManager);
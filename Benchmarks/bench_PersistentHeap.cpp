@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MappedFileSegmentManager.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    const char* HEAP_PATH = "bench_PersistentHeap.heap";
+
+    struct Record
+    {
+        uint64_t key;
+        double value;
+    };
+
+    // The table as it comes from the outside world: a text dump to be parsed at every start
+    struct Table
+    {
+        uint64_t recordsNum;
+        Record records[1];
+    };
+
+    std::string makeTextDump(size_t recordsNum)
+    {
+        std::ostringstream text;
+        std::srand(42);
+        for (size_t i = 0; i < recordsNum; i++)
+        {
+            text << std::rand() << ' ' << std::rand() / 1000.0 << '\n';
+        }
+        return text.str();
+    }
+
+    size_t heapSize(size_t recordsNum)
+    {
+        return sizeof(Table) + recordsNum * sizeof(Record) + 1024 * 1024;
+    }
+
+    // Parses & sorts the dump into a table allocated from @manager
+    Table* buildTable(MappedFileSegmentManager& manager, const std::string& text, size_t recordsNum)
+    {
+        Table* table = static_cast<Table*>(manager.alloc(sizeof(Table) + recordsNum * sizeof(Record)));
+        std::istringstream input(text);
+        table->recordsNum = 0;
+        while (table->recordsNum < recordsNum && input >> table->records[table->recordsNum].key
+                                                      >> table->records[table->recordsNum].value)
+        {
+            table->recordsNum++;
+        }
+        std::sort(table->records, table->records + table->recordsNum,
+                  [](const Record& lhs, const Record& rhs) { return lhs.key < rhs.key; });
+        manager.setRoot(table);
+        return table;
+    }
+
+    double sumValues(const Table* table)
+    {
+        double sum = 0;
+        for (uint64_t i = 0; i < table->recordsNum; i++)
+        {
+            sum += table->records[i].value;
+        }
+        return sum;
+    }
+}
+
+/**
+ * Startup the old way: a fresh heap, filled from the text dump.
+ */
+static void BM_Startup_Rebuild(benchmark::State& state)
+{
+    const size_t recordsNum = state.range(0);
+    const std::string text = makeTextDump(recordsNum);
+
+    for (auto _ : state)
+    {
+        std::remove(HEAP_PATH);
+        MappedFileSegmentManager manager(HEAP_PATH, heapSize(recordsNum));
+        Table* table = buildTable(manager, text, recordsNum);
+        benchmark::DoNotOptimize(table->records[recordsNum / 2].key);
+    }
+    std::remove(HEAP_PATH);
+    state.SetItemsProcessed(state.iterations() * recordsNum);
+}
+
+/**
+ * Startup from the heap file left by a previous run; @withScan adds a pass over the whole table,
+ * which pays for faulting in the pages the rebuild would have touched anyway.
+ */
+static void BM_Startup_Reopen(benchmark::State& state, bool withScan)
+{
+    const size_t recordsNum = state.range(0);
+    std::remove(HEAP_PATH);
+    {
+        MappedFileSegmentManager manager(HEAP_PATH, heapSize(recordsNum));
+        buildTable(manager, makeTextDump(recordsNum), recordsNum);
+    }
+
+    for (auto _ : state)
+    {
+        MappedFileSegmentManager manager(HEAP_PATH, heapSize(recordsNum));
+        const Table* table = static_cast<const Table*>(manager.getRoot());
+        benchmark::DoNotOptimize(table->records[recordsNum / 2].key);
+        if (withScan)
+        {
+            benchmark::DoNotOptimize(sumValues(table));
+        }
+    }
+    std::remove(HEAP_PATH);
+    state.SetItemsProcessed(state.iterations() * recordsNum);
+}
+
+BENCHMARK(BM_Startup_Rebuild)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Startup_Reopen, Lookup, false)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Startup_Reopen, Scan, true)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
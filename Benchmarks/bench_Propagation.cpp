@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr int NODES_NUM = 10 * 1000;
+}
+
+using namespace mybicycles;
+
+namespace
+{
+    // MyAllocatorNonOwning as it was before the propagation traits: the allocator stays with the container
+    template <typename T, typename SegmentManagerType>
+    struct NonPropagatingAllocator : MyAllocatorNonOwning<T, SegmentManagerType>
+    {
+        template <typename U>
+        struct rebind
+        {
+            using other = NonPropagatingAllocator<U, SegmentManagerType>;
+        };
+
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+
+        using MyAllocatorNonOwning<T, SegmentManagerType>::MyAllocatorNonOwning;
+
+        template <typename U>
+        NonPropagatingAllocator(const NonPropagatingAllocator<U, SegmentManagerType>& rhs) noexcept :
+            MyAllocatorNonOwning<T, SegmentManagerType>(rhs.getSegmentManager())
+        {
+        }
+    };
+}
+
+/**
+ * Moving a list of NODES_NUM ints back & forth between two containers on different segments: with
+ * propagation the nodes are handed over along with the allocator, otherwise every node is reallocated
+ * in the other segment.
+ */
+template <template <typename, typename> class Allocator>
+static void BM_PropagationMoveAssign(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg1(new char[SEG_SIZE]);
+    std::unique_ptr<char[]> seg2(new char[SEG_SIZE]);
+    Allocator<int, SimpleSegmentManager> allocator1(makeShared<SimpleSegmentManager>(seg1.get(), SEG_SIZE));
+    Allocator<int, SimpleSegmentManager> allocator2(makeShared<SimpleSegmentManager>(seg2.get(), SEG_SIZE));
+
+    std::list<int, Allocator<int, SimpleSegmentManager>> ints1(allocator1);
+    std::list<int, Allocator<int, SimpleSegmentManager>> ints2(allocator2);
+    for (int i = 0; i < NODES_NUM; i++)
+    {
+        ints1.push_back(i);
+    }
+
+    for (auto _ : state)
+    {
+        ints2 = std::move(ints1);
+        ints1 = std::move(ints2);
+        benchmark::DoNotOptimize(ints1.back());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK_TEMPLATE(BM_PropagationMoveAssign, NonPropagatingAllocator);
+BENCHMARK_TEMPLATE(BM_PropagationMoveAssign, MyAllocatorNonOwning);
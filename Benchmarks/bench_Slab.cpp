@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/SlabSegmentManager.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 256 * 1024 * 1024;
+    constexpr size_t OBJECTS_NUM = 16 * 1024; // random frees make SimpleSegmentManager walk its free list
+    constexpr int ELEMENTS_NUM = 256 * 1024;
+    constexpr size_t OTHER_ALLOCS_PER_ELEMENT = 2; // other traffic the list nodes are interleaved with
+
+    template <typename SegmentManagerType>
+    using ListOf = std::list<mybicycles::BicycleImpl, mybicycles::MyAllocatorNonOwning<mybicycles::BicycleImpl, SegmentManagerType>>;
+}
+
+using namespace mybicycles;
+
+/**
+ * Allocates OBJECTS_NUM objects of the same size (state.range(0) bytes), then frees them in random order.
+ */
+template <typename SegmentManagerType>
+static void BM_SlabAllocFree(benchmark::State& state)
+{
+    const size_t objectSize = state.range(0);
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SegmentManagerType manager(seg.get(), SEG_SIZE);
+
+    std::vector<size_t> freeOrder(OBJECTS_NUM);
+    for (size_t i = 0; i < OBJECTS_NUM; i++)
+    {
+        freeOrder[i] = i;
+    }
+    std::shuffle(freeOrder.begin(), freeOrder.end(), std::mt19937(42));
+    std::vector<void*> objects(OBJECTS_NUM);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < OBJECTS_NUM; i++)
+        {
+            objects[i] = manager.alloc(objectSize);
+        }
+        for (size_t i : freeOrder)
+        {
+            manager.free(objects[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OBJECTS_NUM * 2);
+}
+
+/**
+ * Iterating over a list whose nodes were allocated among other (differently sized) blocks from the same
+ * segment manager: with slabs, the nodes stay packed together anyway.
+ */
+template <typename SegmentManagerType>
+static void BM_SlabIterationLocality(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SegmentManagerType> manager = makeShared<SegmentManagerType>(seg.get(), SEG_SIZE);
+    ListOf<SegmentManagerType> bicycles(manager);
+
+    std::mt19937 rng(42);
+    std::vector<void*> others;
+    for (int i = 0; i < ELEMENTS_NUM; i++)
+    {
+        bicycles.emplace_back("Bicycle", i % 100, i % 100);
+        for (size_t j = 0; j < OTHER_ALLOCS_PER_ELEMENT; j++)
+        {
+            others.push_back(manager->alloc(16 + rng() % 200));
+        }
+    }
+
+    for (auto _ : state)
+    {
+        long pressure = 0;
+        for (const auto& bicycle : bicycles)
+        {
+            pressure += bicycle.getPressureFront();
+        }
+        benchmark::DoNotOptimize(pressure);
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENTS_NUM);
+
+    // Backwards, so that SimpleSegmentManager finds each block's place in its free list right away
+    for (auto it = others.rbegin(); it != others.rend(); ++it)
+    {
+        manager->free(*it);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_SlabAllocFree, SimpleSegmentManager)->Arg(48)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SlabAllocFree, SmallObjectSegmentManager)->Arg(48)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SlabAllocFree, SlabSegmentManager)->Arg(48)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SlabIterationLocality, SimpleSegmentManager)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SlabIterationLocality, SmallObjectSegmentManager)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_SlabIterationLocality, SlabSegmentManager)->Unit(benchmark::kMicrosecond);
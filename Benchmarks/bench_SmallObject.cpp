@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <list>
+#include <map>
+#include <memory>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 512 * 1024 * 1024;
+    constexpr int ELEMENTS_NUM = 1000 * 1000;
+
+    template <typename SegmentManagerType>
+    using ListOf = std::list<mybicycles::BicycleImpl, mybicycles::MyAllocatorNonOwning<mybicycles::BicycleImpl, SegmentManagerType>>;
+
+    template <typename SegmentManagerType>
+    using MapOf = std::map<int, mybicycles::BicycleImpl, std::less<int>,
+                           mybicycles::MyAllocatorNonOwning<std::pair<const int, mybicycles::BicycleImpl>, SegmentManagerType>>;
+
+    template <typename SegmentManagerType>
+    void insert(ListOf<SegmentManagerType>& lst, int i)
+    {
+        lst.emplace_back("Bicycle", i % 100, i % 100);
+    }
+
+    template <typename SegmentManagerType>
+    void insert(MapOf<SegmentManagerType>& mp, int i)
+    {
+        mp.emplace(i, mybicycles::BicycleImpl("Bicycle", i % 100, i % 100));
+    }
+}
+
+using namespace mybicycles;
+
+/**
+ * Memory taken by a container of 1M bicycles: bytes_per_element is the segment's occupancy growth
+ * divided by the number of elements, bookkeeping of the segment manager included.
+ */
+template <template <typename> class Container, typename SegmentManagerType>
+static void BM_ContainerFootprint(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SharedPtr<SegmentManagerType> manager = makeShared<SegmentManagerType>(seg.get(), SEG_SIZE);
+    MyAllocatorNonOwning<BicycleImpl, SegmentManagerType> myal(manager);
+    const size_t occupiedBefore = manager->getStats().occupiedBytes;
+
+    size_t footprint = 0;
+    for (auto _ : state)
+    {
+        Container<SegmentManagerType> container(myal);
+        for (int i = 0; i < ELEMENTS_NUM; i++)
+        {
+            insert<SegmentManagerType>(container, i);
+        }
+        state.PauseTiming();
+        footprint = manager->getStats().occupiedBytes - occupiedBefore;
+        state.ResumeTiming();
+    }
+    state.counters["bytes_per_element"] = static_cast<double>(footprint) / ELEMENTS_NUM;
+    state.SetItemsProcessed(state.iterations() * ELEMENTS_NUM);
+}
+
+BENCHMARK_TEMPLATE(BM_ContainerFootprint, ListOf, SimpleSegmentManager)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_TEMPLATE(BM_ContainerFootprint, ListOf, SmallObjectSegmentManager)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_TEMPLATE(BM_ContainerFootprint, MapOf, SimpleSegmentManager)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_TEMPLATE(BM_ContainerFootprint, MapOf, SmallObjectSegmentManager)->Unit(benchmark::kMillisecond)->Iterations(3);
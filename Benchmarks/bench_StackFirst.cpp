@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MyAllocatorOnStack.hpp"
+
+#include <vector>
+
+namespace
+{
+    constexpr int VECTORS_NUM = 10 * 1000;
+    constexpr int SMALL_SIZE = 12;
+    constexpr int LARGE_SIZE = 2000;
+    constexpr int LARGE_EVERY = 64; // one vector in LARGE_EVERY outgrows the stack segment
+    constexpr size_t STACK_SEG_SIZE = 256;
+
+    int elementsOf(int vectorIndex)
+    {
+        return vectorIndex % LARGE_EVERY == 0 ? LARGE_SIZE : SMALL_SIZE;
+    }
+}
+
+using namespace mybicycles;
+
+/**
+ * Short-lived vectors which are small but now & then large, summed up: on the heap vs stack-first.
+ */
+static void BM_StackFirstVectors_Heap(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        long sum = 0;
+        for (int v = 0; v < VECTORS_NUM; v++)
+        {
+            std::vector<int> ids;
+            for (int i = 0; i < elementsOf(v); i++)
+            {
+                ids.push_back(i);
+            }
+            sum += ids.back();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * VECTORS_NUM);
+}
+
+static void BM_StackFirstVectors_StackFirst(benchmark::State& state)
+{
+    using Allocator = MyAllocatorStackFirst<int, STACK_SEG_SIZE>;
+    for (auto _ : state)
+    {
+        long sum = 0;
+        for (int v = 0; v < VECTORS_NUM; v++)
+        {
+            Allocator allocator;
+            std::vector<int, Allocator> ids(allocator);
+            for (int i = 0; i < elementsOf(v); i++)
+            {
+                ids.push_back(i);
+            }
+            sum += ids.back();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * VECTORS_NUM);
+}
+
+BENCHMARK(BM_StackFirstVectors_Heap)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StackFirstVectors_StackFirst)->Unit(benchmark::kMillisecond);
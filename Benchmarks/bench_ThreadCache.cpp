@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+
+#include "SharedSegment.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/ThreadCacheSegmentManager.hpp"
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024 * 1024;
+    constexpr size_t BLOCKS_PER_ITERATION = 16; // alloc/free pairs per thread per iteration
+}
+
+/**
+ * Every thread allocates a handful of small blocks of mixed sizes and frees them again,
+ * all threads sharing one segment manager.
+ */
+template <typename SegmentManagerType>
+static void BM_AllocFreePairs(benchmark::State& state)
+{
+    using Segment = SharedSegment<SegmentManagerType, SEG_SIZE>;
+    if (0 == state.thread_index())
+    {
+        Segment::sInstance = std::make_unique<Segment>();
+    }
+
+    void* blocks[BLOCKS_PER_ITERATION];
+    for (auto _ : state)
+    {
+        SegmentManagerType& manager = Segment::sInstance->manager;
+        for (size_t i = 0; i < BLOCKS_PER_ITERATION; i++)
+        {
+            blocks[i] = manager.alloc(16 + (i % 4) * 16);
+            benchmark::DoNotOptimize(blocks[i]);
+        }
+        for (size_t i = 0; i < BLOCKS_PER_ITERATION; i++)
+        {
+            manager.free(blocks[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCKS_PER_ITERATION);
+
+    if (0 == state.thread_index())
+    {
+        Segment::sInstance.reset();
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_AllocFreePairs, SimpleSegmentManager)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AllocFreePairs, ThreadCacheSegmentManager)->ThreadRange(1, 32)->UseRealTime();
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+namespace
+{
+    constexpr size_t SEG_SIZE = 64 * 1024;
+    constexpr size_t BLOCK_INTS = 16;
+}
+
+using namespace mybicycles;
+
+namespace
+{
+    // An allocator of a segment which is full: every allocation fails
+    struct ExhaustedSegment
+    {
+        std::unique_ptr<char[]> seg{new char[SEG_SIZE]};
+        MyAllocatorNonOwning<int> allocator{makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE)};
+
+        ExhaustedSegment()
+        {
+            while (allocator.tryAllocate(BLOCK_INTS))
+            {
+            }
+        }
+    };
+}
+
+/**
+ * The exhaustion path: a caller which copes with the lack of memory (e.g. drops the message) catches
+ * what allocate() throws, or checks what tryAllocate() returns.
+ */
+static void BM_ExhaustedAllocateCatch(benchmark::State& state)
+{
+    ExhaustedSegment exhausted;
+    for (auto _ : state)
+    {
+        int* mem = nullptr;
+        try
+        {
+            mem = exhausted.allocator.allocate(BLOCK_INTS);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        benchmark::DoNotOptimize(mem);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ExhaustedTryAllocate(benchmark::State& state)
+{
+    ExhaustedSegment exhausted;
+    for (auto _ : state)
+    {
+        AllocResult<int> result = exhausted.allocator.tryAllocate(BLOCK_INTS);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Freeing pointers of nobody's
+static void BM_InvalidFreeCatch(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SimpleSegmentManager manager(seg.get(), SEG_SIZE);
+    char foreign[64];
+    for (auto _ : state)
+    {
+        bool freed = true;
+        try
+        {
+            manager.free(foreign + 16);
+        }
+        catch (const std::runtime_error&)
+        {
+            freed = false;
+        }
+        benchmark::DoNotOptimize(freed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_InvalidTryFree(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SimpleSegmentManager manager(seg.get(), SEG_SIZE);
+    char foreign[64];
+    for (auto _ : state)
+    {
+        AllocError error = manager.tryFree(foreign + 16);
+        benchmark::DoNotOptimize(error);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The successful path, which both share
+template <bool TRY>
+static void BM_AllocateDeallocate(benchmark::State& state)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    MyAllocatorNonOwning<int> allocator(makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE));
+    for (auto _ : state)
+    {
+        if constexpr (TRY)
+        {
+            AllocResult<int> result = allocator.tryAllocate(BLOCK_INTS);
+            benchmark::DoNotOptimize(result);
+            allocator.tryDeallocate(result.ptr, BLOCK_INTS);
+        }
+        else
+        {
+            int* mem = allocator.allocate(BLOCK_INTS);
+            benchmark::DoNotOptimize(mem);
+            allocator.deallocate(mem, BLOCK_INTS);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ExhaustedAllocateCatch);
+BENCHMARK(BM_ExhaustedTryAllocate);
+BENCHMARK(BM_InvalidFreeCatch);
+BENCHMARK(BM_InvalidTryFree);
+BENCHMARK_TEMPLATE(BM_AllocateDeallocate, false);
+BENCHMARK_TEMPLATE(BM_AllocateDeallocate, true);
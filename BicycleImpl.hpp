@@ -66,8 +66,8 @@ public:
         return *this;
     }
 
-    BicycleImpl(BicycleImpl&& rhs) :
-        mVendor(rhs.mVendor),
+    BicycleImpl(BicycleImpl&& rhs) noexcept :
+        mVendor(std::move(rhs.mVendor)),
         mFrontTyre(rhs.mFrontTyre),
         mRearTyre(rhs.mRearTyre),
         mDebugLogsEnabled(rhs.mDebugLogsEnabled)
@@ -75,7 +75,7 @@ public:
         rhs.reset();
     }
 
-    BicycleImpl& operator=(BicycleImpl&& rhs)
+    BicycleImpl& operator=(BicycleImpl&& rhs) noexcept
     {
         if (mDebugLogsEnabled)
         {
@@ -84,7 +84,7 @@ public:
 
         if (this != &rhs)
         {
-            mVendor = rhs.mVendor;
+            mVendor = std::move(rhs.mVendor);
             mFrontTyre = rhs.mFrontTyre;
             mRearTyre = rhs.mRearTyre;
             mDebugLogsEnabled = rhs.mDebugLogsEnabled;
@@ -133,9 +133,9 @@ protected:
     bool mDebugLogsEnabled;
 
 private:
-    void reset()
+    void reset() noexcept
     {
-        mVendor = "";
+        mVendor.clear();
         mFrontTyre.pressure = 0;
         mRearTyre.pressure = 0;
         mDebugLogsEnabled = false;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "MemoryManagement/BulkAllocationScope.hpp"
+
+#include <iterator>
+
+namespace mybicycles
+{
+
+/**
+ * Inserts [@first, @last) at the end of a node container (std::list, std::map, std::set, ...) which uses
+ * a MyAllocator* allocator, getting all the nodes from the segment manager in one batch (if it supports
+ * batches: see BulkAllocationScope). The nodes come out adjacent in memory, in insertion order.
+ */
+template <typename Container, typename ForwardIt>
+void bulkInsert(Container& container, ForwardIt first, ForwardIt last)
+{
+    using SegmentManagerType = typename Container::allocator_type::segment_manager_type;
+    auto manager = container.get_allocator().getSegmentManager();
+    if constexpr (HasBatchAlloc<SegmentManagerType>::value)
+    {
+        if (manager)
+        {
+            BulkAllocationScope<SegmentManagerType> scope(*manager, std::distance(first, last));
+            for (; first != last; ++first)
+            {
+                container.insert(container.end(), *first);
+            }
+            return;
+        }
+    }
+    for (; first != last; ++first)
+    {
+        container.insert(container.end(), *first);
+    }
+}
+
+/**
+ * Clears a node container, handing all its nodes back to the segment manager in one batch.
+ */
+template <typename Container>
+void bulkClear(Container& container)
+{
+    using SegmentManagerType = typename Container::allocator_type::segment_manager_type;
+    auto manager = container.get_allocator().getSegmentManager();
+    if constexpr (HasBatchAlloc<SegmentManagerType>::value)
+    {
+        if (manager)
+        {
+            BulkAllocationScope<SegmentManagerType> scope(*manager, 0);
+            container.clear();
+            return;
+        }
+    }
+    container.clear();
+}
+
+} // mybicycles
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace mybicycles
+{
+
+/**
+ * A simplified std::vector which tries to grow its buffer in place first. When the memory right after
+ * the buffer is free, growth costs neither a new allocation nor moving the elements over; only
+ * otherwise the usual allocate-move-deallocate sequence takes place.
+ *
+ * @Allocator must provide tryExpand(T*, oldN, newN) and shrink(T*, oldN, newN) on top of the usual
+ * allocator requirements, as the MyAllocator* family does.
+ */
+template <typename T, typename Allocator>
+class ExpandableVector
+{
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using allocator_type = Allocator;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    explicit ExpandableVector(const Allocator& allocator) :
+        mAllocator(allocator),
+        mData(nullptr),
+        mSize(0),
+        mCapacity(0)
+    {
+    }
+
+    ExpandableVector(const ExpandableVector& rhs) :
+        ExpandableVector(AllocTraits::select_on_container_copy_construction(rhs.mAllocator))
+    {
+        reserve(rhs.mSize);
+        for (const T& item : rhs)
+        {
+            push_back(item);
+        }
+    }
+
+    ExpandableVector(ExpandableVector&& rhs) noexcept :
+        mAllocator(rhs.mAllocator),
+        mData(rhs.mData),
+        mSize(rhs.mSize),
+        mCapacity(rhs.mCapacity)
+    {
+        rhs.mData = nullptr;
+        rhs.mSize = 0;
+        rhs.mCapacity = 0;
+    }
+
+    ExpandableVector& operator=(ExpandableVector rhs) noexcept
+    {
+        // Copy-and-swap; the allocators are swapped along with the buffers
+        std::swap(mAllocator, rhs.mAllocator);
+        std::swap(mData, rhs.mData);
+        std::swap(mSize, rhs.mSize);
+        std::swap(mCapacity, rhs.mCapacity);
+        return *this;
+    }
+
+    ~ExpandableVector()
+    {
+        clear();
+        if (mData != nullptr)
+        {
+            AllocTraits::deallocate(mAllocator, mData, mCapacity);
+        }
+    }
+
+    void push_back(const T& item)
+    {
+        emplace_back(item);
+    }
+
+    void push_back(T&& item)
+    {
+        emplace_back(std::move(item));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (mSize == mCapacity)
+        {
+            return growAndEmplaceBack(std::forward<Args>(args)...);
+        }
+        AllocTraits::construct(mAllocator, mData + mSize, std::forward<Args>(args)...);
+        return mData[mSize++];
+    }
+
+    void pop_back()
+    {
+        AllocTraits::destroy(mAllocator, mData + --mSize);
+    }
+
+    void clear() noexcept
+    {
+        while (mSize > 0)
+        {
+            pop_back();
+        }
+    }
+
+    void reserve(size_t newCapacity)
+    {
+        if (newCapacity <= mCapacity)
+        {
+            return;
+        }
+        if (mData != nullptr && mAllocator.tryExpand(mData, mCapacity, newCapacity))
+        {
+            mCapacity = newCapacity;
+            return;
+        }
+
+        T* newData = AllocTraits::allocate(mAllocator, newCapacity);
+        try
+        {
+            moveElementsTo(newData);
+        }
+        catch (...)
+        {
+            AllocTraits::deallocate(mAllocator, newData, newCapacity);
+            throw;
+        }
+        adopt(newData, newCapacity);
+    }
+
+    void shrink_to_fit()
+    {
+        if (0 == mSize && mData != nullptr)
+        {
+            AllocTraits::deallocate(mAllocator, mData, mCapacity);
+            mData = nullptr;
+            mCapacity = 0;
+        }
+        else if (mSize < mCapacity)
+        {
+            mAllocator.shrink(mData, mCapacity, mSize);
+            mCapacity = mSize;
+        }
+    }
+
+    T& operator[](size_t index) { return mData[index]; }
+    const T& operator[](size_t index) const { return mData[index]; }
+
+    T& at(size_t index)
+    {
+        if (index >= mSize)
+        {
+            throw std::out_of_range("ExpandableVector index is out of range");
+        }
+        return mData[index];
+    }
+
+    T& back() { return mData[mSize - 1]; }
+    const T& back() const { return mData[mSize - 1]; }
+
+    T* data() noexcept { return mData; }
+    const T* data() const noexcept { return mData; }
+
+    iterator begin() noexcept { return mData; }
+    iterator end() noexcept { return mData + mSize; }
+    const_iterator begin() const noexcept { return mData; }
+    const_iterator end() const noexcept { return mData + mSize; }
+
+    size_t size() const noexcept { return mSize; }
+    size_t capacity() const noexcept { return mCapacity; }
+    bool empty() const noexcept { return 0 == mSize; }
+
+    Allocator get_allocator() const { return mAllocator; }
+
+private:
+    /**
+     * emplace_back() into a full buffer. @args may refer to the elements (v.push_back(v[0])), so when the
+     * buffer can't grow in place, the new element is built in the new buffer before the old ones move over.
+     */
+    template <typename... Args>
+    T& growAndEmplaceBack(Args&&... args)
+    {
+        size_t newCapacity = mCapacity > 0 ? 2 * mCapacity : 1;
+        if (mData != nullptr && mAllocator.tryExpand(mData, mCapacity, newCapacity))
+        {
+            mCapacity = newCapacity;
+            AllocTraits::construct(mAllocator, mData + mSize, std::forward<Args>(args)...);
+            return mData[mSize++];
+        }
+
+        T* newData = AllocTraits::allocate(mAllocator, newCapacity);
+        try
+        {
+            AllocTraits::construct(mAllocator, newData + mSize, std::forward<Args>(args)...);
+            try
+            {
+                moveElementsTo(newData);
+            }
+            catch (...)
+            {
+                AllocTraits::destroy(mAllocator, newData + mSize);
+                throw;
+            }
+        }
+        catch (...)
+        {
+            AllocTraits::deallocate(mAllocator, newData, newCapacity);
+            throw;
+        }
+        adopt(newData, newCapacity);
+        return mData[mSize++];
+    }
+
+    /**
+     * Moves (or copies, if moving may throw) the elements to @newData. If that throws, the elements
+     * constructed there are destroyed and the vector is left as it was.
+     */
+    void moveElementsTo(T* newData)
+    {
+        size_t i = 0;
+        try
+        {
+            for (; i < mSize; i++)
+            {
+                AllocTraits::construct(mAllocator, newData + i, std::move_if_noexcept(mData[i]));
+            }
+        }
+        catch (...)
+        {
+            while (i > 0)
+            {
+                AllocTraits::destroy(mAllocator, newData + --i);
+            }
+            throw;
+        }
+    }
+
+    // Switches over to @newData once the elements are there
+    void adopt(T* newData, size_t newCapacity) noexcept
+    {
+        for (size_t i = 0; i < mSize; i++)
+        {
+            AllocTraits::destroy(mAllocator, mData + i);
+        }
+        if (mData != nullptr)
+        {
+            AllocTraits::deallocate(mAllocator, mData, mCapacity);
+        }
+        mData = newData;
+        mCapacity = newCapacity;
+    }
+
+    Allocator mAllocator;
+    T* mData;
+    size_t mSize;
+    size_t mCapacity;
+};
+
+} // mybicycles
@@ -14,8 +14,10 @@ void testMyAllocators()
     constexpr size_t SEG_SIZE = 1024;
 
     using namespace mybicycles;
-    using MyBicyclesAllocatorOnStack = MyAllocatorOnStack<BicycleImpl, SEG_SIZE>;
-    using MyBicyclesPairAllocatorOnStack = MyAllocatorOnStack<std::pair<const int, BicycleImpl>, SEG_SIZE>;
+    // AllocationLogging to see the allocations (NoAccounting to see nothing)
+    using MyBicyclesAllocatorOnStack = MyAllocatorOnStack<BicycleImpl, SEG_SIZE, SimpleSegmentManager, AllocationLogging>;
+    using MyBicyclesPairAllocatorOnStack = MyAllocatorOnStack<std::pair<const int, BicycleImpl>, SEG_SIZE,
+                                                              SimpleSegmentManager, AllocationLogging>;
     using MyBicyclesAllocatorNonOwning = MyAllocatorNonOwning<BicycleImpl>;
     using MyBicyclesPairAllocatorNonOwning = MyAllocatorNonOwning<std::pair<const int, BicycleImpl>>;
 
@@ -23,9 +25,7 @@ void testMyAllocators()
 
     {
         std::cout << "=======================std::vector:======================" << std::endl;
-
-        constexpr bool ALLOC_LOGGING = true;
-        MyBicyclesAllocatorOnStack myal(ALLOC_LOGGING);
+        MyBicyclesAllocatorOnStack myal;
         std::vector<BicycleImpl, MyBicyclesAllocatorOnStack> v1(myal);
         v1.push_back({"Bicycle1", BICYCLE_LOGGING});
         v1.push_back({"Bicycle2", BICYCLE_LOGGING});
@@ -37,7 +37,7 @@ void testMyAllocators()
 
     {
         std::cout << "=======================std::list:=======================" << std::endl;
-        MyBicyclesPairAllocatorOnStack myal2(true);
+        MyBicyclesPairAllocatorOnStack myal2;
         std::list<BicycleImpl, MyBicyclesAllocatorOnStack> l(myal2);
         l.push_back({"Bicycle1", BICYCLE_LOGGING});
         l.push_back({"Bicycle2", BICYCLE_LOGGING});
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Why an allocation or a deallocation failed, for the non-throwing tryAllocate()/tryFree() paths of the
+ * allocators & segment managers (their throwing counterparts throw exceptions telling the same).
+ */
+enum class AllocError
+{
+    None,
+    ZeroSize,         // nothing to allocate
+    NoSegmentManager, // a default-constructed allocator
+    OutOfMemory,      // no block large enough (or as aligned as requested)
+    NullPointer,
+    InvalidPointer,   // not allocated by the segment manager
+    DoubleFree
+};
+
+inline const char* toString(AllocError error)
+{
+    switch (error)
+    {
+    case AllocError::None:             return "none";
+    case AllocError::ZeroSize:         return "zero size";
+    case AllocError::NoSegmentManager: return "no segment manager";
+    case AllocError::OutOfMemory:      return "out of memory";
+    case AllocError::NullPointer:      return "null pointer";
+    case AllocError::InvalidPointer:   return "invalid pointer";
+    case AllocError::DoubleFree:       return "double free";
+    }
+    return "unknown";
+}
+
+/**
+ * What tryAllocate() returns: the memory, or nullptr & the reason.
+ */
+template <typename T>
+struct AllocResult
+{
+    T* ptr = nullptr;
+    AllocError error = AllocError::None;
+
+    explicit operator bool() const noexcept
+    {
+        return ptr != nullptr;
+    }
+};
+
+// Whether a segment manager has a non-throwing AllocError tryFree(addr)
+template <typename SegmentManagerType, typename = void>
+struct HasTryFree : std::false_type
+{
+};
+
+template <typename SegmentManagerType>
+struct HasTryFree<SegmentManagerType,
+                  std::void_t<decltype(std::declval<SegmentManagerType&>().tryFree(nullptr))>> : std::true_type
+{
+};
+
+/**
+ * Frees @addr with the segment manager's tryFree() if it has one. Otherwise its free() is called and
+ * the exceptions it throws for invalid pointers are turned into errors; that costs unwinding on errors
+ * only, but it's still the slow path, so the segment managers on latency-critical paths have tryFree().
+ */
+template <typename SegmentManagerType>
+AllocError tryFreeToSegment(SegmentManagerType& segmentManager, void* addr) noexcept
+{
+    if constexpr (HasTryFree<SegmentManagerType>::value)
+    {
+        return segmentManager.tryFree(addr);
+    }
+    else
+    {
+        if (nullptr == addr)
+        {
+            return AllocError::NullPointer;
+        }
+        try
+        {
+            segmentManager.free(addr);
+        }
+        catch (const std::exception&)
+        {
+            return AllocError::InvalidPointer;
+        }
+        return AllocError::None;
+    }
+}
@@ -0,0 +1,162 @@
+#include "AllocTracer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace mybicycles
+{
+
+namespace
+{
+    // The last character is the format version; version 1 traces (no Resize events) are still loaded
+    const char TRACE_MAGIC[8] = {'B', 'C', 'T', 'R', 'A', 'C', 'E', '2'};
+    const size_t TRACE_MAGIC_VERSION_POS = 7;
+    const char OLDEST_TRACE_VERSION = '1';
+
+    struct TraceFileHeader
+    {
+        char magic[8];
+        uint32_t eventSize;
+        uint32_t reserved;
+        uint64_t eventsNum;
+    };
+
+    static_assert((AllocTracer::THREAD_BUFFER_EVENTS & (AllocTracer::THREAD_BUFFER_EVENTS - 1)) == 0,
+                  "Ring buffer size must be a power of 2");
+}
+
+AllocTracer& AllocTracer::instance()
+{
+    static AllocTracer sInstance;
+    return sInstance;
+}
+
+AllocTracer::ThreadBuffer* AllocTracer::registerThread()
+{
+    std::lock_guard<std::mutex> lock(mBuffersMutex);
+    mBuffers.push_back(std::make_unique<ThreadBuffer>());
+    mBuffers.back()->threadId = static_cast<uint32_t>(mBuffers.size() - 1);
+    return mBuffers.back().get();
+}
+
+uint64_t AllocTracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AllocTraceEvent AllocTracer::makeEvent(AllocEventType type, const void* address, size_t size, uint32_t threadId,
+                                       uint64_t timestampNs)
+{
+    AllocTraceEvent event{};
+    event.timestampNs = timestampNs;
+    event.address = reinterpret_cast<uintptr_t>(address);
+    event.size = size;
+    event.threadId = threadId;
+    event.type = type;
+    return event;
+}
+
+void AllocTracer::record(AllocEventType type, const void* address, size_t size)
+{
+    record(type, address, size, now());
+}
+
+void AllocTracer::record(AllocEventType type, const void* address, size_t size, uint64_t timestampNs)
+{
+    thread_local ThreadBuffer* tBuffer = registerThread();
+
+    if (AllocEventType::SegmentInit == type)
+    {
+        std::lock_guard<std::mutex> lock(mBuffersMutex);
+        mSegmentEvents.push_back(makeEvent(type, address, size, tBuffer->threadId, timestampNs));
+        return;
+    }
+
+    uint64_t written = tBuffer->written.load(std::memory_order_relaxed);
+    if (written != 0 && (written & (THREAD_BUFFER_EVENTS - 1)) == 0 && mKeepAll.load(std::memory_order_relaxed))
+    {
+        // The ring is about to wrap: save it whole. Once per THREAD_BUFFER_EVENTS events, so the lock is cheap.
+        std::lock_guard<std::mutex> lock(mBuffersMutex);
+        tBuffer->spilled.insert(tBuffer->spilled.end(), tBuffer->events, tBuffer->events + THREAD_BUFFER_EVENTS);
+        tBuffer->spilledUpTo = written;
+    }
+    tBuffer->events[written & (THREAD_BUFFER_EVENTS - 1)] =
+            makeEvent(type, address, size, tBuffer->threadId, timestampNs);
+    tBuffer->written.store(written + 1, std::memory_order_release);
+}
+
+bool AllocTracer::dump(const std::string& path) const
+{
+    std::vector<AllocTraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(mBuffersMutex);
+        events = mSegmentEvents;
+        for (const auto& buffer : mBuffers)
+        {
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            uint64_t first = written > THREAD_BUFFER_EVENTS ? written - THREAD_BUFFER_EVENTS : 0;
+            events.insert(events.end(), buffer->spilled.begin(), buffer->spilled.end());
+            first = std::max(first, buffer->spilledUpTo); // the ring still holds the spilled events too
+            for (uint64_t i = first; i < written; i++)
+            {
+                events.push_back(buffer->events[i & (THREAD_BUFFER_EVENTS - 1)]);
+            }
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const AllocTraceEvent& lhs, const AllocTraceEvent& rhs) {
+        return lhs.timestampNs < rhs.timestampNs;
+    });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    TraceFileHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.eventSize = sizeof(AllocTraceEvent);
+    header.eventsNum = events.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(AllocTraceEvent));
+    return static_cast<bool>(file);
+}
+
+void AllocTracer::clear()
+{
+    // Buffers stay registered, as threads keep pointers to them
+    std::lock_guard<std::mutex> lock(mBuffersMutex);
+    mSegmentEvents.clear();
+    for (auto& buffer : mBuffers)
+    {
+        buffer->written.store(0, std::memory_order_release);
+        buffer->spilled.clear();
+        buffer->spilledUpTo = 0;
+    }
+}
+
+std::vector<AllocTraceEvent> AllocTracer::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    TraceFileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TRACE_MAGIC, TRACE_MAGIC_VERSION_POS) != 0 ||
+        header.magic[TRACE_MAGIC_VERSION_POS] < OLDEST_TRACE_VERSION ||
+        header.magic[TRACE_MAGIC_VERSION_POS] > TRACE_MAGIC[TRACE_MAGIC_VERSION_POS] ||
+        header.eventSize != sizeof(AllocTraceEvent))
+    {
+        throw std::runtime_error("Not an allocation trace: " + path);
+    }
+
+    std::vector<AllocTraceEvent> events(header.eventsNum);
+    if (!file.read(reinterpret_cast<char*>(events.data()), events.size() * sizeof(AllocTraceEvent)))
+    {
+        throw std::runtime_error("Truncated allocation trace: " + path);
+    }
+    return events;
+}
+
+} // mybicycles
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mybicycles
+{
+
+enum class AllocEventType : uint8_t
+{
+    SegmentInit = 0, // address & size of a newly managed segment
+    Alloc,
+    Free,
+    Failure, // a failed allocation, address is null
+    Resize // a block resized in place (tryExpand/shrink/realloc), size is the new one; since version 2
+};
+
+/**
+ * A compact binary record of an allocator event, written to the trace file as is.
+ */
+struct AllocTraceEvent
+{
+    uint64_t timestampNs; // steady clock
+    uint64_t address;
+    uint64_t size; // bytes requested (0 for Free)
+    uint32_t threadId; // small sequential number, not the OS id
+    AllocEventType type;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(AllocTraceEvent) == 32, "Trace events must stay compact");
+
+/**
+ * Collects allocation events into per-thread ring buffers and dumps them into a binary trace file
+ * to be analyzed offline by the AllocTraceAnalyzer tool.
+ *
+ * Recording an event takes no locks: every thread writes only into its own ring buffer, which is
+ * allocated (and registered, under a mutex) on the thread's first event. When a buffer is full,
+ * the oldest events of the thread get overwritten (except SegmentInit ones, which are rare and
+ * kept aside, so the analyzer always knows the segments' bounds). Buffers outlive their threads, so events of
+ * finished threads are dumped too; events being written while dump() runs may come out garbled.
+ *
+ * The segment managers record events only when built with MYBICYCLES_ALLOC_TRACING
+ * (see ALLOC_TRACE below); otherwise tracing costs nothing.
+ */
+class AllocTracer
+{
+public:
+    static constexpr size_t THREAD_BUFFER_EVENTS = 16 * 1024; // must be a power of 2
+
+    static AllocTracer& instance();
+
+    void record(AllocEventType type, const void* address, size_t size);
+    // record() of an event stamped earlier with now(), e.g. one which is known to have happened only afterwards
+    void record(AllocEventType type, const void* address, size_t size, uint64_t timestampNs);
+
+    // The steady clock time events are stamped with
+    static uint64_t now();
+
+    /**
+     * In keep-all mode a full ring buffer is copied aside before it wraps, so no event is ever lost
+     * (at the cost of unbounded memory). Traces meant for replay need this.
+     */
+    void setKeepAllEvents(bool keepAll)
+    {
+        mKeepAll.store(keepAll, std::memory_order_relaxed);
+    }
+
+    /**
+     * Writes all the buffered events, ordered by time, into the file at @path.
+     * Returns false if the file can't be written.
+     */
+    bool dump(const std::string& path) const;
+
+    /**
+     * Drops all the buffered events.
+     */
+    void clear();
+
+    /**
+     * Reads the events back from a trace file. Throws std::runtime_error if it's not a valid trace.
+     */
+    static std::vector<AllocTraceEvent> load(const std::string& path);
+
+private:
+    struct ThreadBuffer
+    {
+        uint32_t threadId;
+        std::atomic<uint64_t> written{0}; // total events ever written; the ring holds the last ones
+        // Keep-all mode: the wrapped-over events, those written before spilledUpTo; guarded by mBuffersMutex
+        std::vector<AllocTraceEvent> spilled;
+        uint64_t spilledUpTo = 0;
+        AllocTraceEvent events[THREAD_BUFFER_EVENTS];
+    };
+
+    AllocTracer() = default;
+
+    ThreadBuffer* registerThread();
+    static AllocTraceEvent makeEvent(AllocEventType type, const void* address, size_t size, uint32_t threadId,
+                                     uint64_t timestampNs);
+
+    mutable std::mutex mBuffersMutex; // guards registration, segment events & dumping only
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+    std::vector<AllocTraceEvent> mSegmentEvents;
+    std::atomic<bool> mKeepAll{false};
+};
+
+} // mybicycles
+
+#ifdef MYBICYCLES_ALLOC_TRACING
+#define ALLOC_TRACE(type, address, size) \
+    ::mybicycles::AllocTracer::instance().record(::mybicycles::AllocEventType::type, (address), (size))
+#else
+#define ALLOC_TRACE(type, address, size) ((void)0)
+#endif
@@ -0,0 +1,87 @@
+#include "AllocationAccounting.hpp"
+
+namespace mybicycles
+{
+
+std::ostream& operator<<(std::ostream& os, const AllocationAccountStats& stats)
+{
+    os << stats.label << ": live " << stats.liveBytes << " B (peak " << stats.peakBytes << " B), allocs: "
+       << stats.allocsNum << ", frees: " << stats.freesNum;
+    return os;
+}
+
+AllocationAccountStats AllocationAccount::getStats() const
+{
+    AllocationAccountStats stats;
+    stats.label = mLabel;
+    int64_t liveBytes = mLiveBytes.load(std::memory_order_relaxed);
+    stats.liveBytes = liveBytes > 0 ? static_cast<size_t>(liveBytes) : 0;
+    stats.peakBytes = static_cast<size_t>(mPeakBytes.load(std::memory_order_relaxed));
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AllocationAccount::reset()
+{
+    int64_t liveBytes = mLiveBytes.load(std::memory_order_relaxed);
+    mPeakBytes.store(liveBytes > 0 ? liveBytes : 0, std::memory_order_relaxed);
+    mAllocsNum.store(0, std::memory_order_relaxed);
+    mFreesNum.store(0, std::memory_order_relaxed);
+}
+
+AllocationAccounts& AllocationAccounts::instance()
+{
+    static AllocationAccounts sInstance;
+    return sInstance;
+}
+
+AllocationAccount& AllocationAccounts::get(const std::string& label)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& account = mAccounts[label];
+    if (!account)
+    {
+        account = std::make_unique<AllocationAccount>(label);
+    }
+    return *account;
+}
+
+std::vector<AllocationAccountStats> AllocationAccounts::getStats() const
+{
+    std::vector<AllocationAccountStats> stats;
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats.reserve(mAccounts.size());
+    for (const auto& [label, account] : mAccounts)
+    {
+        stats.push_back(account->getStats());
+    }
+    return stats;
+}
+
+void AllocationAccounts::reset()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& [label, account] : mAccounts)
+    {
+        account->reset();
+    }
+}
+
+void AllocationAccounts::dump(std::ostream& os) const
+{
+    std::vector<AllocationAccountStats> stats = getStats();
+    size_t liveBytes = 0;
+    for (const auto& accountStats : stats)
+    {
+        liveBytes += accountStats.liveBytes;
+    }
+    os << "Allocation accounts: " << stats.size() << ", " << liveBytes << " live bytes in total\n";
+    for (const auto& accountStats : stats)
+    {
+        os << "    " << accountStats << "\n";
+    }
+    os.flush();
+}
+
+} // mybicycles
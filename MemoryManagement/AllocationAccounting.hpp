@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mybicycles
+{
+
+/*
+ACCOUNTING POLICIES of the MyAllocator* allocators (their AccountingPolicy parameter):
+
+An allocator derives from its policy, which gets to know about every allocation & deallocation through
+    void onAllocate(const char* allocator, size_t n, size_t bytes);
+    void onDeallocate(const char* allocator, size_t n, size_t bytes);
+    void onResize(const char* allocator, size_t n, size_t oldBytes, size_t newBytes);
+(@allocator is the allocator's __PRETTY_FUNCTION__; onResize() is about memory grown or shrunk in place
+to @n objects, which is then deallocated with its new size). The policy is copied along with the allocator,
+rebinds included, and VERBOSE tells whether the segment manager is to be verbose too.
+*/
+
+/**
+ * The default: nothing is accounted for, and the allocators carry no extra state.
+ */
+struct NoAccounting
+{
+    static constexpr bool VERBOSE = false;
+
+    void onAllocate(const char*, size_t, size_t) const noexcept
+    {
+    }
+
+    void onDeallocate(const char*, size_t, size_t) const noexcept
+    {
+    }
+
+    void onResize(const char*, size_t, size_t, size_t) const noexcept
+    {
+    }
+};
+
+/**
+ * Prints every allocation & deallocation to stdout.
+ */
+struct AllocationLogging
+{
+    static constexpr bool VERBOSE = true;
+
+    void onAllocate(const char* allocator, size_t n, size_t bytes) const
+    {
+        std::cout << allocator << " | Allocating num of objects: " << n <<
+                                  " | " << bytes << " bytes are required" << std::endl;
+    }
+
+    void onDeallocate(const char* allocator, size_t n, size_t bytes) const
+    {
+        std::cout << allocator << " | Deallocating num of objects: " << n <<
+                                  " | " << bytes << " bytes are to be freed" << std::endl;
+    }
+
+    void onResize(const char* allocator, size_t n, size_t oldBytes, size_t newBytes) const
+    {
+        std::cout << allocator << " | Resizing to num of objects: " << n <<
+                                  " | " << oldBytes << " -> " << newBytes << " bytes" << std::endl;
+    }
+};
+
+/**
+ * A snapshot of an AllocationAccount
+ */
+struct AllocationAccountStats
+{
+    std::string label;
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    uint64_t allocsNum = 0;
+    uint64_t freesNum = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const AllocationAccountStats& stats);
+
+/**
+ * Counters of the memory allocated by the allocators with a label. They're updated with relaxed atomic
+ * operations only (the peak with a CAS when it's exceeded), so the snapshots of an account being updated
+ * by other threads may be slightly inconsistent.
+ */
+class AllocationAccount
+{
+public:
+    explicit AllocationAccount(std::string label) :
+        mLabel(std::move(label))
+    {
+    }
+
+    void onAllocate(size_t bytes) noexcept
+    {
+        addLiveBytes(static_cast<int64_t>(bytes));
+        mAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onDeallocate(size_t bytes) noexcept
+    {
+        mLiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Memory resized in place is neither an allocation nor a deallocation, only its bytes change
+    void onResize(size_t oldBytes, size_t newBytes) noexcept
+    {
+        addLiveBytes(static_cast<int64_t>(newBytes) - static_cast<int64_t>(oldBytes));
+    }
+
+    const std::string& getLabel() const
+    {
+        return mLabel;
+    }
+
+    AllocationAccountStats getStats() const;
+    // Starts counting anew; the live bytes stay, as they're still to be deallocated
+    void reset();
+
+private:
+    void addLiveBytes(int64_t bytes) noexcept
+    {
+        int64_t liveBytes = mLiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t peakBytes = mPeakBytes.load(std::memory_order_relaxed);
+        while (liveBytes > peakBytes &&
+               !mPeakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    const std::string mLabel;
+    // Signed, as memory may be deallocated from another account than it was allocated from (see
+    // LabelAccounting); the snapshots report at least 0
+    std::atomic<int64_t> mLiveBytes{0};
+    std::atomic<int64_t> mPeakBytes{0};
+    std::atomic<uint64_t> mAllocsNum{0};
+    std::atomic<uint64_t> mFreesNum{0};
+};
+
+/**
+ * All the accounts, by label. Accounts are never removed, so the allocators may keep pointers to them.
+ */
+class AllocationAccounts
+{
+public:
+    static AllocationAccounts& instance();
+
+    /**
+     * The account of @label; it's created on the first call.
+     */
+    AllocationAccount& get(const std::string& label);
+
+    /**
+     * Statistics of all the accounts, by label.
+     */
+    std::vector<AllocationAccountStats> getStats() const;
+    // Resets all the accounts (see AllocationAccount::reset())
+    void reset();
+    void dump(std::ostream& os) const;
+
+private:
+    AllocationAccounts() = default;
+
+    mutable std::mutex mMutex;
+    std::map<std::string, std::unique_ptr<AllocationAccount>> mAccounts;
+};
+
+/**
+ * Accounts for the memory of the allocators (and so of the containers) with a label: e.g. all the
+ * containers of orders given allocators with the "orders" label, and AllocationAccounts tells how much
+ * memory they use out of their shared segment. Looking the account up takes a lock, so it's done once,
+ * when an allocator is given a label; copies & rebinds of the allocator then share the account.
+ *
+ * The label doesn't take part in the allocators' equality: they're equal as long as they share the
+ * segment manager, so containers with different labels may hand memory over (e.g. by list::splice()).
+ * Such memory is deallocated from the account of the container it ended up in: the totals stay right,
+ * while the giving account keeps the bytes & the taking one may go below zero.
+ */
+class LabelAccounting
+{
+public:
+    static constexpr bool VERBOSE = false;
+    static constexpr const char* UNLABELLED = "(unlabelled)";
+
+    // The allocators which containers create by themselves
+    LabelAccounting() :
+        LabelAccounting(UNLABELLED)
+    {
+    }
+
+    LabelAccounting(const std::string& label) :
+        mAccount(&AllocationAccounts::instance().get(label))
+    {
+    }
+
+    LabelAccounting(const char* label) :
+        LabelAccounting(std::string(label))
+    {
+    }
+
+    void onAllocate(const char*, size_t, size_t bytes) noexcept
+    {
+        mAccount->onAllocate(bytes);
+    }
+
+    void onDeallocate(const char*, size_t, size_t bytes) noexcept
+    {
+        mAccount->onDeallocate(bytes);
+    }
+
+    void onResize(const char*, size_t, size_t oldBytes, size_t newBytes) noexcept
+    {
+        mAccount->onResize(oldBytes, newBytes);
+    }
+
+    AllocationAccount& getAccount() const noexcept
+    {
+        return *mAccount;
+    }
+
+private:
+    AllocationAccount* mAccount;
+};
+
+} // mybicycles
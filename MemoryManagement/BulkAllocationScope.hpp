@@ -0,0 +1,136 @@
+#pragma once
+
+#include "AllocError.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mybicycles
+{
+
+// Whether a segment manager can allocate & free blocks in batches (allocBatch()/tryFreeBatch())
+template <typename SegmentManagerType, typename = void>
+struct HasBatchAlloc : std::false_type
+{
+};
+
+template <typename SegmentManagerType>
+struct HasBatchAlloc<SegmentManagerType,
+                     std::void_t<decltype(std::declval<SegmentManagerType&>().allocBatch(size_t(), size_t(), nullptr)),
+                                 decltype(std::declval<SegmentManagerType&>().tryFreeBatch(
+                                         nullptr, size_t(), std::declval<AllocError&>()))>> : std::true_type
+{
+};
+
+/**
+ * While a BulkAllocationScope is alive, the MyAllocator* allocators of the calling thread working with
+ * @manager batch their requests to it:
+ * - The first allocation of a single block makes the scope fetch @expectedAllocs blocks of that size
+ *   at once with allocBatch(). The following allocations of the same size are served from this batch.
+ * - Deallocations are collected and handed back with a single tryFreeBatch() when the scope ends, along
+ *   with the blocks of the batch left unused. So an invalid pointer doesn't throw from deallocate(); the
+ *   scope's destructor reports it to stderr and frees the blocks after it all the same.
+ *
+ * Node containers allocate their nodes one at a time, so that's how they get bulk loaded (or cleared)
+ * with one lock acquisition instead of one per node; see Containers/BulkInsert.hpp. Scopes may nest,
+ * the innermost one being in effect.
+ */
+template <typename SegmentManagerType>
+class BulkAllocationScope
+{
+public:
+    BulkAllocationScope(SegmentManagerType& manager, size_t expectedAllocs) :
+        mManager(manager),
+        mExpectedAllocs(expectedAllocs),
+        mBlockBytes(0),
+        mBlocks(),
+        mNextBlock(0),
+        mDeferredFrees(),
+        mPrevious(tCurrent)
+    {
+        tCurrent = this;
+    }
+
+    ~BulkAllocationScope()
+    {
+        tCurrent = mPrevious;
+        mDeferredFrees.insert(mDeferredFrees.end(), mBlocks.begin() + mNextBlock, mBlocks.end());
+        size_t freedNum = 0;
+        while (freedNum < mDeferredFrees.size())
+        {
+            AllocError error = AllocError::None;
+            freedNum += mManager.tryFreeBatch(mDeferredFrees.data() + freedNum,
+                                              mDeferredFrees.size() - freedNum, error);
+            if (error != AllocError::None)
+            {
+                // A destructor mustn't throw, while deallocate() would have thrown for this pointer outside
+                // a scope: it's the caller's bug, so it's reported & skipped
+                std::cerr << V_LOG_TAG << "Cannot free " << mDeferredFrees[freedNum] << ": "
+                                       << toString(error) << std::endl;
+                freedNum++;
+            }
+        }
+    }
+
+    BulkAllocationScope(const BulkAllocationScope& rhs) = delete;
+    BulkAllocationScope& operator= (const BulkAllocationScope& rhs) = delete;
+
+    /**
+     * Returns a block of @bytes from the current scope's batch, or nullptr if there's no scope for
+     * @manager or the batch doesn't fit.
+     */
+    static void* take(SegmentManagerType* manager, size_t bytes)
+    {
+        BulkAllocationScope* scope = tCurrent;
+        if (nullptr == scope || &scope->mManager != manager)
+        {
+            return nullptr;
+        }
+        if (0 == scope->mBlockBytes && scope->mExpectedAllocs != 0)
+        {
+            scope->mBlockBytes = bytes;
+            scope->mBlocks.resize(scope->mExpectedAllocs);
+            scope->mBlocks.resize(manager->allocBatch(scope->mExpectedAllocs, bytes, scope->mBlocks.data()));
+        }
+        if (bytes != scope->mBlockBytes || scope->mNextBlock == scope->mBlocks.size())
+        {
+            return nullptr;
+        }
+        return scope->mBlocks[scope->mNextBlock++];
+    }
+
+    /**
+     * Puts off freeing @addr till the end of the current scope. Returns false if there's no scope for @manager.
+     */
+    static bool defer(SegmentManagerType* manager, void* addr)
+    {
+        BulkAllocationScope* scope = tCurrent;
+        if (nullptr == scope || &scope->mManager != manager)
+        {
+            return false;
+        }
+        scope->mDeferredFrees.push_back(addr);
+        return true;
+    }
+
+private:
+    static constexpr const char* V_LOG_TAG = "__BAS__ ";
+
+    SegmentManagerType& mManager;
+    size_t mExpectedAllocs;
+    size_t mBlockBytes; // 0 until the batch is fetched
+    std::vector<void*> mBlocks;
+    size_t mNextBlock;
+    std::vector<void*> mDeferredFrees;
+    BulkAllocationScope* mPrevious;
+
+    static thread_local BulkAllocationScope* tCurrent;
+};
+
+template <typename SegmentManagerType>
+thread_local BulkAllocationScope<SegmentManagerType>* BulkAllocationScope<SegmentManagerType>::tCurrent = nullptr;
+
+} // mybicycles
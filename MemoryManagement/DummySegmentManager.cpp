@@ -1,15 +1,58 @@
 #include "DummySegmentManager.hpp"
 
+#include <cstdlib>
+#include <new>
+
 DummySegmentManager::DummySegmentManager(void*, size_t, bool)
 {
 }
 
 void* DummySegmentManager::alloc(size_t neededBytes)
 {
-    return operator new(neededBytes);
+    return alloc(neededBytes, alignof(std::max_align_t));
+}
+
+void* DummySegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    if (alignment < alignof(std::max_align_t))
+    {
+        alignment = alignof(std::max_align_t);
+    }
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t roundedBytes = ((neededBytes + alignment - 1) / alignment) * alignment;
+    void* mem = std::aligned_alloc(alignment, roundedBytes != 0 ? roundedBytes : alignment);
+    if (nullptr == mem)
+    {
+        return nullptr; // like any other segment manager
+    }
+    mAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    return mem;
 }
 
 void DummySegmentManager::free(void* addr)
 {
-    ::operator delete(addr);
+    mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    std::free(addr);
+}
+
+SegmentManagerStats DummySegmentManager::getStats() const
+{
+    SegmentManagerStats stats;
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool DummySegmentManager::tryExpand(void*, size_t)
+{
+    return false;
+}
+
+void DummySegmentManager::shrink(void*, size_t)
+{
+}
+
+void* DummySegmentManager::realloc(void* addr, size_t newBytes)
+{
+    return std::realloc(addr, newBytes);
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "SegmentManagerStats.hpp"
+
+#include <atomic>
 #include <cstddef>
 
 /**
@@ -13,5 +16,18 @@ public:
     ~DummySegmentManager() = default;
 
     void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
     void free(void* addr);
+
+    // Heap blocks are never resized in place
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    // Only alloc/free counts are known
+    SegmentManagerStats getStats() const;
+
+private:
+    std::atomic<uint64_t> mAllocsNum{0};
+    std::atomic<uint64_t> mFreesNum{0};
 };
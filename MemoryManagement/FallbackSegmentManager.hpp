@@ -0,0 +1,285 @@
+#pragma once
+
+#include "AllocError.hpp"
+#include "DummySegmentManager.hpp"
+#include "SegmentManagerStats.hpp"
+#include "SharedPtr.hpp"
+#include "SimpleSegmentManager.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+/**
+ * This class serves allocations from its segment (through a @PrimaryType segment manager) as long as
+ * there's room there, and lets the rest overflow to an @UpstreamType segment manager: by default the
+ * heap (@DummySegmentManager), or any other one given to the constructor. Every pointer goes back to
+ * where it came from, as told by its address. With a segment on the stack (see @MyAllocatorOnStack),
+ * that's the short_alloc pattern: containers which are usually small never touch the heap, while the
+ * occasional large one still works.
+ *
+ * FallbackSegmentManager is not responsible for destruction of the memory it manages; the upstream
+ * segment manager is shared.
+ */
+template <typename PrimaryType = SimpleSegmentManager, typename UpstreamType = DummySegmentManager>
+class FallbackSegmentManager
+{
+public:
+    // Overflowing to the heap: UpstreamType must be DummySegmentManager (or another one ignoring its segment)
+    FallbackSegmentManager(char* segment,
+                           size_t size,
+                           bool verboseDebugging = false);
+    FallbackSegmentManager(char* segment,
+                           size_t size,
+                           const mybicycles::SharedPtr<UpstreamType>& upstream,
+                           bool verboseDebugging = false);
+    ~FallbackSegmentManager() = default;
+
+    FallbackSegmentManager(const FallbackSegmentManager& rhs) = delete;
+    FallbackSegmentManager& operator= (const FallbackSegmentManager& rhs) = delete;
+    FallbackSegmentManager(FallbackSegmentManager&& rhs) = delete;
+    FallbackSegmentManager& operator= (FallbackSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes)
+    {
+        return alloc(neededBytes, alignof(std::max_align_t));
+    }
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+    // free() which returns the error instead of throwing it (the upstream's errors included)
+    AllocError tryFree(void* addr) noexcept;
+
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    // A block outgrowing the segment moves upstream
+    void* realloc(void* addr, size_t newBytes);
+
+    bool isInSegment(const void* addr) const
+    {
+        return static_cast<const char*>(addr) >= mSegment && static_cast<const char*>(addr) < mSegment + mSegmentSize;
+    }
+
+    // Allocations which didn't fit into the segment & went upstream
+    uint64_t getOverflowsNum() const
+    {
+        return mOverflowsNum.load(std::memory_order_relaxed);
+    }
+
+    const mybicycles::SharedPtr<UpstreamType>& getUpstream() const
+    {
+        return mUpstream;
+    }
+
+    /**
+     * Statistics of the segment; the alloc/free counts include the upstream ones, and only allocations
+     * the upstream couldn't serve either count as failed.
+     */
+    SegmentManagerStats getStats() const;
+
+private:
+    static constexpr const char* V_LOG_TAG = "__FSM__ "; // tag for verbose debugging
+
+    bool isPrimary(const void* addr) const
+    {
+        return isInSegment(addr) || !mUpstream;
+    }
+
+    char* mSegment;
+    size_t mSegmentSize;
+    bool mVerboseDebug;
+
+    PrimaryType mPrimary;
+    mybicycles::SharedPtr<UpstreamType> mUpstream;
+
+    std::atomic<uint64_t> mOverflowsNum{0};
+    std::atomic<uint64_t> mUpstreamFreesNum{0};
+    std::atomic<uint64_t> mFailedAllocsNum{0};
+};
+
+template <typename PrimaryType, typename UpstreamType>
+FallbackSegmentManager<PrimaryType, UpstreamType>::FallbackSegmentManager(char* segment,
+                                                                          size_t size,
+                                                                          bool verboseDebugging) :
+    // Every instance gets its own: SharedPtr's counter isn't atomic, so it can't be shared between threads
+    FallbackSegmentManager(segment, size, mybicycles::makeShared<UpstreamType>(nullptr, 0, verboseDebugging),
+                           verboseDebugging)
+{
+}
+
+template <typename PrimaryType, typename UpstreamType>
+FallbackSegmentManager<PrimaryType, UpstreamType>::FallbackSegmentManager(char* segment,
+                                                                          size_t size,
+                                                                          const mybicycles::SharedPtr<UpstreamType>& upstream,
+                                                                          bool verboseDebugging) :
+    mSegment(segment),
+    mSegmentSize(size),
+    mVerboseDebug(verboseDebugging),
+    mPrimary(segment, size, verboseDebugging),
+    mUpstream(upstream)
+{
+}
+
+template <typename PrimaryType, typename UpstreamType>
+void* FallbackSegmentManager<PrimaryType, UpstreamType>::alloc(size_t neededBytes, size_t alignment)
+{
+    void* retAddr = mPrimary.alloc(neededBytes, alignment);
+    if (retAddr != nullptr)
+    {
+        return retAddr;
+    }
+
+    retAddr = mUpstream ? mUpstream->alloc(neededBytes, alignment) : nullptr;
+    if (retAddr != nullptr)
+    {
+        mOverflowsNum.fetch_add(1, std::memory_order_relaxed);
+        if (mVerboseDebug)
+        {
+            std::cout << V_LOG_TAG << neededBytes << " bytes went upstream" << std::endl;
+        }
+    }
+    else
+    {
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    return retAddr;
+}
+
+template <typename PrimaryType, typename UpstreamType>
+void FallbackSegmentManager<PrimaryType, UpstreamType>::free(void* addr)
+{
+    if (isPrimary(addr))
+    {
+        mPrimary.free(addr); // throws for nullptr & pointers of nobody's
+        return;
+    }
+    mUpstream->free(addr);
+    mUpstreamFreesNum.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename PrimaryType, typename UpstreamType>
+AllocError FallbackSegmentManager<PrimaryType, UpstreamType>::tryFree(void* addr) noexcept
+{
+    if (nullptr == addr)
+    {
+        return AllocError::NullPointer;
+    }
+    if (isPrimary(addr))
+    {
+        return tryFreeToSegment(mPrimary, addr);
+    }
+    AllocError error = tryFreeToSegment(*mUpstream, addr);
+    if (AllocError::None == error)
+    {
+        mUpstreamFreesNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    return error;
+}
+
+template <typename PrimaryType, typename UpstreamType>
+bool FallbackSegmentManager<PrimaryType, UpstreamType>::tryExpand(void* addr, size_t newBytes)
+{
+    return isPrimary(addr) ? mPrimary.tryExpand(addr, newBytes) : mUpstream->tryExpand(addr, newBytes);
+}
+
+template <typename PrimaryType, typename UpstreamType>
+void FallbackSegmentManager<PrimaryType, UpstreamType>::shrink(void* addr, size_t newBytes)
+{
+    if (isPrimary(addr))
+    {
+        mPrimary.shrink(addr, newBytes);
+    }
+    else
+    {
+        mUpstream->shrink(addr, newBytes);
+    }
+}
+
+template <typename PrimaryType, typename UpstreamType>
+void* FallbackSegmentManager<PrimaryType, UpstreamType>::realloc(void* addr, size_t newBytes)
+{
+    if (nullptr == addr)
+    {
+        return alloc(newBytes);
+    }
+    if (!isPrimary(addr))
+    {
+        return mUpstream->realloc(addr, newBytes);
+    }
+
+    void* newAddr = mPrimary.realloc(addr, newBytes);
+    if (newAddr != nullptr || !mUpstream)
+    {
+        return newAddr;
+    }
+    newAddr = mUpstream->alloc(newBytes, alignof(std::max_align_t));
+    if (newAddr != nullptr)
+    {
+        // The old block's size isn't known here, but copying up to the segment's end reads only the segment
+        std::memcpy(newAddr, addr, std::min<size_t>(newBytes, mSegment + mSegmentSize - static_cast<char*>(addr)));
+        mPrimary.free(addr);
+        mOverflowsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    return newAddr;
+}
+
+template <typename PrimaryType, typename UpstreamType>
+SegmentManagerStats FallbackSegmentManager<PrimaryType, UpstreamType>::getStats() const
+{
+    SegmentManagerStats stats = mPrimary.getStats();
+    stats.allocsNum += getOverflowsNum();
+    stats.freesNum += mUpstreamFreesNum.load(std::memory_order_relaxed);
+    stats.failedAllocsNum = mFailedAllocsNum.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/*
+FALLBACK CHAINS: segment A, then segment B, ..., then the heap.
+
+    char segA[4096], segB[64 * 1024];
+    auto chain = makeFallbackChain<SimpleSegmentManager, SmallObjectSegmentManager>(
+                         SegmentSpan{segA, sizeof(segA)}, SegmentSpan{segB, sizeof(segB)});
+    MyAllocatorNonOwning<int, FallbackChain<SimpleSegmentManager, SmallObjectSegmentManager>> allocator(chain);
+
+Every level is a FallbackSegmentManager whose upstream is the next level, and the last one overflows to
+the heap. Frees find their way back through the levels by address.
+*/
+
+using SegmentSpan = std::pair<char*, size_t>;
+
+template <typename PrimaryType, typename... RestTypes>
+struct FallbackChainOf
+{
+    using type = FallbackSegmentManager<PrimaryType, typename FallbackChainOf<RestTypes...>::type>;
+
+    template <typename... Spans>
+    static mybicycles::SharedPtr<type> make(SegmentSpan segment, Spans... rest)
+    {
+        return mybicycles::makeShared<type>(segment.first, segment.second,
+                                            FallbackChainOf<RestTypes...>::make(rest...));
+    }
+};
+
+template <typename PrimaryType>
+struct FallbackChainOf<PrimaryType>
+{
+    using type = FallbackSegmentManager<PrimaryType, DummySegmentManager>;
+
+    static mybicycles::SharedPtr<type> make(SegmentSpan segment)
+    {
+        return mybicycles::makeShared<type>(segment.first, segment.second);
+    }
+};
+
+template <typename... PrimaryTypes>
+using FallbackChain = typename FallbackChainOf<PrimaryTypes...>::type;
+
+// One segment per level, in the order of @PrimaryTypes
+template <typename... PrimaryTypes, typename... Spans>
+mybicycles::SharedPtr<FallbackChain<PrimaryTypes...>> makeFallbackChain(Spans... segments)
+{
+    static_assert(sizeof...(PrimaryTypes) == sizeof...(Spans), "One segment per level is expected");
+    return FallbackChainOf<PrimaryTypes...>::make(segments...);
+}
@@ -0,0 +1,73 @@
+#include "FileSegment.hpp"
+
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileSegment::FileSegment(const std::string& path, size_t size, void* preferredAddress) :
+    mData(nullptr),
+    mSize(0)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + path + ": " + strerror(errno));
+    }
+
+    struct stat fileStat;
+    if (0 != fstat(fd, &fileStat))
+    {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + strerror(error));
+    }
+    mSize = static_cast<size_t>(fileStat.st_size);
+    if (mSize < size)
+    {
+        if (0 != ftruncate(fd, static_cast<off_t>(size)))
+        {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("Cannot extend " + path + ": " + strerror(error));
+        }
+        mSize = size;
+    }
+    if (0 == mSize)
+    {
+        close(fd);
+        throw std::invalid_argument("Cannot map an empty file");
+    }
+
+    void* mem = MAP_FAILED;
+    if (preferredAddress != nullptr)
+    {
+        // Never clobber existing mappings: fall back to any address if the preferred one is taken
+        mem = mmap(preferredAddress, mSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    }
+    if (MAP_FAILED == mem)
+    {
+        mem = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int error = errno;
+    close(fd); // the mapping keeps the file open
+    if (MAP_FAILED == mem)
+    {
+        throw std::runtime_error("Cannot map " + path + ": " + strerror(error));
+    }
+    mData = static_cast<char*>(mem);
+}
+
+FileSegment::~FileSegment()
+{
+    munmap(mData, mSize);
+}
+
+bool FileSegment::sync()
+{
+    return 0 == msync(mData, mSize, MS_SYNC);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * This class maps a file into memory with MAP_SHARED, so everything written to the segment ends up
+ * in the file and is there the next time the file is mapped. The file is created (and extended)
+ * to @size bytes if needed; a larger existing file is mapped as a whole.
+ * If @preferredAddress is given, the file is mapped there unless that range is already taken.
+ * The file is unmapped (but kept) on destruction.
+ */
+class FileSegment
+{
+public:
+    FileSegment(const std::string& path, size_t size, void* preferredAddress = nullptr);
+    ~FileSegment();
+
+    FileSegment(const FileSegment& rhs) = delete;
+    FileSegment& operator= (const FileSegment& rhs) = delete;
+    FileSegment(FileSegment&& rhs) = delete;
+    FileSegment& operator= (FileSegment&& rhs) = delete;
+
+    /**
+     * Writes the modified pages back to the file and waits for that. Returns false on I/O failure.
+     */
+    bool sync();
+
+    char* data() const
+    {
+        return mData;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+private:
+    char* mData;
+    size_t mSize; // bytes
+};
@@ -0,0 +1,298 @@
+#pragma once
+
+#include "AllocError.hpp"
+#include "SegmentManagerStats.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+/**
+ * This class carves a memory segment into equal blocks of (at least) @BLOCK_SZ bytes and hands them
+ * out one at a time, which suits node-based containers whose nodes are all of the same size.
+ * Requests larger than a block are rejected (alloc() returns nullptr).
+ *
+ * Free blocks are kept in a lock-free Treiber stack, so neither alloc() nor free() ever blocks.
+ * The stack head packs the index of the top block together with a modification tag into a single
+ * 64-bit word; the tag is bumped on every push/pop, which makes the head's CAS ABA-safe.
+ * A byte per block, kept apart from the segment, tells whether the block is free, so that a double
+ * free is reported instead of pushing the block twice (and handing it out twice later).
+ *
+ * FixedBlockSegmentManager is not responsible for destruction of the memory it manages.
+ */
+template <size_t BLOCK_SZ>
+class FixedBlockSegmentManager
+{
+public:
+    FixedBlockSegmentManager(char* segment,
+                             size_t size,
+                             bool verboseDebugging = false);
+    ~FixedBlockSegmentManager() = default;
+
+    FixedBlockSegmentManager(const FixedBlockSegmentManager& rhs) = delete;
+    FixedBlockSegmentManager& operator= (const FixedBlockSegmentManager& rhs) = delete;
+    FixedBlockSegmentManager(FixedBlockSegmentManager&& rhs) = delete;
+    FixedBlockSegmentManager& operator= (FixedBlockSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    // Blocks are aligned to max_align_t only; more strictly aligned requests are rejected
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+    // free() which returns the error instead of throwing it
+    AllocError tryFree(void* addr) noexcept;
+
+    // A block can be resized within BLOCK_SZ only
+    bool tryExpand(void*, size_t newBytes)
+    {
+        return newBytes <= BLOCK_SZ;
+    }
+
+    void shrink(void*, size_t)
+    {
+    }
+
+    void* realloc(void* addr, size_t newBytes)
+    {
+        if (nullptr == addr)
+        {
+            return alloc(newBytes);
+        }
+        return newBytes <= BLOCK_SZ ? addr : nullptr;
+    }
+
+    size_t getBlocksNum() const
+    {
+        return mBlocksNum;
+    }
+
+    SegmentManagerStats getStats() const;
+
+    // Actual size of a block: BLOCK_SZ rounded up to keep every block suitably aligned
+    static constexpr size_t ACTUAL_BLOCK_SZ =
+            ((BLOCK_SZ + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+private:
+    // Free blocks store the index of the next free block (+1, 0 being the end of the stack)
+    using FreeBlock = std::atomic<uint32_t>;
+
+    static constexpr uint32_t NULL_INDEX = 0;
+    // Block states:
+    static constexpr uint8_t FREE = 0;
+    static constexpr uint8_t ALLOCATED = 1;
+    static constexpr const char* V_LOG_TAG = "__FBSM__ "; // tag for verbose debugging
+
+    static uint64_t packHead(uint32_t index, uint32_t tag)
+    {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+    static uint32_t headIndex(uint64_t head)
+    {
+        return static_cast<uint32_t>(head);
+    }
+
+    static uint32_t headTag(uint64_t head)
+    {
+        return static_cast<uint32_t>(head >> 32);
+    }
+
+    FreeBlock* blockAt(uint32_t index) const
+    {
+        return reinterpret_cast<FreeBlock*>(mSegment + (index - 1) * ACTUAL_BLOCK_SZ);
+    }
+
+    static_assert(ACTUAL_BLOCK_SZ >= sizeof(FreeBlock), "Block is too small");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Stack head must be lock-free");
+
+    char* mSegment;
+    size_t mBlocksNum;
+    std::unique_ptr<std::atomic<uint8_t>[]> mBlockStates; // by index - 1
+
+    alignas(64) std::atomic<uint64_t> mHead; // on its own cache line
+
+    // Statistics, relaxed:
+    alignas(64) std::atomic<uint64_t> mAllocsNum;
+    std::atomic<uint64_t> mFreesNum;
+    std::atomic<uint64_t> mFailedAllocsNum;
+    std::atomic<size_t> mPeakOccupiedBlocks;
+};
+
+template <size_t BLOCK_SZ>
+FixedBlockSegmentManager<BLOCK_SZ>::FixedBlockSegmentManager(char* segment,
+                                                             size_t size, bool verboseDebugging) :
+    mSegment(segment),
+    mBlocksNum(0),
+    mBlockStates(),
+    mHead(packHead(NULL_INDEX, 0)),
+    mAllocsNum(0),
+    mFreesNum(0),
+    mFailedAllocsNum(0),
+    mPeakOccupiedBlocks(0)
+{
+    assert(segment != nullptr && size != 0);
+
+    // Skip the misaligned head of the segment (if any):
+    size_t misalignment = reinterpret_cast<uintptr_t>(mSegment) % alignof(std::max_align_t);
+    if (misalignment != 0)
+    {
+        size_t skip = alignof(std::max_align_t) - misalignment;
+        mSegment += skip;
+        size = size > skip ? size - skip : 0;
+    }
+
+    mBlocksNum = size / ACTUAL_BLOCK_SZ;
+    if (0 == mBlocksNum)
+    {
+        throw std::runtime_error("Segment is too small to be used");
+    }
+    if (mBlocksNum >= UINT32_MAX)
+    {
+        throw std::runtime_error("Segment is too large to be used");
+    }
+
+    mBlockStates.reset(new std::atomic<uint8_t>[mBlocksNum]()); // all FREE
+
+    // Initially the blocks are stacked in address order
+    for (uint32_t index = 1; index <= mBlocksNum; index++)
+    {
+        new (blockAt(index)) FreeBlock(index < mBlocksNum ? index + 1 : NULL_INDEX);
+    }
+    mHead.store(packHead(1, 0), std::memory_order_release);
+
+    if (verboseDebugging)
+    {
+        std::cout << V_LOG_TAG << "Segment size: " << size << ", base addr: " << reinterpret_cast<long>((void*)mSegment)
+                  << ", block size: " << ACTUAL_BLOCK_SZ << " bytes, blocks: " << mBlocksNum << std::endl;
+    }
+}
+
+template <size_t BLOCK_SZ>
+void* FixedBlockSegmentManager<BLOCK_SZ>::alloc(size_t neededBytes)
+{
+    if (neededBytes > BLOCK_SZ)
+    {
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    uint64_t head = mHead.load(std::memory_order_acquire);
+    while (headIndex(head) != NULL_INDEX)
+    {
+        // The block might be popped & overwritten by another thread in the meantime; then the
+        // tag has changed and the CAS below fails, so the stale value read here is never used.
+        uint32_t next = blockAt(headIndex(head))->load(std::memory_order_relaxed);
+        if (mHead.compare_exchange_weak(head, packHead(next, headTag(head) + 1),
+                                        std::memory_order_acquire, std::memory_order_acquire))
+        {
+            // Nobody can free the block before it's returned, so it's surely marked free here
+            mBlockStates[headIndex(head) - 1].exchange(ALLOCATED, std::memory_order_relaxed);
+
+            // Approximate under concurrency, but never below the actual peak for long
+            size_t occupied = mAllocsNum.fetch_add(1, std::memory_order_relaxed) + 1 -
+                              mFreesNum.load(std::memory_order_relaxed);
+            size_t peak = mPeakOccupiedBlocks.load(std::memory_order_relaxed);
+            while (occupied > peak &&
+                   !mPeakOccupiedBlocks.compare_exchange_weak(peak, occupied, std::memory_order_relaxed))
+            {
+            }
+            return blockAt(headIndex(head));
+        }
+    }
+    mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+template <size_t BLOCK_SZ>
+void* FixedBlockSegmentManager<BLOCK_SZ>::alloc(size_t neededBytes, size_t alignment)
+{
+    if (alignment > alignof(std::max_align_t))
+    {
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return alloc(neededBytes);
+}
+
+template <size_t BLOCK_SZ>
+void FixedBlockSegmentManager<BLOCK_SZ>::free(void* addr)
+{
+    switch (tryFree(addr))
+    {
+    case AllocError::None:
+        break;
+    case AllocError::NullPointer:
+        throw std::invalid_argument("Cannot free a null pointer");
+    case AllocError::DoubleFree:
+        throw std::runtime_error("Memory block is already freed");
+    default:
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+}
+
+template <size_t BLOCK_SZ>
+AllocError FixedBlockSegmentManager<BLOCK_SZ>::tryFree(void* addr) noexcept
+{
+    if (nullptr == addr)
+    {
+        return AllocError::NullPointer;
+    }
+
+    // Ensure the block belongs to us:
+    char* block = static_cast<char*>(addr);
+    if (block < mSegment || block >= mSegment + mBlocksNum * ACTUAL_BLOCK_SZ ||
+        (block - mSegment) % ACTUAL_BLOCK_SZ != 0)
+    {
+        return AllocError::InvalidPointer;
+    }
+
+    uint32_t index = static_cast<uint32_t>((block - mSegment) / ACTUAL_BLOCK_SZ) + 1;
+    // Of concurrent double frees, only one gets ALLOCATED back
+    if (FREE == mBlockStates[index - 1].exchange(FREE, std::memory_order_relaxed))
+    {
+        return AllocError::DoubleFree;
+    }
+    FreeBlock* freeBlock = new (block) FreeBlock(NULL_INDEX);
+
+    uint64_t head = mHead.load(std::memory_order_relaxed);
+    do
+    {
+        freeBlock->store(headIndex(head), std::memory_order_relaxed);
+    }
+    while (!mHead.compare_exchange_weak(head, packHead(index, headTag(head) + 1),
+                                        std::memory_order_release, std::memory_order_relaxed));
+    mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    return AllocError::None;
+}
+
+template <size_t BLOCK_SZ>
+SegmentManagerStats FixedBlockSegmentManager<BLOCK_SZ>::getStats() const
+{
+    SegmentManagerStats stats;
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    stats.failedAllocsNum = mFailedAllocsNum.load(std::memory_order_relaxed);
+
+    size_t occupiedBlocks = stats.allocsNum >= stats.freesNum ? stats.allocsNum - stats.freesNum : 0;
+    if (occupiedBlocks > mBlocksNum)
+    {
+        occupiedBlocks = mBlocksNum;
+    }
+    stats.segmentBytes = mBlocksNum * ACTUAL_BLOCK_SZ;
+    stats.committedBytes = stats.segmentBytes;
+    stats.residentBytes = stats.segmentBytes; // never purged
+    stats.occupiedBytes = occupiedBlocks * ACTUAL_BLOCK_SZ;
+    stats.freeBytes = stats.segmentBytes - stats.occupiedBytes;
+    stats.peakOccupiedBytes = mPeakOccupiedBlocks.load(std::memory_order_relaxed) * ACTUAL_BLOCK_SZ;
+
+    // Free blocks are all alike, and any of them is as good as a larger one: no fragmentation
+    for (size_t i = occupiedBlocks; i < mBlocksNum; i++)
+    {
+        stats.addFreeBlock(ACTUAL_BLOCK_SZ);
+    }
+    return stats;
+}
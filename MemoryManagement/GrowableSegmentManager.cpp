@@ -0,0 +1,93 @@
+#include "GrowableSegmentManager.hpp"
+
+const size_t GrowableSegmentManager::DEFAULT_GROW_STEP = 1024 * 1024; // 1MB
+
+GrowableSegmentManager::GrowableSegmentManager(size_t initialSize, size_t maxSize,
+                                               size_t growStep, bool verboseDebugging) :
+    mSegment(maxSize, initialSize),
+    mManager(mSegment.data(), mSegment.getCommittedSize(), verboseDebugging),
+    mGrowStep(growStep),
+    mGrowMutex()
+{
+}
+
+void* GrowableSegmentManager::alloc(size_t neededBytes)
+{
+    void* retAddr = mManager.alloc(neededBytes);
+    while (nullptr == retAddr && grow(neededBytes))
+    {
+        retAddr = mManager.alloc(neededBytes);
+    }
+    return retAddr;
+}
+
+void* GrowableSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    void* retAddr = mManager.alloc(neededBytes, alignment);
+    while (nullptr == retAddr && grow(neededBytes + alignment))
+    {
+        retAddr = mManager.alloc(neededBytes, alignment);
+    }
+    return retAddr;
+}
+
+void GrowableSegmentManager::free(void* addr)
+{
+    mManager.free(addr);
+}
+
+bool GrowableSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    if (mManager.tryExpand(addr, newBytes))
+    {
+        return true;
+    }
+    // Growing the segment makes room only for the last block (with or without the free tail after it);
+    // committing more for any other block would just inflate the segment on every attempt
+    return mManager.reachesEnd(addr) && grow(newBytes) && mManager.tryExpand(addr, newBytes);
+}
+
+void GrowableSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    mManager.shrink(addr, newBytes);
+}
+
+void* GrowableSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    void* retAddr = mManager.realloc(addr, newBytes);
+    while (nullptr == retAddr && grow(newBytes))
+    {
+        retAddr = mManager.realloc(addr, newBytes);
+    }
+    return retAddr;
+}
+
+size_t GrowableSegmentManager::getCommittedSize() const
+{
+    std::lock_guard<std::mutex> lock(mGrowMutex);
+    return mSegment.getCommittedSize();
+}
+
+bool GrowableSegmentManager::grow(size_t neededBytes)
+{
+    std::lock_guard<std::mutex> lock(mGrowMutex);
+
+    size_t oldSize = mSegment.getCommittedSize();
+    // Room for the block along with its CB, even if the free tail of the segment can't be merged with:
+    size_t growBytes = neededBytes + 2 * SimpleSegmentManager::BLOCK_OVERHEAD;
+    if (growBytes < mGrowStep)
+    {
+        growBytes = mGrowStep;
+    }
+    if (oldSize + growBytes > mSegment.getReservedSize())
+    {
+        growBytes = mSegment.getReservedSize() - oldSize; // the last bit of the reserve
+    }
+    if (0 == growBytes || !mSegment.commit(oldSize + growBytes))
+    {
+        return false;
+    }
+
+    mManager.extend(mSegment.getCommittedSize() - oldSize);
+    return true;
+}
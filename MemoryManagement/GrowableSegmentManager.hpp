@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MmapSegment.hpp"
+#include "SimpleSegmentManager.hpp"
+
+#include <mutex>
+
+/**
+ * This class manages a segment that starts small and grows in place on demand, so there's no need
+ * to size it for the worst case. The segment is an @MmapSegment of @maxSize reserved bytes, of which
+ * @initialSize bytes are committed at first; whenever @SimpleSegmentManager can't satisfy a request,
+ * at least @growStep more bytes get committed and handed over to it. Allocation fails only when the
+ * reserved range is exhausted.
+ *
+ * Unlike the other segment managers, GrowableSegmentManager owns its segment.
+ */
+class GrowableSegmentManager
+{
+public:
+    GrowableSegmentManager(size_t initialSize,
+                           size_t maxSize,
+                           size_t growStep = DEFAULT_GROW_STEP,
+                           bool verboseDebugging = false);
+    ~GrowableSegmentManager() = default;
+
+    GrowableSegmentManager(const GrowableSegmentManager& rhs) = delete;
+    GrowableSegmentManager& operator= (const GrowableSegmentManager& rhs) = delete;
+    GrowableSegmentManager(GrowableSegmentManager&& rhs) = delete;
+    GrowableSegmentManager& operator= (GrowableSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    size_t getCommittedSize() const;
+
+    // Free pages of the committed part are given back to the OS as @SimpleSegmentManager::setPurging() describes
+    void setPurging(SimpleSegmentManager::PurgeMode mode,
+                    std::chrono::milliseconds decayTime = SimpleSegmentManager::DEFAULT_DECAY_TIME)
+    {
+        mManager.setPurging(mode, decayTime);
+    }
+    size_t purge()
+    {
+        return mManager.purge();
+    }
+
+    // Statistics of the committed part of the segment
+    SegmentManagerStats getStats() const
+    {
+        return mManager.getStats();
+    }
+    size_t getMaxSize() const
+    {
+        return mSegment.getReservedSize();
+    }
+
+    static const size_t DEFAULT_GROW_STEP; // bytes
+
+private:
+    bool grow(size_t neededBytes);
+
+    MmapSegment mSegment;
+    SimpleSegmentManager mManager;
+    size_t mGrowStep; // bytes
+
+    mutable std::mutex mGrowMutex;
+};
@@ -0,0 +1,236 @@
+#include "HeapProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+
+#include <execinfo.h>
+
+namespace mybicycles
+{
+
+namespace
+{
+    // The frame of sample() itself; the allocator's frame stays, as it might have been inlined into its caller
+    const int SKIPPED_FRAMES = 1;
+
+    // Allocations of @bytes each a sample of that size stands for
+    double sampleWeight(size_t bytes, size_t samplingInterval)
+    {
+        return 1.0 / (1.0 - std::exp(-static_cast<double>(bytes) / samplingInterval));
+    }
+}
+
+HeapProfiler& HeapProfiler::instance()
+{
+    static HeapProfiler sInstance;
+    return sInstance;
+}
+
+void HeapProfiler::start(size_t samplingInterval)
+{
+    mSamplingInterval.store(std::max<size_t>(1, samplingInterval), std::memory_order_relaxed);
+    sActive.store(true, std::memory_order_relaxed);
+}
+
+void HeapProfiler::stop()
+{
+    sActive.store(false, std::memory_order_relaxed);
+}
+
+void HeapProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& [addr, sample] : mSamples)
+    {
+        sMaybeSampled[filterIndex(addr)].fetch_sub(1, std::memory_order_relaxed);
+    }
+    sSampledLiveNum.fetch_sub(mSamples.size(), std::memory_order_relaxed);
+    mSamples.clear();
+    mSites.clear();
+    mSiteIndices.clear();
+}
+
+int64_t HeapProfiler::nextSampleCountdown()
+{
+    thread_local std::unique_ptr<std::mt19937_64> tRng;
+    if (!tRng)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        tRng = std::make_unique<std::mt19937_64>(++mThreadsSeeded); // reproducible for a given thread order
+    }
+    std::exponential_distribution<double> interval(1.0 / getSamplingInterval());
+    return static_cast<int64_t>(interval(*tRng)) + 1;
+}
+
+__attribute__((noinline)) void HeapProfiler::sample(const void* addr, size_t bytes)
+{
+    if (!tCountdownStarted)
+    {
+        // The thread's first countdown starts at a random point too, so its first allocation isn't always sampled
+        tCountdownStarted = true;
+        tBytesUntilSample += nextSampleCountdown();
+        if (tBytesUntilSample >= 0)
+        {
+            return;
+        }
+    }
+    tBytesUntilSample = nextSampleCountdown();
+
+    void* frames[MAX_FRAMES + SKIPPED_FRAMES];
+    int framesNum = backtrace(frames, static_cast<int>(MAX_FRAMES + SKIPPED_FRAMES));
+    std::vector<void*> stack(frames + std::min(framesNum, SKIPPED_FRAMES), frames + framesNum);
+    double weight = sampleWeight(bytes, getSamplingInterval());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto [it, inserted] = mSiteIndices.emplace(std::move(stack), mSites.size());
+    if (inserted)
+    {
+        mSites.emplace_back();
+        mSites.back().stack = it->first;
+    }
+    Site& site = mSites[it->second];
+    site.sampledLiveObjects++;
+    site.sampledLiveBytes += bytes;
+    site.sampledTotalObjects++;
+    site.sampledTotalBytes += bytes;
+    site.liveObjects += weight;
+    site.liveBytes += weight * bytes;
+    site.totalObjects += weight;
+    site.totalBytes += weight * bytes;
+
+    auto stale = mSamples.find(addr);
+    if (stale != mSamples.end())
+    {
+        dropSampleUnlocked(stale); // freed bypassing the allocators, e.g. by a segment manager's reset
+    }
+    mSamples.emplace(addr, Sample{it->second, bytes, weight});
+    sMaybeSampled[filterIndex(addr)].fetch_add(1, std::memory_order_relaxed);
+    sSampledLiveNum.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HeapProfiler::forget(const void* addr)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSamples.find(addr);
+    if (it != mSamples.end()) // otherwise another address with the same hash was sampled
+    {
+        dropSampleUnlocked(it);
+    }
+}
+
+void HeapProfiler::resize(const void* addr, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSamples.find(addr);
+    if (it != mSamples.end())
+    {
+        Sample& sample = it->second;
+        Site& site = mSites[sample.siteIndex];
+        site.sampledLiveBytes = site.sampledLiveBytes - sample.bytes + bytes;
+        site.liveBytes += sample.weight * (static_cast<double>(bytes) - static_cast<double>(sample.bytes));
+        sample.bytes = bytes;
+    }
+}
+
+void HeapProfiler::dropSampleUnlocked(std::unordered_map<const void*, Sample>::iterator it)
+{
+    const Sample& sample = it->second;
+    Site& site = mSites[sample.siteIndex];
+    site.sampledLiveObjects--;
+    site.sampledLiveBytes -= sample.bytes;
+    site.liveObjects -= sample.weight;
+    site.liveBytes -= sample.weight * sample.bytes;
+    sMaybeSampled[filterIndex(it->first)].fetch_sub(1, std::memory_order_relaxed);
+    sSampledLiveNum.fetch_sub(1, std::memory_order_relaxed);
+    mSamples.erase(it);
+}
+
+std::vector<HeapProfiler::Site> HeapProfiler::getSites() const
+{
+    std::vector<Site> sites;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        sites = mSites;
+    }
+    std::stable_sort(sites.begin(), sites.end(), [](const Site& lhs, const Site& rhs) {
+        return lhs.liveBytes > rhs.liveBytes;
+    });
+    return sites;
+}
+
+void HeapProfiler::write(std::ostream& os, Format format) const
+{
+    std::vector<Site> sites = getSites();
+
+    if (Format::Pprof == format)
+    {
+        // Raw sample counts: pprof scales them up by the interval given in the header
+        size_t liveObjects = 0, liveBytes = 0, totalObjects = 0, totalBytes = 0;
+        for (const auto& site : sites)
+        {
+            liveObjects += site.sampledLiveObjects;
+            liveBytes += site.sampledLiveBytes;
+            totalObjects += site.sampledTotalObjects;
+            totalBytes += site.sampledTotalBytes;
+        }
+        os << "heap profile: " << liveObjects << ": " << liveBytes << " [" << totalObjects << ": " << totalBytes
+           << "] @ heap_v2/" << getSamplingInterval() << "\n";
+        for (const auto& site : sites)
+        {
+            os << site.sampledLiveObjects << ": " << site.sampledLiveBytes << " [" << site.sampledTotalObjects
+               << ": " << site.sampledTotalBytes << "] @";
+            for (void* frame : site.stack)
+            {
+                os << " " << frame;
+            }
+            os << "\n";
+        }
+
+        // So that pprof can symbolize the addresses
+        os << "\nMAPPED_LIBRARIES:\n";
+        std::ifstream maps("/proc/self/maps");
+        os << maps.rdbuf();
+        os.flush();
+        return;
+    }
+
+    double liveObjects = 0.0, liveBytes = 0.0;
+    for (const auto& site : sites)
+    {
+        liveObjects += site.liveObjects;
+        liveBytes += site.liveBytes;
+    }
+    os << "Heap profile (sampling every " << getSamplingInterval() << " bytes): " << sites.size() << " sites, "
+       << std::llround(liveBytes) << " live bytes in " << std::llround(liveObjects) << " objects (estimated)\n";
+    for (const auto& site : sites)
+    {
+        os << "\n" << std::setw(12) << std::llround(site.liveBytes) << " live bytes in "
+           << std::llround(site.liveObjects) << " objects, " << std::llround(site.totalBytes) << " bytes in "
+           << std::llround(site.totalObjects) << " objects allocated in total\n";
+        char** symbols = backtrace_symbols(site.stack.data(), static_cast<int>(site.stack.size()));
+        for (size_t i = 0; i < site.stack.size(); i++)
+        {
+            os << "    #" << i << " " << (symbols != nullptr ? symbols[i] : "?") << "\n";
+        }
+        std::free(symbols);
+    }
+    os.flush();
+}
+
+bool HeapProfiler::dump(const std::string& path, Format format) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    write(file, format);
+    return static_cast<bool>(file);
+}
+
+} // mybicycles
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mybicycles
+{
+
+/**
+ * A sampling heap profiler for the MyAllocator* allocators: tells which call sites the live memory of
+ * the segments was allocated from.
+ *
+ * Like tcmalloc's, it samples allocations rather than bytes: every thread counts down the bytes it
+ * allocates, and the allocation which crosses zero gets its stack trace taken (with backtrace()) and
+ * is remembered until it's deallocated; the next countdown is drawn from an exponential distribution
+ * with the mean of the sampling interval. A sample of S bytes then stands for 1 / (1 - e^(-S / interval))
+ * allocations of its size, which makes the per-site estimates unbiased.
+ *
+ * Profiling is off until start() is called. Then an allocation costs a thread-local countdown and a
+ * deallocation costs a lookup in a small table of counters hashed by address, which tells whether the
+ * address might have been sampled; only sampled allocations & their deallocations take the lock.
+ */
+class HeapProfiler
+{
+public:
+    static constexpr size_t DEFAULT_SAMPLING_INTERVAL = 512 * 1024; // bytes
+    static constexpr size_t MAX_FRAMES = 32;
+
+    enum class Format
+    {
+        Flat, // human readable text, the sites by live bytes
+        Pprof // gperftools' legacy heap profile ("heap_v2"), which pprof reads & unsamples itself
+    };
+
+    // Everything known about the allocations from one stack trace
+    struct Site
+    {
+        std::vector<void*> stack; // return addresses, the innermost first
+        // Sampled allocations:
+        size_t sampledLiveObjects = 0;
+        size_t sampledLiveBytes = 0;
+        size_t sampledTotalObjects = 0; // the deallocated ones too
+        size_t sampledTotalBytes = 0;
+        // The estimates of all the allocations the samples stand for:
+        double liveObjects = 0.0;
+        double liveBytes = 0.0;
+        double totalObjects = 0.0;
+        double totalBytes = 0.0;
+    };
+
+    static HeapProfiler& instance();
+
+    /**
+     * Starts sampling allocations, about one per @samplingInterval bytes allocated by a thread.
+     */
+    void start(size_t samplingInterval = DEFAULT_SAMPLING_INTERVAL);
+    /**
+     * Stops sampling new allocations; deallocations of the sampled ones are still accounted for.
+     */
+    void stop();
+    /**
+     * Forgets all the samples & sites.
+     */
+    void clear();
+
+    static bool isActive()
+    {
+        return sActive.load(std::memory_order_relaxed);
+    }
+
+    // To be called by the allocators for every block they hand out & take back:
+    static void onAlloc(const void* addr, size_t bytes)
+    {
+        if (isActive())
+        {
+            tBytesUntilSample -= static_cast<int64_t>(bytes);
+            if (tBytesUntilSample < 0)
+            {
+                instance().sample(addr, bytes);
+            }
+        }
+    }
+
+    static void onFree(const void* addr)
+    {
+        if (mightBeSampled(addr))
+        {
+            instance().forget(addr);
+        }
+    }
+
+    // A block resized in place to @bytes: a sample of it keeps standing for as many allocations as before
+    static void onResize(const void* addr, size_t bytes)
+    {
+        if (mightBeSampled(addr))
+        {
+            instance().resize(addr, bytes);
+        }
+    }
+
+    /**
+     * The sites seen so far, the ones with the most live bytes first.
+     */
+    std::vector<Site> getSites() const;
+
+    size_t getSamplingInterval() const
+    {
+        return mSamplingInterval.load(std::memory_order_relaxed);
+    }
+
+    void write(std::ostream& os, Format format) const;
+    /**
+     * Writes the profile into the file at @path. Returns false if the file can't be written.
+     */
+    bool dump(const std::string& path, Format format) const;
+
+private:
+    static constexpr size_t FILTER_SIZE = 64 * 1024; // a power of 2
+
+    struct Sample
+    {
+        size_t siteIndex;
+        size_t bytes;
+        double weight; // allocations the sample stands for
+    };
+
+    HeapProfiler() = default;
+
+    static size_t filterIndex(const void* addr)
+    {
+        uint64_t key = reinterpret_cast<uintptr_t>(addr) >> 4;
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 48) & (FILTER_SIZE - 1);
+    }
+
+    static bool mightBeSampled(const void* addr)
+    {
+        return sSampledLiveNum.load(std::memory_order_relaxed) != 0 &&
+               sMaybeSampled[filterIndex(addr)].load(std::memory_order_relaxed) != 0;
+    }
+
+    void sample(const void* addr, size_t bytes);
+    void forget(const void* addr);
+    void resize(const void* addr, size_t bytes);
+    void dropSampleUnlocked(std::unordered_map<const void*, Sample>::iterator it);
+    int64_t nextSampleCountdown();
+
+    static inline std::atomic<bool> sActive{false};
+    static inline std::atomic<size_t> sSampledLiveNum{0};
+    // How many live samples hash to each index: 0 means the address surely wasn't sampled
+    static inline std::atomic<uint32_t> sMaybeSampled[FILTER_SIZE];
+    static inline thread_local int64_t tBytesUntilSample = 0;
+    static inline thread_local bool tCountdownStarted = false;
+
+    std::atomic<size_t> mSamplingInterval{DEFAULT_SAMPLING_INTERVAL};
+
+    mutable std::mutex mMutex; // guards all of the below
+    std::map<std::vector<void*>, size_t> mSiteIndices;
+    std::vector<Site> mSites;
+    std::unordered_map<const void*, Sample> mSamples; // live sampled allocations
+    uint64_t mThreadsSeeded = 0;
+};
+
+} // mybicycles
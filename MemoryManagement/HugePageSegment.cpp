@@ -0,0 +1,155 @@
+#include "HugePageSegment.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t DEFAULT_HUGE_PAGE_SZ = 2 * 1024 * 1024;
+
+    size_t roundUp(size_t bytes, size_t granularity)
+    {
+        return ((bytes + granularity - 1) / granularity) * granularity;
+    }
+
+    bool transparentHugePagesEnabled()
+    {
+        std::ifstream mode("/sys/kernel/mm/transparent_hugepage/enabled"); // e.g. "always [madvise] never"
+        std::string setting;
+        std::getline(mode, setting);
+        return !setting.empty() && setting.find("[never]") == std::string::npos;
+    }
+
+    // Faults in every page of a mapping which MAP_POPULATE couldn't be used for
+    void populate(char* data, size_t size)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (0 == madvise(data, size, MADV_POPULATE_WRITE))
+        {
+            return;
+        }
+#endif
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (size_t offset = 0; offset < size; offset += page)
+        {
+            data[offset] = 0;
+        }
+    }
+}
+
+size_t HugePageSegment::hugePageSize()
+{
+    static const size_t sHugePageSize = []() {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string key;
+        size_t kiloBytes = 0;
+        while (meminfo >> key)
+        {
+            if ("Hugepagesize:" == key && meminfo >> kiloBytes)
+            {
+                return kiloBytes * 1024;
+            }
+        }
+        return DEFAULT_HUGE_PAGE_SZ;
+    }();
+    return sHugePageSize;
+}
+
+HugePageSegment::HugePageSegment(size_t size, PageMode requestedMode, bool prefault) :
+    mData(nullptr),
+    mSize(0),
+    mPageMode(PageMode::Regular)
+{
+    if (0 == size)
+    {
+        throw std::invalid_argument("Segment size must be non-zero");
+    }
+
+    if (PageMode::Explicit == requestedMode && mapExplicit(size, prefault))
+    {
+        mPageMode = PageMode::Explicit;
+    }
+    else if (requestedMode != PageMode::Regular && mapTransparent(size, prefault))
+    {
+        mPageMode = PageMode::Transparent;
+    }
+    else
+    {
+        mapRegular(size, prefault);
+    }
+}
+
+HugePageSegment::~HugePageSegment()
+{
+    munmap(mData, mSize);
+}
+
+bool HugePageSegment::mapExplicit(size_t size, bool prefault)
+{
+    size = roundUp(size, hugePageSize());
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0), -1, 0);
+    if (MAP_FAILED == mem)
+    {
+        return false; // no (or not enough) reserved huge pages
+    }
+    mData = static_cast<char*>(mem);
+    mSize = size;
+    return true;
+}
+
+bool HugePageSegment::mapTransparent(size_t size, bool prefault)
+{
+    if (!transparentHugePagesEnabled())
+    {
+        return false;
+    }
+
+    // The kernel can use a huge page only for a huge-page-aligned range, so over-map & trim
+    const size_t hugePage = hugePageSize();
+    size = roundUp(size, hugePage);
+    void* mem = mmap(nullptr, size + hugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == mem)
+    {
+        return false;
+    }
+    char* raw = static_cast<char*>(mem);
+    char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(raw), hugePage));
+    if (aligned != raw)
+    {
+        munmap(raw, aligned - raw);
+    }
+    munmap(aligned + size, raw + hugePage - aligned);
+
+    if (0 != madvise(aligned, size, MADV_HUGEPAGE))
+    {
+        munmap(aligned, size); // THP is disabled (or not built in)
+        return false;
+    }
+    mData = aligned;
+    mSize = size;
+    if (prefault)
+    {
+        populate(mData, mSize); // after madvise(), or it'd be populated with regular pages
+    }
+    return true;
+}
+
+void HugePageSegment::mapRegular(size_t size, bool prefault)
+{
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | (prefault ? MAP_POPULATE : 0), -1, 0);
+    if (MAP_FAILED == mem)
+    {
+        throw std::runtime_error(std::string("Cannot map a segment: ") + strerror(errno));
+    }
+    mData = static_cast<char*>(mem);
+    mSize = size;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * This class provides a large anonymous memory segment backed by huge pages where possible, to cut
+ * TLB misses of a segment manager spread over many megabytes. Explicit huge pages (MAP_HUGETLB) need
+ * a pool reserved by the admin; transparent ones (MADV_HUGEPAGE) need THP enabled in "madvise" or
+ * "always" mode. Whatever isn't available, the segment falls back to the next mode down, ending with
+ * regular pages; getPageMode() tells what was obtained.
+ *
+ * With @prefault all the pages are faulted in at construction, so the first touch in the middle of
+ * request handling doesn't pay for it. The segment is unmapped on destruction.
+ */
+class HugePageSegment
+{
+public:
+    enum class PageMode
+    {
+        Regular,
+        Transparent, // THP, promoted by the kernel when it can
+        Explicit // hugetlbfs pages from the reserved pool
+    };
+
+    HugePageSegment(size_t size, PageMode requestedMode = PageMode::Transparent, bool prefault = false);
+    ~HugePageSegment();
+
+    HugePageSegment(const HugePageSegment& rhs) = delete;
+    HugePageSegment& operator= (const HugePageSegment& rhs) = delete;
+    HugePageSegment(HugePageSegment&& rhs) = delete;
+    HugePageSegment& operator= (HugePageSegment&& rhs) = delete;
+
+    char* data() const
+    {
+        return mData;
+    }
+
+    // Might exceed the requested size: huge page modes round it up to whole huge pages
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    PageMode getPageMode() const
+    {
+        return mPageMode;
+    }
+
+    static size_t hugePageSize();
+
+private:
+    bool mapExplicit(size_t size, bool prefault);
+    bool mapTransparent(size_t size, bool prefault);
+    void mapRegular(size_t size, bool prefault);
+
+    char* mData;
+    size_t mSize; // bytes
+    PageMode mPageMode;
+};
@@ -0,0 +1,25 @@
+#include "MappedFileSegmentManager.hpp"
+
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    // Where the heap stored in the file at @path wants to be mapped (nullptr for a new file)
+    void* preferredAddress(const std::string& path)
+    {
+        std::vector<char> header(PersistentSegmentManager::HEADER_SIZE);
+        std::ifstream file(path, std::ios::binary);
+        if (!file.read(header.data(), header.size()))
+        {
+            return nullptr;
+        }
+        return PersistentSegmentManager::formattedAt(header.data(), header.size());
+    }
+}
+
+MappedFileSegmentManager::MappedFileSegmentManager(const std::string& path, size_t size, bool verboseDebugging) :
+    mSegment(path, size, preferredAddress(path)),
+    mManager(mSegment.data(), mSegment.size(), verboseDebugging)
+{
+}
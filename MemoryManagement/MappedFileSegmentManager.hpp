@@ -0,0 +1,98 @@
+#pragma once
+
+#include "FileSegment.hpp"
+#include "PersistentSegmentManager.hpp"
+
+#include <string>
+
+/**
+ * This class manages a heap kept in a file: a @FileSegment managed by a @PersistentSegmentManager.
+ * Opening an existing heap file restores the heap, including all the objects allocated from it
+ * (e.g. through MyAllocatorNonOwning), with no parsing or copying; getRoot() leads to them.
+ * The file is mapped at the address the heap was created at, so objects with raw pointers inside
+ * stay valid; isRelocated() tells if that address was taken. Only one process at a time may open
+ * the file (see SharedMemorySegmentManager for sharing a heap).
+ *
+ * Like GrowableSegmentManager, MappedFileSegmentManager owns its segment.
+ */
+class MappedFileSegmentManager
+{
+public:
+    MappedFileSegmentManager(const std::string& path,
+                             size_t size,
+                             bool verboseDebugging = false);
+    ~MappedFileSegmentManager() = default;
+
+    MappedFileSegmentManager(const MappedFileSegmentManager& rhs) = delete;
+    MappedFileSegmentManager& operator= (const MappedFileSegmentManager& rhs) = delete;
+    MappedFileSegmentManager(MappedFileSegmentManager&& rhs) = delete;
+    MappedFileSegmentManager& operator= (MappedFileSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes)
+    {
+        return mManager.alloc(neededBytes);
+    }
+
+    void* alloc(size_t neededBytes, size_t alignment)
+    {
+        return mManager.alloc(neededBytes, alignment);
+    }
+
+    void free(void* addr)
+    {
+        mManager.free(addr);
+    }
+
+    bool tryExpand(void* addr, size_t newBytes)
+    {
+        return mManager.tryExpand(addr, newBytes);
+    }
+
+    void shrink(void* addr, size_t newBytes)
+    {
+        mManager.shrink(addr, newBytes);
+    }
+
+    void* realloc(void* addr, size_t newBytes)
+    {
+        return mManager.realloc(addr, newBytes);
+    }
+
+    SegmentManagerStats getStats() const
+    {
+        return mManager.getStats();
+    }
+
+    void setRoot(const void* root)
+    {
+        mManager.setRoot(root);
+    }
+
+    void* getRoot() const
+    {
+        return mManager.getRoot();
+    }
+
+    bool isRestored() const
+    {
+        return mManager.isRestored();
+    }
+
+    bool isRelocated() const
+    {
+        return mManager.isRelocated();
+    }
+
+    /**
+     * Flushes the heap to the file. Not needed for persistence across restarts (the page cache keeps
+     * the changes), only to survive an OS crash.
+     */
+    bool sync()
+    {
+        return mSegment.sync();
+    }
+
+private:
+    FileSegment mSegment;
+    PersistentSegmentManager mManager;
+};
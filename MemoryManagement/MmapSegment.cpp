@@ -0,0 +1,73 @@
+#include "MmapSegment.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    size_t roundUpToPage(size_t bytes)
+    {
+        size_t page = MmapSegment::pageSize();
+        return ((bytes + page - 1) / page) * page;
+    }
+}
+
+size_t MmapSegment::pageSize()
+{
+    static const size_t sPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return sPageSize;
+}
+
+MmapSegment::MmapSegment(size_t reservedSize, size_t committedSize) :
+    mData(nullptr),
+    mReservedSize(roundUpToPage(reservedSize)),
+    mCommittedSize(0)
+{
+    if (0 == mReservedSize || committedSize > mReservedSize)
+    {
+        throw std::invalid_argument("Committed size must be within a non-empty reserved size");
+    }
+
+    void* mem = mmap(nullptr, mReservedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (MAP_FAILED == mem)
+    {
+        throw std::runtime_error(std::string("Cannot reserve a segment: ") + strerror(errno));
+    }
+    mData = static_cast<char*>(mem);
+
+    if (!commit(committedSize))
+    {
+        munmap(mData, mReservedSize);
+        throw std::runtime_error("Cannot commit the initial part of a segment");
+    }
+}
+
+MmapSegment::~MmapSegment()
+{
+    munmap(mData, mReservedSize);
+}
+
+bool MmapSegment::commit(size_t newCommittedSize)
+{
+    newCommittedSize = roundUpToPage(newCommittedSize);
+    if (newCommittedSize > mReservedSize)
+    {
+        return false;
+    }
+    if (newCommittedSize <= mCommittedSize)
+    {
+        return true;
+    }
+
+    if (0 != mprotect(mData + mCommittedSize, newCommittedSize - mCommittedSize, PROT_READ | PROT_WRITE))
+    {
+        return false;
+    }
+    mCommittedSize = newCommittedSize;
+    return true;
+}
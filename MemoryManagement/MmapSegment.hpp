@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * This class provides a memory segment which can grow in place. It reserves a large contiguous
+ * range of virtual addresses up front (no physical memory or swap is charged for it) and commits
+ * pages at the beginning of that range on demand, so the segment never has to be relocated.
+ * The segment is unmapped on destruction.
+ */
+class MmapSegment
+{
+public:
+    MmapSegment(size_t reservedSize, size_t committedSize);
+    ~MmapSegment();
+
+    MmapSegment(const MmapSegment& rhs) = delete;
+    MmapSegment& operator= (const MmapSegment& rhs) = delete;
+    MmapSegment(MmapSegment&& rhs) = delete;
+    MmapSegment& operator= (MmapSegment&& rhs) = delete;
+
+    /**
+     * Makes the first @newCommittedSize bytes (rounded up to whole pages) of the reserved range usable.
+     * Returns false if that exceeds the reserved range or the OS refuses to commit more memory.
+     */
+    bool commit(size_t newCommittedSize);
+
+    char* data() const
+    {
+        return mData;
+    }
+
+    size_t getCommittedSize() const
+    {
+        return mCommittedSize;
+    }
+
+    size_t getReservedSize() const
+    {
+        return mReservedSize;
+    }
+
+    static size_t pageSize();
+
+private:
+    char* mData;
+    size_t mReservedSize; // bytes
+    size_t mCommittedSize; // bytes
+};
@@ -0,0 +1,241 @@
+#include "MonotonicArenaSegmentManager.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const char* V_LOG_TAG = "__MASM__ "; // tag for verbose debugging
+
+    // Packing of the arena's top: offsets & sizes are in ALIGNMENT units
+    constexpr unsigned LAST_BLOCK_BITS = 24;
+    constexpr uint64_t LAST_BLOCK_MASK = (uint64_t(1) << LAST_BLOCK_BITS) - 1;
+    constexpr unsigned TOP_BITS = 64 - LAST_BLOCK_BITS;
+}
+
+const size_t MonotonicArenaSegmentManager::ALIGNMENT = alignof(std::max_align_t);
+
+MonotonicArenaSegmentManager::MonotonicArenaSegmentManager(char* segment,
+                                                           size_t size, bool verboseDebugging) :
+    mSegment(segment),
+    mSegmentSize(size),
+    mVerboseDebug(verboseDebugging),
+    mTop(0),
+    mDestructors(nullptr),
+    mAllocsNum(0),
+    mFreesNum(0),
+    mFailedAllocsNum(0),
+    mPeakUsedBytes(0)
+{
+    assert(mSegment != nullptr && mSegmentSize != 0);
+
+    // Skip the misaligned head of the segment (if any):
+    size_t misalignment = reinterpret_cast<uintptr_t>(mSegment) % ALIGNMENT;
+    if (misalignment != 0)
+    {
+        size_t skip = ALIGNMENT - misalignment;
+        mSegment += skip;
+        mSegmentSize = mSegmentSize > skip ? mSegmentSize - skip : 0;
+    }
+    mSegmentSize -= mSegmentSize % ALIGNMENT;
+    if (0 == mSegmentSize)
+    {
+        throw std::runtime_error("Segment is too small to be used");
+    }
+    if (mSegmentSize / ALIGNMENT >= (uint64_t(1) << TOP_BITS))
+    {
+        throw std::runtime_error("Segment is too large to be used");
+    }
+
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Segment size: " << mSegmentSize
+                               << ", base addr: " << reinterpret_cast<long>((void*)mSegment) << std::endl;
+    }
+}
+
+uint64_t MonotonicArenaSegmentManager::packTop(size_t topOffset, size_t lastBlockBytes)
+{
+    uint64_t lastBlockUnits = lastBlockBytes / ALIGNMENT;
+    if (lastBlockUnits > LAST_BLOCK_MASK)
+    {
+        lastBlockUnits = 0; // unknown, such a block can't be resized
+    }
+    return (static_cast<uint64_t>(topOffset / ALIGNMENT) << LAST_BLOCK_BITS) | lastBlockUnits;
+}
+
+size_t MonotonicArenaSegmentManager::topOffset(uint64_t top)
+{
+    return (top >> LAST_BLOCK_BITS) * ALIGNMENT;
+}
+
+size_t MonotonicArenaSegmentManager::lastBlockBytes(uint64_t top)
+{
+    return (top & LAST_BLOCK_MASK) * ALIGNMENT;
+}
+
+MonotonicArenaSegmentManager::~MonotonicArenaSegmentManager()
+{
+    runDestructors();
+}
+
+void* MonotonicArenaSegmentManager::alloc(size_t neededBytes)
+{
+    return alloc(neededBytes, ALIGNMENT);
+}
+
+void* MonotonicArenaSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    if (0 == alignment || (alignment & (alignment - 1)) != 0)
+    {
+        return nullptr; // not a power of 2
+    }
+
+    size_t roundedBytes = ((neededBytes + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+    if (0 == roundedBytes)
+    {
+        roundedBytes = ALIGNMENT;
+    }
+
+    uint64_t top = mTop.load(std::memory_order_relaxed);
+    size_t alignedOffset = 0;
+    do
+    {
+        size_t offset = topOffset(top);
+        // The segment's base is aligned to ALIGNMENT only, so align the address rather than the offset
+        uintptr_t addr = reinterpret_cast<uintptr_t>(mSegment) + offset;
+        alignedOffset = offset + (((addr + alignment - 1) & ~(uintptr_t)(alignment - 1)) - addr);
+        if (alignedOffset > mSegmentSize || roundedBytes > mSegmentSize - alignedOffset)
+        {
+            if (mVerboseDebug)
+            {
+                std::cout << V_LOG_TAG << "Allocation failure for " << neededBytes << " bytes" << std::endl;
+            }
+            mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    while (!mTop.compare_exchange_weak(top, packTop(alignedOffset + roundedBytes, roundedBytes),
+                                       std::memory_order_relaxed));
+
+    mAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    return mSegment + alignedOffset;
+}
+
+bool MonotonicArenaSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    size_t blockOffset = static_cast<char*>(addr) - mSegment;
+    size_t roundedBytes = ((newBytes + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+    if (0 == roundedBytes)
+    {
+        roundedBytes = ALIGNMENT;
+    }
+
+    uint64_t top = mTop.load(std::memory_order_relaxed);
+    do
+    {
+        // Only the block at the top of the arena can be resized
+        size_t lastBlockSize = lastBlockBytes(top);
+        if (0 == lastBlockSize || topOffset(top) - lastBlockSize != blockOffset)
+        {
+            return false;
+        }
+        if (roundedBytes <= lastBlockSize)
+        {
+            return true;
+        }
+        if (roundedBytes > mSegmentSize - blockOffset)
+        {
+            return false;
+        }
+    }
+    while (!mTop.compare_exchange_weak(top, packTop(blockOffset + roundedBytes, roundedBytes),
+                                       std::memory_order_relaxed));
+    return true;
+}
+
+void MonotonicArenaSegmentManager::shrink(void*, size_t)
+{
+    // Shrinking the top block would be possible, but a vector shrinks just before it's freed anyway
+}
+
+void* MonotonicArenaSegmentManager::realloc(void* addr, size_t oldBytes, size_t newBytes)
+{
+    if (nullptr == addr)
+    {
+        return alloc(newBytes);
+    }
+    if (newBytes <= oldBytes || tryExpand(addr, newBytes))
+    {
+        return addr; // shrinking gives nothing back anyway
+    }
+
+    void* newAddr = alloc(newBytes);
+    if (newAddr != nullptr)
+    {
+        std::memcpy(newAddr, addr, oldBytes);
+    }
+    return newAddr;
+}
+
+void MonotonicArenaSegmentManager::registerDestructor(DestructorEntry* entry)
+{
+    entry->next = mDestructors.load(std::memory_order_relaxed);
+    while (!mDestructors.compare_exchange_weak(entry->next, entry, std::memory_order_release,
+                                               std::memory_order_relaxed))
+    {
+    }
+}
+
+void MonotonicArenaSegmentManager::runDestructors()
+{
+    DestructorEntry* entry = mDestructors.exchange(nullptr, std::memory_order_acquire);
+    while (entry != nullptr)
+    {
+        DestructorEntry* next = entry->next;
+        entry->destroy(entry->object);
+        entry = next;
+    }
+}
+
+void MonotonicArenaSegmentManager::reset()
+{
+    runDestructors();
+
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Reset, " << getUsedBytes()
+                               << " bytes released" << std::endl;
+    }
+    size_t usedBytes = getUsedBytes();
+    if (usedBytes > mPeakUsedBytes.load(std::memory_order_relaxed))
+    {
+        mPeakUsedBytes.store(usedBytes, std::memory_order_relaxed);
+    }
+    mTop.store(0, std::memory_order_relaxed);
+}
+
+SegmentManagerStats MonotonicArenaSegmentManager::getStats() const
+{
+    SegmentManagerStats stats;
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    stats.failedAllocsNum = mFailedAllocsNum.load(std::memory_order_relaxed);
+
+    stats.segmentBytes = mSegmentSize;
+    stats.committedBytes = stats.segmentBytes;
+    stats.residentBytes = stats.segmentBytes; // never purged
+    stats.occupiedBytes = getUsedBytes();
+    stats.freeBytes = mSegmentSize - stats.occupiedBytes;
+    size_t peakBytes = mPeakUsedBytes.load(std::memory_order_relaxed);
+    stats.peakOccupiedBytes = peakBytes > stats.occupiedBytes ? peakBytes : stats.occupiedBytes;
+    if (stats.freeBytes > 0)
+    {
+        stats.addFreeBlock(stats.freeBytes);
+    }
+    stats.updateFragmentation();
+    return stats;
+}
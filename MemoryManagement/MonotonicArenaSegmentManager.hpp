@@ -0,0 +1,137 @@
+#pragma once
+
+#include "SegmentManagerStats.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * This class is meant for request-scoped memory: everything allocated from the segment is thrown
+ * away at once. alloc() just bumps a pointer, free() does nothing, and reset() makes the whole
+ * segment available again.
+ *
+ * Objects created via create() are additionally put into a destructor registry (unless they are
+ * trivially destructible) and are destroyed in bulk, in reverse order of creation, on reset() or on
+ * destruction of the arena. The registry entries are allocated from the segment itself.
+ *
+ * alloc(), free() and create() are thread-safe; reset() must not run concurrently with them.
+ * MonotonicArenaSegmentManager is not responsible for destruction of the memory it manages.
+ */
+class MonotonicArenaSegmentManager
+{
+public:
+    MonotonicArenaSegmentManager(char* segment,
+                                 size_t size,
+                                 bool verboseDebugging = false);
+    ~MonotonicArenaSegmentManager();
+
+    MonotonicArenaSegmentManager(const MonotonicArenaSegmentManager& rhs) = delete;
+    MonotonicArenaSegmentManager& operator= (const MonotonicArenaSegmentManager& rhs) = delete;
+    MonotonicArenaSegmentManager(MonotonicArenaSegmentManager&& rhs) = delete;
+    MonotonicArenaSegmentManager& operator= (MonotonicArenaSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void*)
+    {
+        mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Only the most recently allocated block can be resized in place (which is what a growing
+     * vector needs); realloc() of any other block allocates a new one. Memory is never given back.
+     * The arena doesn't record the blocks' sizes, so realloc() is told the block's @oldBytes.
+     */
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t oldBytes, size_t newBytes);
+
+    /**
+     * Constructs T in the arena; T's destructor is called on reset().
+     * Returns nullptr if the arena is exhausted.
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args);
+
+    /**
+     * Destroys all the objects created via create() and releases all the allocated memory at once.
+     */
+    void reset();
+
+    size_t getUsedBytes() const
+    {
+        return topOffset(mTop.load(std::memory_order_relaxed));
+    }
+
+    size_t getCapacity() const
+    {
+        return mSegmentSize;
+    }
+
+    // The free space is the single block above the top of the arena; peak usage is kept across resets
+    SegmentManagerStats getStats() const;
+
+private:
+    struct DestructorEntry
+    {
+        void (*destroy)(void*);
+        void* object;
+        DestructorEntry* next;
+    };
+
+    static uint64_t packTop(size_t topOffset, size_t lastBlockBytes);
+    static size_t topOffset(uint64_t top);
+    static size_t lastBlockBytes(uint64_t top);
+
+    void registerDestructor(DestructorEntry* entry);
+    void runDestructors();
+
+    char* mSegment;
+    size_t mSegmentSize; // bytes
+    bool mVerboseDebug;
+
+    // The top of the arena (bytes allocated so far) along with the size of the most recently allocated
+    // block, packed into a single word so that both can be updated by one CAS
+    std::atomic<uint64_t> mTop;
+    std::atomic<DestructorEntry*> mDestructors; // the most recently created object first
+
+    // Statistics, relaxed:
+    std::atomic<uint64_t> mAllocsNum;
+    std::atomic<uint64_t> mFreesNum;
+    std::atomic<uint64_t> mFailedAllocsNum;
+    std::atomic<size_t> mPeakUsedBytes; // as of the last reset
+
+    // Alignment (and granularity) of every allocation:
+    static const size_t ALIGNMENT;
+};
+
+template <typename T, typename... Args>
+T* MonotonicArenaSegmentManager::create(Args&&... args)
+{
+    void* mem = alloc(sizeof(T), alignof(T));
+    if (nullptr == mem)
+    {
+        return nullptr;
+    }
+
+    if constexpr (std::is_trivially_destructible<T>::value)
+    {
+        return new (mem) T(std::forward<Args>(args)...);
+    }
+    else
+    {
+        void* entryMem = alloc(sizeof(DestructorEntry));
+        if (nullptr == entryMem)
+        {
+            return nullptr;
+        }
+        T* obj = new (mem) T(std::forward<Args>(args)...);
+        DestructorEntry* entry = new (entryMem) DestructorEntry{[](void* p) { static_cast<T*>(p)->~T(); }, obj, nullptr};
+        registerDestructor(entry);
+        return obj;
+    }
+}
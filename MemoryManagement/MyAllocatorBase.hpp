@@ -1,8 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
-#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 
+#include "AllocError.hpp"
+#include "AllocationAccounting.hpp"
+#include "BulkAllocationScope.hpp"
+#include "HeapProfiler.hpp"
+#include "SegmentManagerStats.hpp"
 #include "SharedPtr.hpp"
 
 /*
@@ -35,61 +46,270 @@ an allocator instance for those different types.
 namespace mybicycles
 {
 
+// Whether a segment manager has a sized free(addr, size), which spares it from looking the size up
+template <typename SegmentManagerType, typename = void>
+struct HasSizedFree : std::false_type
+{
+};
+
+template <typename SegmentManagerType>
+struct HasSizedFree<SegmentManagerType,
+                    std::void_t<decltype(std::declval<SegmentManagerType&>().free(nullptr, size_t()))>> : std::true_type
+{
+};
+
 /**
- * Common functionality for the MyAllocator* custom allocators.
+ * Allocates memory for @n objects of T from @segmentManager, returning nullptr & the reason on failure
+ * rather than throwing: for the callers which handle exhaustion by themselves & can't afford unwinding.
  */
 template <typename T, typename SegmentManagerType>
-class MyAllocatorBase
+AllocResult<T> tryAllocateFromSegment(SegmentManagerType* segmentManager, const size_t n)
 {
-public:
-    using value_type = T;
-    using size_type = size_t;
+    if (0 == n)
+    {
+        return {nullptr, AllocError::ZeroSize};
+    }
+    if (nullptr == segmentManager)
+    {
+        return {nullptr, AllocError::NoSegmentManager};
+    }
+    if (n > SIZE_MAX / sizeof(T))
+    {
+        return {nullptr, AllocError::OutOfMemory};
+    }
 
-    T* allocate(const size_t n)
+    size_t neededBytes = n * sizeof(T);
+    void* mem = nullptr;
+    if constexpr (HasBatchAlloc<SegmentManagerType>::value && alignof(T) <= alignof(std::max_align_t))
+    {
+        mem = BulkAllocationScope<SegmentManagerType>::take(segmentManager, neededBytes);
+    }
+    if (nullptr == mem)
+    {
+        mem = segmentManager->alloc(neededBytes, alignof(T));
+    }
+    if (nullptr == mem)
+    {
+        return {nullptr, AllocError::OutOfMemory};
+    }
+
+    HeapProfiler::onAlloc(mem, neededBytes);
+    return {static_cast<T*>(mem), AllocError::None};
+}
+
+// Out of line, so the allocation fast path doesn't carry the message building
+[[noreturn]] __attribute__((noinline, cold)) inline void throwAllocError(AllocError error, size_t neededBytes)
+{
+    if (AllocError::OutOfMemory != error)
     {
-        if (mLog)
+        throw std::bad_alloc();
+    }
+    std::string errMsg = "Segment large enough is not found (" + std::to_string(neededBytes)
+                                                               + " bytes were requested)";
+    throw std::runtime_error(errMsg.c_str());
+}
+
+/**
+ * Allocates memory for @n objects of T from @segmentManager; this is what allocate() of all the MyAllocator*
+ * allocators comes down to. Throws std::bad_alloc if @n is 0 or there's no segment manager, and
+ * std::runtime_error if the segment manager has no block large enough.
+ */
+template <typename T, typename SegmentManagerType>
+T* allocateFromSegment(SegmentManagerType* segmentManager, const size_t n)
+{
+    AllocResult<T> result = tryAllocateFromSegment<T>(segmentManager, n);
+    if (__builtin_expect(nullptr == result.ptr, 0))
+    {
+        throwAllocError(result.error, n * sizeof(T));
+    }
+    return result.ptr;
+}
+
+/**
+ * Gives the memory of @n objects at @mem back to @segmentManager, returning the reason if it can't be done
+ * rather than throwing (the counterpart of tryAllocateFromSegment()). The memory is freed right away, even
+ * within a BulkAllocationScope, so that the error is known; the heap profiler forgets valid pointers only.
+ */
+template <typename T, typename SegmentManagerType>
+AllocError tryDeallocateToSegment(SegmentManagerType* segmentManager, T* mem, const size_t n) noexcept
+{
+    if (nullptr == segmentManager)
+    {
+        return AllocError::NoSegmentManager;
+    }
+    if (nullptr == mem)
+    {
+        return AllocError::NullPointer;
+    }
+    if constexpr (HasSizedFree<SegmentManagerType>::value && !HasTryFree<SegmentManagerType>::value)
+    {
+        // The sized free()s have no non-throwing counterparts
+        try
+        {
+            segmentManager->free(mem, n * sizeof(T));
+        }
+        catch (const std::exception&)
         {
-            std::cout << __PRETTY_FUNCTION__ << " | Allocating num of objects: " << n <<
-                                                " | " << n * sizeof(T) << " bytes are required" << std::endl;
+            return AllocError::InvalidPointer;
         }
-        if (0 == n || !mSegmentManager)
+        HeapProfiler::onFree(mem);
+        return AllocError::None;
+    }
+    else
+    {
+        AllocError error = tryFreeToSegment(*segmentManager, mem);
+        if (AllocError::None == error)
         {
-            throw std::bad_alloc();
+            HeapProfiler::onFree(mem);
         }
+        return error;
+    }
+}
 
-        size_t neededBytes = n * sizeof(T);
-        void* mem = mSegmentManager->alloc(neededBytes);
-        if (nullptr == mem)
+/**
+ * Gives the memory of @n objects at @mem back to @segmentManager (the counterpart of allocateFromSegment()).
+ */
+template <typename T, typename SegmentManagerType>
+void deallocateToSegment(SegmentManagerType* segmentManager, T* mem, const size_t n)
+{
+    if (nullptr == segmentManager)
+    {
+        return;
+    }
+    HeapProfiler::onFree(mem);
+    if constexpr (HasBatchAlloc<SegmentManagerType>::value)
+    {
+        if (BulkAllocationScope<SegmentManagerType>::defer(segmentManager, mem))
         {
-            std::string errMsg = "Segment large enough is not found (" + std::to_string(neededBytes)
-                                                                       + " bytes were requested)";
-            throw std::runtime_error(errMsg.c_str());
+            return;
         }
+    }
+    if constexpr (HasSizedFree<SegmentManagerType>::value)
+    {
+        segmentManager->free(mem, n * sizeof(T));
+    }
+    else
+    {
+        segmentManager->free(mem);
+    }
+}
+
+/**
+ * Common functionality for the MyAllocator* custom allocators.
+ * @AccountingPolicy is told about all the allocations (see AllocationAccounting.hpp); the default one,
+ * NoAccounting, compiles to nothing.
+ */
+template <typename T, typename SegmentManagerType, typename AccountingPolicy = NoAccounting>
+class MyAllocatorBase : public AccountingPolicy
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using segment_manager_type = SegmentManagerType;
+    using accounting_policy = AccountingPolicy;
+
+    // The segment manager goes along with the memory: moving & swapping containers just hands their buffers
+    // over, together with the allocator, even if the allocators differ. Allocators with different segment
+    // managers aren't equal, so is_always_equal is false.
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
 
-        return static_cast<T*>(mem);
+    T* allocate(const size_t n)
+    {
+        T* mem = allocateFromSegment<T>(mSegmentManager.get(), n);
+        AccountingPolicy::onAllocate(__PRETTY_FUNCTION__, n, n * sizeof(T));
+        return mem;
     }
 
     void deallocate(T* mem, const size_t n)
     {
-        if (mLog)
+        AccountingPolicy::onDeallocate(__PRETTY_FUNCTION__, n, n * sizeof(T));
+        deallocateToSegment(mSegmentManager.get(), mem, n);
+    }
+
+    /**
+     * allocate() & deallocate() which return the errors instead of throwing them (see AllocError.hpp)
+     */
+    AllocResult<T> tryAllocate(const size_t n)
+    {
+        AllocResult<T> result = tryAllocateFromSegment<T>(mSegmentManager.get(), n);
+        if (result.ptr != nullptr)
         {
-            std::cout << __PRETTY_FUNCTION__ << " | Deallocating num of objects: " << n <<
-                                                " | " << n * sizeof(T) << " bytes are to be freed" << std::endl;
+            AccountingPolicy::onAllocate(__PRETTY_FUNCTION__, n, n * sizeof(T));
         }
+        return result;
+    }
+
+    AllocError tryDeallocate(T* mem, const size_t n)
+    {
+        AllocError error = tryDeallocateToSegment(mSegmentManager.get(), mem, n);
+        if (AllocError::None == error)
+        {
+            AccountingPolicy::onDeallocate(__PRETTY_FUNCTION__, n, n * sizeof(T));
+        }
+        return error;
+    }
+
+    /**
+     * Tries to grow the memory at @mem from @oldN to @newN objects in place; it's then to be deallocated
+     * with @newN. On failure nothing changes and the caller has to allocate elsewhere.
+     */
+    bool tryExpand(T* mem, const size_t oldN, const size_t newN)
+    {
+        if (!mSegmentManager || !mSegmentManager->tryExpand(mem, newN * sizeof(T)))
+        {
+            return false;
+        }
+        HeapProfiler::onResize(mem, newN * sizeof(T));
+        AccountingPolicy::onResize(__PRETTY_FUNCTION__, newN, oldN * sizeof(T), newN * sizeof(T));
+        return true;
+    }
+
+    /**
+     * Shrinks the memory at @mem from @oldN to @newN objects in place; it's then to be deallocated with @newN.
+     */
+    void shrink(T* mem, const size_t oldN, const size_t newN)
+    {
         if (mSegmentManager)
         {
-            mSegmentManager->free(mem);
+            mSegmentManager->shrink(mem, newN * sizeof(T));
+            HeapProfiler::onResize(mem, newN * sizeof(T));
+            AccountingPolicy::onResize(__PRETTY_FUNCTION__, newN, oldN * sizeof(T), newN * sizeof(T));
         }
     }
 
+    /**
+     * Statistics of the segment manager, which is shared by all the copies & rebinds of the allocator.
+     */
+    SegmentManagerStats getStats() const
+    {
+        return mSegmentManager ? mSegmentManager->getStats() : SegmentManagerStats();
+    }
+
     SharedPtr<SegmentManagerType> getSegmentManager() const
     {
         return mSegmentManager;
     }
 
-    bool isLoggingEnabled() const
+    const AccountingPolicy& getAccounting() const noexcept
+    {
+        return *this;
+    }
+
+    // Two allocators are equal if memory allocated by one of them can be deallocated by the other
+    // (whatever they account it to)
+    template <typename U>
+    bool operator==(const MyAllocatorBase<U, SegmentManagerType, AccountingPolicy>& rhs) const noexcept
+    {
+        return mSegmentManager.get() == rhs.getSegmentManager().get();
+    }
+
+    template <typename U>
+    bool operator!=(const MyAllocatorBase<U, SegmentManagerType, AccountingPolicy>& rhs) const noexcept
     {
-        return mLog;
+        return !(*this == rhs);
     }
 
 protected:
@@ -98,63 +318,57 @@ protected:
         mSegmentManager = segmentManager;
     }
 
-    MyAllocatorBase(bool loggingOn = false) noexcept :
-        mSegmentManager(nullptr),
-        mLog(loggingOn)
+    MyAllocatorBase(const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        AccountingPolicy(accounting),
+        mSegmentManager(nullptr)
     {
     }
 
-    MyAllocatorBase(const SharedPtr<SegmentManagerType>& segmentManager, bool loggingOn = false) noexcept :
-        mSegmentManager(segmentManager),
-        mLog(loggingOn)
+    MyAllocatorBase(const SharedPtr<SegmentManagerType>& segmentManager,
+                    const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        AccountingPolicy(accounting),
+        mSegmentManager(segmentManager)
     {
     }
 
     // Casting ctor
     template <typename U>
-    MyAllocatorBase(const MyAllocatorBase<U, SegmentManagerType>& rhs) noexcept :
-        mSegmentManager(rhs.getSegmentManager()),
-        mLog(rhs.isLoggingEnabled())
+    MyAllocatorBase(const MyAllocatorBase<U, SegmentManagerType, AccountingPolicy>& rhs) noexcept :
+        AccountingPolicy(rhs.getAccounting()),
+        mSegmentManager(rhs.getSegmentManager())
     {
     }
 
     MyAllocatorBase(const MyAllocatorBase& rhs) noexcept :
-        mSegmentManager(rhs.mSegmentManager),
-        mLog(rhs.mLog)
+        AccountingPolicy(rhs),
+        mSegmentManager(rhs.mSegmentManager)
     {
     }
 
+    // A moved-from allocator must stay equal to the new one: a moved-from container still uses it
     MyAllocatorBase(MyAllocatorBase&& rhs) noexcept :
-        mSegmentManager(std::move(rhs.mSegmentManager)),
-        mLog(rhs.mLog)
+        AccountingPolicy(rhs),
+        mSegmentManager(rhs.mSegmentManager)
     {
-        rhs.mSegmentManager = nullptr;
-        rhs.mLog = false;
     }
 
     MyAllocatorBase& operator=(const MyAllocatorBase& rhs) noexcept
     {
         // this != &rhs check to be performed by Derived classes
+        AccountingPolicy::operator=(rhs);
         mSegmentManager.reset();
         mSegmentManager = rhs.mSegmentManager;
-        mLog = rhs.mLog;
         return *this;
     }
 
     MyAllocatorBase& operator=(MyAllocatorBase&& rhs) noexcept
     {
         // this != &rhs check to be performed by Derived classes
-        mSegmentManager.reset();
-        mSegmentManager = std::move(rhs.mSegmentManager);
-        mLog = rhs.mLog;
-        rhs.mSegmentManager = nullptr;
-        rhs.mLog = false;
-        return *this;
+        return operator=(static_cast<const MyAllocatorBase&>(rhs));
     }
 
 protected:
     SharedPtr<SegmentManagerType> mSegmentManager;
-    bool mLog;
 };
 
 } // mybicycles
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "MyAllocatorBase.hpp"
+#include "SimpleSegmentManager.hpp"
+
+#include <type_traits>
+
+namespace mybicycles
+{
+
+/**
+ * Custom allocator for STL containers which refers to its segment manager by a plain pointer, for segment
+ * managers whose lifetime is guaranteed by their owner (a segment manager living as long as the program,
+ * or one owned by the object which also owns the containers). Unlike the allocators holding a SharedPtr,
+ * copying & rebinding it doesn't touch any reference count: it's trivially copyable and pointer-sized,
+ * so node containers & their swaps copy it for free. There's no logging.
+ *
+ * The segment manager must outlive all the containers (and copies of the allocator) using it.
+ */
+template <typename T, typename SegmentManagerType = SimpleSegmentManager>
+class MyAllocatorHandle
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using segment_manager_type = SegmentManagerType;
+
+    // See MyAllocatorBase
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    // Rebind mechanism
+    template <typename U>
+    struct rebind
+    {
+        using other = MyAllocatorHandle<U, SegmentManagerType>;
+    };
+
+    MyAllocatorHandle() noexcept = default;
+
+    explicit MyAllocatorHandle(SegmentManagerType* segmentManager) noexcept :
+        mSegmentManager(segmentManager)
+    {
+    }
+
+    // The SharedPtr (or whoever else) keeps owning the segment manager
+    explicit MyAllocatorHandle(const SharedPtr<SegmentManagerType>& segmentManager) noexcept :
+        mSegmentManager(segmentManager.get())
+    {
+    }
+
+    // Casting ctor
+    template <typename U>
+    MyAllocatorHandle(const MyAllocatorHandle<U, SegmentManagerType>& rhs) noexcept :
+        mSegmentManager(rhs.getSegmentManager())
+    {
+    }
+
+    T* allocate(const size_t n)
+    {
+        return allocateFromSegment<T>(mSegmentManager, n);
+    }
+
+    void deallocate(T* mem, const size_t n)
+    {
+        deallocateToSegment(mSegmentManager, mem, n);
+    }
+
+    AllocResult<T> tryAllocate(const size_t n)
+    {
+        return tryAllocateFromSegment<T>(mSegmentManager, n);
+    }
+
+    AllocError tryDeallocate(T* mem, const size_t n) noexcept
+    {
+        return tryDeallocateToSegment(mSegmentManager, mem, n);
+    }
+
+    // See MyAllocatorBase
+    bool tryExpand(T* mem, const size_t, const size_t newN)
+    {
+        if (nullptr == mSegmentManager || !mSegmentManager->tryExpand(mem, newN * sizeof(T)))
+        {
+            return false;
+        }
+        HeapProfiler::onResize(mem, newN * sizeof(T));
+        return true;
+    }
+
+    void shrink(T* mem, const size_t, const size_t newN)
+    {
+        if (mSegmentManager != nullptr)
+        {
+            mSegmentManager->shrink(mem, newN * sizeof(T));
+            HeapProfiler::onResize(mem, newN * sizeof(T));
+        }
+    }
+
+    SegmentManagerStats getStats() const
+    {
+        return mSegmentManager != nullptr ? mSegmentManager->getStats() : SegmentManagerStats();
+    }
+
+    SegmentManagerType* getSegmentManager() const noexcept
+    {
+        return mSegmentManager;
+    }
+
+    template <typename U>
+    bool operator==(const MyAllocatorHandle<U, SegmentManagerType>& rhs) const noexcept
+    {
+        return mSegmentManager == rhs.getSegmentManager();
+    }
+
+    template <typename U>
+    bool operator!=(const MyAllocatorHandle<U, SegmentManagerType>& rhs) const noexcept
+    {
+        return !(*this == rhs);
+    }
+
+private:
+    SegmentManagerType* mSegmentManager = nullptr;
+};
+
+static_assert(std::is_trivially_copyable_v<MyAllocatorHandle<int>>, "Copying the handle must cost nothing");
+static_assert(sizeof(MyAllocatorHandle<int>) == sizeof(void*), "The handle must be pointer-sized");
+
+} // mybicycles
@@ -9,41 +9,44 @@ namespace mybicycles
 /**
  * Custom allocator for STL containers. Allocates chunks of memory from the segment it doesn't own.
  */
-template <typename T, typename SegmentManagerType = SimpleSegmentManager>
-class MyAllocatorNonOwning : public MyAllocatorBase<T, SegmentManagerType>
+template <typename T, typename SegmentManagerType = SimpleSegmentManager, typename AccountingPolicy = NoAccounting>
+class MyAllocatorNonOwning : public MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>
 {
+    using Base = MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>;
+
 public:
     // Rebind mechanism
     template <typename U>
     struct rebind
     {
-        using other = MyAllocatorNonOwning<U, SegmentManagerType>;
+        using other = MyAllocatorNonOwning<U, SegmentManagerType, AccountingPolicy>;
     };
 
-    MyAllocatorNonOwning(bool loggingOn = false) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(loggingOn)
+    MyAllocatorNonOwning(const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        Base(accounting)
     {
     }
 
-    MyAllocatorNonOwning(const SharedPtr<SegmentManagerType>& segmentManager, bool loggingOn = false) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(segmentManager, loggingOn)
+    MyAllocatorNonOwning(const SharedPtr<SegmentManagerType>& segmentManager,
+                         const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        Base(segmentManager, accounting)
     {
     }
 
     MyAllocatorNonOwning(const MyAllocatorNonOwning& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(rhs)
+        Base(rhs)
     {
     }
 
     MyAllocatorNonOwning(MyAllocatorNonOwning&& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(std::move(rhs))
+        Base(std::move(rhs))
     {
     }
 
     // Casting ctor
     template <typename U>
-    MyAllocatorNonOwning(const MyAllocatorNonOwning<U, SegmentManagerType>& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(rhs)
+    MyAllocatorNonOwning(const MyAllocatorNonOwning<U, SegmentManagerType, AccountingPolicy>& rhs) noexcept :
+        Base(rhs)
     {
     }
 
@@ -51,7 +54,7 @@ public:
     {
         if (this != &rhs)
         {
-            MyAllocatorBase<T, SegmentManagerType>::operator=(rhs);
+            Base::operator=(rhs);
         }
         return *this;
     }
@@ -60,7 +63,7 @@ public:
     {
         if (this != &rhs)
         {
-            MyAllocatorBase<T, SegmentManagerType>::operator=(std::move(rhs));
+            Base::operator=(std::move(rhs));
         }
         return *this;
     }
@@ -1,60 +1,85 @@
 #pragma once
 
+#include "FallbackSegmentManager.hpp"
 #include "MyAllocatorBase.hpp"
 #include "SimpleSegmentManager.hpp"
 
+#include <type_traits>
+
 namespace mybicycles
 {
 
 /**
  * Custom allocator for STL containers. Allocates chunks of memory from the segment it owns.
- * The segment is on stack and is of size @SEG_SIZE.
+ * The segment is on stack and is of size @SEG_SIZE. It's left uninitialized: the segment manager
+ * writes only its own bookkeeping there.
+ *
+ * A copy (or a rebind, or a moved-to one) of the allocator allocates from the segment of the original,
+ * not from its own, so the original has to outlive it. Containers therefore never pass the allocator on
+ * (there's no propagation on their copy/move assignment & swap): a container moved into one with another
+ * segment moves its elements instead, and swapping two containers is only allowed if they use the same one.
+ *
+ * With a @FallbackSegmentManager (see MyAllocatorStackFirst below), allocations which don't fit into
+ * the segment overflow to the heap or to the upstream segment manager given to the constructor.
  */
-template <typename T, size_t SEG_SIZE, typename SegmentManagerType = SimpleSegmentManager>
-class MyAllocatorOnStack : public MyAllocatorBase<T, SegmentManagerType>
+template <typename T, size_t SEG_SIZE, typename SegmentManagerType = SimpleSegmentManager,
+          typename AccountingPolicy = NoAccounting>
+class MyAllocatorOnStack : public MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>
 {
+    using Base = MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>;
+
 public:
     // Rebind mechanism
     template <typename U>
     struct rebind
     {
-        using other = MyAllocatorOnStack<U, SEG_SIZE, SegmentManagerType>;
+        using other = MyAllocatorOnStack<U, SEG_SIZE, SegmentManagerType, AccountingPolicy>;
     };
 
-    MyAllocatorOnStack(bool loggingOn = false) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(loggingOn)
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    MyAllocatorOnStack(const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        Base(accounting)
     {
-        memset(mDefaultSegment, '0', SEG_SIZE);
-        MyAllocatorBase<T, SegmentManagerType>::setSegmentManager(
-                    makeShared<SegmentManagerType>(mDefaultSegment, SEG_SIZE, loggingOn));
+        Base::setSegmentManager(makeShared<SegmentManagerType>(mDefaultSegment, SEG_SIZE, AccountingPolicy::VERBOSE));
+    }
+
+    // For segment managers which take an upstream one, like FallbackSegmentManager
+    template <typename UpstreamType,
+              typename = std::enable_if_t<std::is_constructible_v<SegmentManagerType, char*, size_t,
+                                                                   const SharedPtr<UpstreamType>&, bool>>>
+    explicit MyAllocatorOnStack(const SharedPtr<UpstreamType>& upstream,
+                                const AccountingPolicy& accounting = AccountingPolicy()) :
+        Base(accounting)
+    {
+        Base::setSegmentManager(
+                    makeShared<SegmentManagerType>(mDefaultSegment, SEG_SIZE, upstream, AccountingPolicy::VERBOSE));
     }
 
     MyAllocatorOnStack(const MyAllocatorOnStack& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(rhs)
+        Base(rhs)
     {
-        std::cout << __PRETTY_FUNCTION__ << mWarning << std::endl;
     }
 
     MyAllocatorOnStack(MyAllocatorOnStack&& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(std::move(rhs))
+        Base(std::move(rhs))
     {
-        std::cout << __PRETTY_FUNCTION__ << mWarning << std::endl;
     }
 
     // Casting ctor
     template <typename U>
-    MyAllocatorOnStack(const MyAllocatorOnStack<U, SEG_SIZE, SegmentManagerType>& rhs) noexcept :
-        MyAllocatorBase<T, SegmentManagerType>(rhs)
+    MyAllocatorOnStack(const MyAllocatorOnStack<U, SEG_SIZE, SegmentManagerType, AccountingPolicy>& rhs) noexcept :
+        Base(rhs)
     {
-        std::cout << __PRETTY_FUNCTION__ << mWarning << std::endl;
     }
 
     MyAllocatorOnStack& operator=(const MyAllocatorOnStack& rhs) noexcept
     {
         if (this != &rhs)
         {
-            MyAllocatorBase<T, SegmentManagerType>::operator=(rhs);
-            std::cout << __PRETTY_FUNCTION__ << mWarning << std::endl;
+            Base::operator=(rhs);
         }
         return *this;
     }
@@ -63,8 +88,7 @@ public:
     {
         if (this != &rhs)
         {
-            MyAllocatorBase<T, SegmentManagerType>::operator=(std::move(rhs));
-            std::cout << __PRETTY_FUNCTION__ << mWarning << std::endl;
+            Base::operator=(std::move(rhs));
         }
         return *this;
     }
@@ -73,8 +97,13 @@ public:
 
 private:
     char mDefaultSegment[SEG_SIZE];
-    const char* mWarning = "!!! WARNING: We are discarding usage of our own segment on stack and we'll be"
-                           " allocating from rhs's segment from now on";
 };
 
+/**
+ * short_alloc: the first @SEG_SIZE bytes come from the stack, the rest from @UpstreamType (the heap by default).
+ */
+template <typename T, size_t SEG_SIZE, typename PrimaryType = SimpleSegmentManager,
+          typename UpstreamType = DummySegmentManager>
+using MyAllocatorStackFirst = MyAllocatorOnStack<T, SEG_SIZE, FallbackSegmentManager<PrimaryType, UpstreamType>>;
+
 } // mybicycles
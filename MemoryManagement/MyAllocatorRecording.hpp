@@ -0,0 +1,143 @@
+#pragma once
+
+#include "AllocTracer.hpp"
+#include "MyAllocatorBase.hpp"
+#include "SimpleSegmentManager.hpp"
+
+namespace mybicycles
+{
+
+/**
+ * Custom allocator for STL containers which works like MyAllocatorNonOwning and additionally records
+ * every allocation, deallocation & in-place resize (size, thread, time) into AllocTracer, whatever the segment manager is
+ * and regardless of MYBICYCLES_ALLOC_TRACING. Put it into a real program's containers to capture their
+ * allocation pattern; the dumped trace can then be replayed against any segment manager by the
+ * SegmentManagerBench tool. Turn on AllocTracer::setKeepAllEvents() so that the trace is complete.
+ *
+ * NOTE: with MYBICYCLES_ALLOC_TRACING on, a SimpleSegmentManager underneath records the same blocks
+ * once again (with control block addresses), so don't mix the two.
+ */
+template <typename T, typename SegmentManagerType = SimpleSegmentManager, typename AccountingPolicy = NoAccounting>
+class MyAllocatorRecording : public MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>
+{
+    using Base = MyAllocatorBase<T, SegmentManagerType, AccountingPolicy>;
+
+public:
+    // Rebind mechanism
+    template <typename U>
+    struct rebind
+    {
+        using other = MyAllocatorRecording<U, SegmentManagerType, AccountingPolicy>;
+    };
+
+    MyAllocatorRecording(const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        Base(accounting)
+    {
+    }
+
+    MyAllocatorRecording(const SharedPtr<SegmentManagerType>& segmentManager,
+                         const AccountingPolicy& accounting = AccountingPolicy()) noexcept :
+        Base(segmentManager, accounting)
+    {
+    }
+
+    MyAllocatorRecording(const MyAllocatorRecording& rhs) noexcept :
+        Base(rhs)
+    {
+    }
+
+    MyAllocatorRecording(MyAllocatorRecording&& rhs) noexcept :
+        Base(std::move(rhs))
+    {
+    }
+
+    // Casting ctor
+    template <typename U>
+    MyAllocatorRecording(const MyAllocatorRecording<U, SegmentManagerType, AccountingPolicy>& rhs) noexcept :
+        Base(rhs)
+    {
+    }
+
+    MyAllocatorRecording& operator=(const MyAllocatorRecording& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            Base::operator=(rhs);
+        }
+        return *this;
+    }
+
+    MyAllocatorRecording& operator=(MyAllocatorRecording&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            Base::operator=(std::move(rhs));
+        }
+        return *this;
+    }
+
+    ~MyAllocatorRecording() = default;
+
+    T* allocate(const size_t n)
+    {
+        T* mem = nullptr;
+        try
+        {
+            mem = Base::allocate(n);
+        }
+        catch (...)
+        {
+            AllocTracer::instance().record(AllocEventType::Failure, nullptr, n * sizeof(T));
+            throw;
+        }
+        AllocTracer::instance().record(AllocEventType::Alloc, mem, n * sizeof(T));
+        return mem;
+    }
+
+    void deallocate(T* mem, const size_t n)
+    {
+        // Stamped first: once the block is freed, another thread may get it & record its allocation, which
+        // the dumped trace must put after the free. Recorded only if the free succeeds though.
+        uint64_t timestampNs = AllocTracer::now();
+        Base::deallocate(mem, n);
+        AllocTracer::instance().record(AllocEventType::Free, mem, 0, timestampNs);
+    }
+
+    AllocResult<T> tryAllocate(const size_t n)
+    {
+        AllocResult<T> result = Base::tryAllocate(n);
+        AllocTracer::instance().record(result ? AllocEventType::Alloc : AllocEventType::Failure,
+                                       result.ptr, n * sizeof(T));
+        return result;
+    }
+
+    AllocError tryDeallocate(T* mem, const size_t n)
+    {
+        // Stamped first, as in deallocate()
+        uint64_t timestampNs = AllocTracer::now();
+        AllocError error = Base::tryDeallocate(mem, n);
+        if (AllocError::None == error)
+        {
+            AllocTracer::instance().record(AllocEventType::Free, mem, 0, timestampNs);
+        }
+        return error;
+    }
+
+    bool tryExpand(T* mem, const size_t oldN, const size_t newN)
+    {
+        if (!Base::tryExpand(mem, oldN, newN))
+        {
+            return false;
+        }
+        AllocTracer::instance().record(AllocEventType::Resize, mem, newN * sizeof(T));
+        return true;
+    }
+
+    void shrink(T* mem, const size_t oldN, const size_t newN)
+    {
+        Base::shrink(mem, oldN, newN);
+        AllocTracer::instance().record(AllocEventType::Resize, mem, newN * sizeof(T));
+    }
+};
+
+} // mybicycles
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MyAllocatorNonOwning.hpp"
+#include "SimpleSegmentManager.hpp"
+
+#include <functional>
+#include <list>
+#include <map>
+#include <scoped_allocator>
+#include <string>
+#include <vector>
+
+namespace mybicycles
+{
+
+/**
+ * Custom allocator for nested STL containers: a MyAllocator* allocator which passes itself on to the
+ * allocator-aware elements it constructs (uses-allocator construction, done by std::scoped_allocator_adaptor),
+ * so that e.g. the vectors in a map, the strings in those vectors and all of their memory are in the map's
+ * segment, and are given back to it when the map goes away. The elements have to take an allocator
+ * convertible from it, which is what the Segment* containers below do.
+ */
+template <typename T, typename SegmentManagerType = SimpleSegmentManager,
+          template <typename, typename> class Allocator = MyAllocatorNonOwning>
+using MyScopedAllocator = std::scoped_allocator_adaptor<Allocator<T, SegmentManagerType>>;
+
+// Containers placing their elements' memory into their own segment:
+template <typename SegmentManagerType = SimpleSegmentManager>
+using SegmentString = std::basic_string<char, std::char_traits<char>, MyScopedAllocator<char, SegmentManagerType>>;
+
+template <typename T, typename SegmentManagerType = SimpleSegmentManager>
+using SegmentVector = std::vector<T, MyScopedAllocator<T, SegmentManagerType>>;
+
+template <typename T, typename SegmentManagerType = SimpleSegmentManager>
+using SegmentList = std::list<T, MyScopedAllocator<T, SegmentManagerType>>;
+
+template <typename Key, typename T, typename SegmentManagerType = SimpleSegmentManager, typename Compare = std::less<Key>>
+using SegmentMap = std::map<Key, T, Compare, MyScopedAllocator<std::pair<const Key, T>, SegmentManagerType>>;
+
+} // mybicycles
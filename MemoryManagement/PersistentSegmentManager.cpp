@@ -0,0 +1,424 @@
+#include "PersistentSegmentManager.hpp"
+#include "AllocTracer.hpp"
+#include "RobustMutex.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const char* V_LOG_TAG = "__PSM__ "; // tag for verbose debugging
+
+    const uint64_t HEAP_MAGIC = 0x50455253'48454150ULL; // "PERSHEAP"
+    const uint32_t HEAP_VERSION = 4;
+}
+
+// Everything the manager needs to resume work on the segment; the segment's very first bytes
+struct PersistentSegmentManager::SegmentHeader
+{
+    // Written last when formatting, so a half-formatted segment isn't taken for a heap (by another
+    // process too, hence atomic):
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t unitSize;
+    uint64_t segmentSize; // bytes
+    uint64_t formattedAt; // the segment's address at formatting
+    uint64_t rootOffset; // 0 if there's no root
+    uint64_t inconsistent; // non-zero once a process died leaving the free list broken
+    // Non-zero while a process holds the lock: an Exclusive restore re-initializes the lock, so this is
+    // what tells it the heap's last owner died holding the lock
+    uint64_t mutating;
+    // Statistics data:
+    uint64_t freeUnits;
+    uint64_t occupUnits;
+    uint64_t peakOccupUnits;
+    uint64_t allocsNum;
+    uint64_t freesNum;
+    uint64_t failedAllocsNum;
+    MemControlBlock freeListHeader; // zero-sized sentinel of the circular free list sorted by address
+    RobustMutex mutex;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The magic must be usable across processes");
+
+// The lock of every public call
+class PersistentSegmentManager::HeapLock
+{
+public:
+    explicit HeapLock(const PersistentSegmentManager& manager) :
+        mManager(manager)
+    {
+        mManager.lockHeap();
+        mManager.mHeader->mutating = 1;
+    }
+
+    ~HeapLock()
+    {
+        mManager.mHeader->mutating = 0;
+        mManager.mHeader->mutex.unlock();
+    }
+
+    HeapLock(const HeapLock& rhs) = delete;
+    HeapLock& operator= (const HeapLock& rhs) = delete;
+
+private:
+    const PersistentSegmentManager& mManager;
+};
+
+const size_t PersistentSegmentManager::MEM_UNIT_SZ = sizeof(MemControlBlock);
+const size_t PersistentSegmentManager::HEADER_SIZE =
+        (sizeof(SegmentHeader) + sizeof(MemControlBlock) - 1) / sizeof(MemControlBlock) * sizeof(MemControlBlock);
+
+PersistentSegmentManager::PersistentSegmentManager(char* segment, size_t size,
+                                                   bool verboseDebugging, Sharing sharing) :
+    mSegment(segment),
+    mHeader(reinterpret_cast<SegmentHeader*>(segment)),
+    mFreeListHeader(nullptr),
+    mVerboseDebug(verboseDebugging),
+    mRestored(false),
+    mRelocated(false)
+{
+    if (nullptr == mSegment || reinterpret_cast<uintptr_t>(mSegment) % MEM_UNIT_SZ != 0)
+    {
+        // Unlike SimpleSegmentManager, we can't skip a misaligned head: it may differ after a restart
+        throw std::invalid_argument("Segment must be aligned to the mem unit");
+    }
+    mFreeListHeader = &mHeader->freeListHeader;
+
+    if (formattedAt(segment, size) != nullptr)
+    {
+        restore(size, sharing);
+    }
+    else
+    {
+        format(size);
+    }
+}
+
+void* PersistentSegmentManager::formattedAt(const char* segment, size_t size)
+{
+    if (size < HEADER_SIZE)
+    {
+        return nullptr;
+    }
+    const SegmentHeader* header = reinterpret_cast<const SegmentHeader*>(segment);
+    if (header->magic.load(std::memory_order_acquire) != HEAP_MAGIC ||
+        header->version != HEAP_VERSION || header->unitSize != MEM_UNIT_SZ)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(header->formattedAt);
+}
+
+void PersistentSegmentManager::format(size_t size)
+{
+    size -= size % MEM_UNIT_SZ;
+    if (size < HEADER_SIZE + 2 * MEM_UNIT_SZ) // header + min usable fragment with its CB
+    {
+        throw std::runtime_error("Segment is too small to be used");
+    }
+
+    mHeader->magic.store(0, std::memory_order_relaxed);
+    mHeader->version = HEAP_VERSION;
+    mHeader->unitSize = MEM_UNIT_SZ;
+    mHeader->segmentSize = size;
+    mHeader->formattedAt = reinterpret_cast<uintptr_t>(mSegment);
+    mHeader->rootOffset = 0;
+    mHeader->inconsistent = 0;
+    mHeader->mutating = 0;
+    mHeader->freeUnits = (size - HEADER_SIZE) / MEM_UNIT_SZ;
+    mHeader->occupUnits = HEADER_SIZE / MEM_UNIT_SZ;
+    mHeader->peakOccupUnits = mHeader->occupUnits;
+    mHeader->allocsNum = 0;
+    mHeader->freesNum = 0;
+    mHeader->failedAllocsNum = 0;
+
+    freeList().init(cbAt(HEADER_SIZE), mHeader->freeUnits);
+    mHeader->mutex.init();
+    mHeader->magic.store(HEAP_MAGIC, std::memory_order_release);
+
+    ALLOC_TRACE(SegmentInit, mSegment, size);
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Formatted a heap of " << size << " bytes at "
+                               << reinterpret_cast<long>((void*)mSegment) << std::endl;
+    }
+}
+
+void PersistentSegmentManager::restore(size_t size, Sharing sharing)
+{
+    if (mHeader->segmentSize > size)
+    {
+        throw std::runtime_error("Segment is smaller than the heap stored in it");
+    }
+    if (Sharing::Exclusive == sharing)
+    {
+        mHeader->mutex.init();
+        if (mHeader->mutating != 0 && 0 == mHeader->inconsistent)
+        {
+            // Just as lockHeap() does when the lock's owner died
+            mHeader->inconsistent = !recoverFreeListUnlocked();
+            if (mVerboseDebug)
+            {
+                std::cout << V_LOG_TAG << "The heap's last owner died holding the lock, the heap is "
+                                       << (mHeader->inconsistent ? "inconsistent" : "consistent") << std::endl;
+            }
+        }
+        mHeader->mutating = 0;
+    }
+    mRestored = true;
+    mRelocated = mHeader->formattedAt != reinterpret_cast<uintptr_t>(mSegment);
+
+    ALLOC_TRACE(SegmentInit, mSegment, mHeader->segmentSize);
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Restored a heap of " << mHeader->segmentSize << " bytes, "
+                               << mHeader->occupUnits * MEM_UNIT_SZ << " bytes occupied"
+                               << (mRelocated ? " (relocated)" : "") << std::endl;
+    }
+}
+
+void PersistentSegmentManager::lockHeap() const
+{
+    // std::lock_guard would discard what lock() reports: that the owner died, maybe halfway through
+    // changing the free list
+    if (!mHeader->mutex.lock() && 0 == mHeader->inconsistent)
+    {
+        mHeader->inconsistent = !recoverFreeListUnlocked();
+        if (mVerboseDebug)
+        {
+            std::cout << V_LOG_TAG << "The lock's owner died, the heap is "
+                                   << (mHeader->inconsistent ? "inconsistent" : "consistent") << std::endl;
+        }
+    }
+    if (mHeader->inconsistent != 0)
+    {
+        mHeader->mutex.unlock();
+        throw std::runtime_error("Heap is inconsistent: a process died while modifying it");
+    }
+}
+
+bool PersistentSegmentManager::recoverFreeListUnlocked() const
+{
+    // Every link is checked before it's followed: the free blocks must lie within the segment, in
+    // ascending order & without overlapping, which also guarantees the walk ends.
+    // A dead alloc() might have shrunk a free block before unlinking it, and a dead free() might
+    // have merged blocks before linking them: the space is leaked, but the list is fine.
+    uint64_t freeUnits = 0;
+    uint64_t minOffset = HEADER_SIZE;
+    uint64_t offset = mFreeListHeader->next;
+    while (offset != offsetOf(mFreeListHeader))
+    {
+        if (offset < minOffset || offset >= mHeader->segmentSize || offset % MEM_UNIT_SZ != 0)
+        {
+            return false;
+        }
+        const MemControlBlock* cb = cbAt(offset);
+        if (cb->size >= (mHeader->segmentSize - offset) / MEM_UNIT_SZ) // +1 CB of cb must fit too
+        {
+            return false;
+        }
+        freeUnits += cb->size + 1;
+        minOffset = offset + (cb->size + 1) * MEM_UNIT_SZ;
+        offset = cb->next;
+    }
+
+    // The counters might have been updated or not, so recount them:
+    mHeader->freeUnits = freeUnits;
+    mHeader->occupUnits = mHeader->segmentSize / MEM_UNIT_SZ - freeUnits;
+    if (mHeader->occupUnits > mHeader->peakOccupUnits)
+    {
+        mHeader->peakOccupUnits = mHeader->occupUnits;
+    }
+    return true;
+}
+
+void PersistentSegmentManager::setRoot(const void* root)
+{
+    HeapLock lock(*this);
+    mHeader->rootOffset = nullptr == root ? 0 : offsetOf(getOwnCb(const_cast<void*>(root)) + 1);
+}
+
+void* PersistentSegmentManager::getRoot() const
+{
+    HeapLock lock(*this);
+    return 0 == mHeader->rootOffset ? nullptr : mSegment + mHeader->rootOffset;
+}
+
+SegmentManagerStats PersistentSegmentManager::getStats() const
+{
+    SegmentManagerStats stats;
+    HeapLock lock(*this);
+    stats.allocsNum = mHeader->allocsNum;
+    stats.freesNum = mHeader->freesNum;
+    stats.failedAllocsNum = mHeader->failedAllocsNum;
+    stats.segmentBytes = mHeader->segmentSize;
+    stats.committedBytes = stats.segmentBytes;
+    stats.residentBytes = stats.segmentBytes; // never purged
+    stats.freeBytes = mHeader->freeUnits * MEM_UNIT_SZ;
+    stats.occupiedBytes = mHeader->occupUnits * MEM_UNIT_SZ;
+    stats.peakOccupiedBytes = mHeader->peakOccupUnits * MEM_UNIT_SZ;
+
+    freeList().forEachFree([&stats](const MemControlBlock* cb) {
+        stats.addFreeBlock((cb->size + 1) * MEM_UNIT_SZ); // +1 CB of cb
+    });
+    stats.updateFragmentation();
+    return stats;
+}
+
+void* PersistentSegmentManager::alloc(size_t neededBytes)
+{
+    HeapLock lock(*this);
+    return allocUnlocked(neededBytes, MEM_UNIT_SZ);
+}
+
+void* PersistentSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    HeapLock lock(*this);
+    return allocUnlocked(neededBytes, alignment);
+}
+
+void PersistentSegmentManager::free(void* addr)
+{
+    HeapLock lock(*this);
+    freeUnlocked(addr);
+    mHeader->freesNum++;
+    ALLOC_TRACE(Free, addr, 0);
+}
+
+bool PersistentSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    HeapLock lock(*this);
+    if (!tryExpandUnlocked(addr, newBytes))
+    {
+        return false;
+    }
+    ALLOC_TRACE(Resize, addr, newBytes);
+    return true;
+}
+
+void PersistentSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    HeapLock lock(*this);
+    shrinkUnlocked(addr, newBytes);
+    ALLOC_TRACE(Resize, addr, newBytes);
+}
+
+void* PersistentSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    HeapLock lock(*this);
+    if (nullptr == addr)
+    {
+        return allocUnlocked(newBytes, MEM_UNIT_SZ);
+    }
+
+    if (tryExpandUnlocked(addr, newBytes))
+    {
+        shrinkUnlocked(addr, newBytes); // no-op unless it's actually a shrink
+        ALLOC_TRACE(Resize, addr, newBytes);
+        return addr;
+    }
+
+    void* newAddr = allocUnlocked(newBytes, MEM_UNIT_SZ);
+    if (newAddr != nullptr)
+    {
+        std::memcpy(newAddr, addr, getOwnCb(addr)->size * MEM_UNIT_SZ); // the old block is smaller
+        freeUnlocked(addr);
+        mHeader->freesNum++;
+        ALLOC_TRACE(Free, addr, 0);
+    }
+    return newAddr;
+}
+
+void* PersistentSegmentManager::allocUnlocked(size_t neededBytes, size_t alignment)
+{
+    if (0 == alignment || (alignment & (alignment - 1)) != 0)
+    {
+        return nullptr; // not a power of 2
+    }
+    if (alignment < MEM_UNIT_SZ)
+    {
+        alignment = MEM_UNIT_SZ;
+    }
+
+    void* retAddr = nullptr;
+    MemControlBlock* retCb = freeList().allocFirstFit(FreeList::unitsFor(neededBytes), alignment);
+    if (retCb != nullptr)
+    {
+        mHeader->occupUnits += retCb->size + 1;
+        mHeader->freeUnits -= retCb->size + 1;
+        if (mHeader->occupUnits > mHeader->peakOccupUnits)
+        {
+            mHeader->peakOccupUnits = mHeader->occupUnits;
+        }
+        retAddr = retCb + 1;
+    }
+
+    if (retAddr != nullptr)
+    {
+        mHeader->allocsNum++;
+        ALLOC_TRACE(Alloc, retAddr, neededBytes);
+    }
+    else
+    {
+        mHeader->failedAllocsNum++;
+        ALLOC_TRACE(Failure, nullptr, neededBytes);
+    }
+    return retAddr;
+}
+
+PersistentSegmentManager::MemControlBlock* PersistentSegmentManager::getOwnCb(void* addr) const
+{
+    if (nullptr == addr)
+    {
+        throw std::invalid_argument("Cannot free a null pointer");
+    }
+
+    MemControlBlock* userCb = (MemControlBlock*)addr - 1;
+    if ((char*)userCb < mSegment + HEADER_SIZE || (char*)userCb >= mSegment + mHeader->segmentSize ||
+        ((char*)userCb - mSegment) % MEM_UNIT_SZ != 0)
+    {
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+    return userCb;
+}
+
+void PersistentSegmentManager::freeUnlocked(void* addr)
+{
+    MemControlBlock* userCb = getOwnCb(addr);
+    size_t freedUnits = userCb->size + 1; // +1 CB of userCb
+    if (nullptr == freeList().release(userCb, mFreeListHeader))
+    {
+        throw std::runtime_error("Memory block is already freed");
+    }
+    mHeader->occupUnits -= freedUnits;
+    mHeader->freeUnits += freedUnits;
+}
+
+bool PersistentSegmentManager::tryExpandUnlocked(void* addr, size_t newBytes)
+{
+    MemControlBlock* userCb = getOwnCb(addr);
+    size_t oldUnits = userCb->size;
+    if (!freeList().expand(userCb, FreeList::unitsFor(newBytes)))
+    {
+        return false;
+    }
+    mHeader->occupUnits += userCb->size - oldUnits;
+    mHeader->freeUnits -= userCb->size - oldUnits;
+    if (mHeader->occupUnits > mHeader->peakOccupUnits)
+    {
+        mHeader->peakOccupUnits = mHeader->occupUnits;
+    }
+    return true;
+}
+
+void PersistentSegmentManager::shrinkUnlocked(void* addr, size_t newBytes)
+{
+    // Turn the tail into a separate block and free it, which merges it with the free space after it:
+    MemControlBlock* tailCb = FreeList::cutTail(getOwnCb(addr), FreeList::unitsFor(newBytes));
+    if (tailCb != nullptr)
+    {
+        freeUnlocked(tailCb + 1);
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "SegmentManagerStats.hpp"
+#include "SequentialFitFreeList.hpp"
+
+#include <cstdint>
+
+/**
+ * This class shares the sequential fit algorithm of @SimpleSegmentManager (@SequentialFitFreeList), but
+ * keeps all of its state (the free list, the statistics and a root object's offset) inside the segment,
+ * with offsets instead of pointers. So a segment which outlives the process (e.g. a file mapped with
+ * MAP_SHARED) can be handed to a new PersistentSegmentManager later, and the heap is restored as is:
+ * nothing is re-parsed or copied.
+ *
+ * The manager formats the segment unless it already holds a heap; isRestored() tells which happened.
+ * The heap's own structures work at any address, but objects keeping raw pointers (e.g. STL containers)
+ * are valid only if the segment is mapped at the address it was formatted at; isRelocated() tells
+ * if it's not.
+ *
+ * Only raw blocks can be persisted as roots. A container using MyAllocator can't: its allocator holds
+ * a SharedPtr to the manager, which lives in the process's own memory and dangles after a restart.
+ *
+ * The lock is a @RobustMutex inside the segment as well, so with Sharing::Shared several processes can
+ * work on one segment (e.g. shared memory) concurrently, each having it mapped at its own address.
+ * A Sharing::Exclusive manager re-initializes the lock when restoring a heap, as nobody else may hold
+ * it (but the process which wrote the heap might have crashed holding it, which a flag next to the lock
+ * tells, and then the heap is checked as below).
+ * If a process dies holding the lock, the next one to take it checks the free list the dead one
+ * might have been changing. Blocks the dead process was allocating may leak, but a broken list
+ * marks the heap inconsistent for good: every call throws from then on.
+ */
+class PersistentSegmentManager
+{
+private:
+    using MemControlBlock = OffsetLinkedBlock;
+    using FreeList = SequentialFitFreeList<OffsetLinks>;
+
+    struct SegmentHeader;
+    class HeapLock;
+
+public:
+    enum class Sharing
+    {
+        Exclusive, // this is the only manager of the segment
+        Shared // other processes may be managing the segment at the same time
+    };
+
+    PersistentSegmentManager(char* segment,
+                             size_t size,
+                             bool verboseDebugging = false,
+                             Sharing sharing = Sharing::Exclusive);
+    ~PersistentSegmentManager() = default;
+
+    PersistentSegmentManager(const PersistentSegmentManager& rhs) = delete;
+    PersistentSegmentManager& operator= (const PersistentSegmentManager& rhs) = delete;
+    PersistentSegmentManager(PersistentSegmentManager&& rhs) = delete;
+    PersistentSegmentManager& operator= (PersistentSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    SegmentManagerStats getStats() const;
+
+    /**
+     * The root object is the entry point to the data kept in the segment, to be found after a restart.
+     * @root must be allocated from this segment (or be null).
+     */
+    void setRoot(const void* root);
+    void* getRoot() const;
+
+    bool isRestored() const
+    {
+        return mRestored;
+    }
+
+    bool isRelocated() const
+    {
+        return mRelocated;
+    }
+
+    /**
+     * Returns the address the heap in @segment was formatted at, or nullptr if @segment doesn't hold a heap
+     * (yet: formatting is complete once this returns non-null). Only the first HEADER_SIZE bytes of
+     * the segment are needed.
+     */
+    static void* formattedAt(const char* segment, size_t size);
+
+    static const size_t HEADER_SIZE; // bytes at the segment's start taken by the manager's state
+
+private:
+    void format(size_t size);
+    void restore(size_t size, Sharing sharing);
+
+    // Takes the lock; if its owner died, checks the heap first. Throws if the heap is inconsistent.
+    void lockHeap() const;
+    // Checks the free list after its owner died & recounts the statistics; false if it's broken
+    bool recoverFreeListUnlocked() const;
+
+    void* allocUnlocked(size_t neededBytes, size_t alignment);
+    void freeUnlocked(void* addr);
+    bool tryExpandUnlocked(void* addr, size_t newBytes);
+    void shrinkUnlocked(void* addr, size_t newBytes);
+    MemControlBlock* getOwnCb(void* addr) const;
+
+    FreeList freeList() const
+    {
+        return FreeList(OffsetLinks{mSegment}, mFreeListHeader);
+    }
+
+    MemControlBlock* cbAt(uint64_t offset) const
+    {
+        return reinterpret_cast<MemControlBlock*>(mSegment + offset);
+    }
+
+    uint64_t offsetOf(const MemControlBlock* cb) const
+    {
+        return reinterpret_cast<const char*>(cb) - mSegment;
+    }
+
+    char* mSegment;
+    SegmentHeader* mHeader;
+    MemControlBlock* mFreeListHeader; // lives in mHeader
+
+    bool mVerboseDebug;
+    bool mRestored;
+    bool mRelocated;
+
+    static const size_t MEM_UNIT_SZ;
+};
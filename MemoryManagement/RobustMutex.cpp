@@ -0,0 +1,42 @@
+#include "RobustMutex.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <cerrno>
+#include <cstring>
+
+void RobustMutex::init()
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int error = pthread_mutex_init(&mMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (error != 0)
+    {
+        throw std::runtime_error(std::string("Cannot init a robust mutex: ") + strerror(error));
+    }
+}
+
+bool RobustMutex::lock()
+{
+    int error = pthread_mutex_lock(&mMutex);
+    if (EOWNERDEAD == error)
+    {
+        // We own the mutex now; mark it usable again, or it becomes unusable once we unlock it
+        pthread_mutex_consistent(&mMutex);
+        return false;
+    }
+    if (error != 0)
+    {
+        throw std::runtime_error(std::string("Cannot lock a robust mutex: ") + strerror(error));
+    }
+    return true;
+}
+
+void RobustMutex::unlock()
+{
+    pthread_mutex_unlock(&mMutex);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <pthread.h>
+
+/**
+ * A mutex which can be placed in memory shared by several processes (PTHREAD_PROCESS_SHARED) and
+ * which survives the death of its owner (PTHREAD_MUTEX_ROBUST): the next lock() takes it over instead
+ * of blocking forever. The data the dead owner was modifying might be left inconsistent; lock()
+ * reports that by returning false.
+ *
+ * The mutex lives right in the shared memory, so it's initialized explicitly, once per segment,
+ * rather than by a constructor. It meets BasicLockable, so std::lock_guard works with it.
+ */
+class RobustMutex
+{
+public:
+    void init();
+
+    /**
+     * Returns false if the previous owner died holding the mutex.
+     */
+    bool lock();
+    void unlock();
+
+private:
+    pthread_mutex_t mMutex;
+};
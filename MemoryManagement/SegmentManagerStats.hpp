@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * A snapshot of a segment manager's state & activity, as returned by its getStats().
+ * All the sizes are in bytes and include the managers' bookkeeping overhead.
+ */
+struct SegmentManagerStats
+{
+    // Free blocks of [16 * 2^i, 16 * 2^(i + 1)) bytes are counted in freeBlocksHistogram[i];
+    // the last bucket counts all the larger blocks as well
+    static constexpr size_t HISTOGRAM_BUCKETS_NUM = 16;
+    static constexpr size_t HISTOGRAM_MIN_BLOCK_SZ = 16;
+
+    size_t segmentBytes = 0;
+    size_t freeBytes = 0;
+    size_t occupiedBytes = 0;
+    size_t peakOccupiedBytes = 0;
+    // The part of the segment backed by memory & the part of that not given back to the OS
+    // by purging free pages (pages the program has never touched count as resident too):
+    size_t committedBytes = 0;
+    size_t residentBytes = 0;
+
+    size_t freeBlocksNum = 0;
+    size_t largestFreeBlockBytes = 0;
+    // 0 if all the free memory is one contiguous block, close to 1 if it's scattered over tiny blocks
+    double fragmentation = 0.0;
+    std::array<size_t, HISTOGRAM_BUCKETS_NUM> freeBlocksHistogram{};
+
+    uint64_t allocsNum = 0;
+    uint64_t freesNum = 0;
+    uint64_t failedAllocsNum = 0;
+
+    /**
+     * Accounts for a free block of @bytes in freeBlocksNum, largestFreeBlockBytes & freeBlocksHistogram.
+     */
+    void addFreeBlock(size_t bytes)
+    {
+        freeBlocksNum++;
+        if (bytes > largestFreeBlockBytes)
+        {
+            largestFreeBlockBytes = bytes;
+        }
+
+        size_t bucket = 0;
+        for (size_t bound = 2 * HISTOGRAM_MIN_BLOCK_SZ; bytes >= bound && bucket < HISTOGRAM_BUCKETS_NUM - 1; bound *= 2)
+        {
+            bucket++;
+        }
+        freeBlocksHistogram[bucket]++;
+    }
+
+    /**
+     * Calculates fragmentation out of freeBytes & largestFreeBlockBytes.
+     */
+    void updateFragmentation()
+    {
+        fragmentation = freeBytes > 0 ? 1.0 - static_cast<double>(largestFreeBlockBytes) / freeBytes : 0.0;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const SegmentManagerStats& stats)
+{
+    os << "segment: " << stats.segmentBytes << " B, free: " << stats.freeBytes
+       << " B, occupied: " << stats.occupiedBytes << " B (peak " << stats.peakOccupiedBytes << " B)"
+       << ", resident: " << stats.residentBytes << " B of " << stats.committedBytes << " B committed"
+       << ", free blocks: " << stats.freeBlocksNum << " (largest " << stats.largestFreeBlockBytes << " B)"
+       << ", fragmentation: " << stats.fragmentation
+       << ", allocs: " << stats.allocsNum << ", frees: " << stats.freesNum
+       << ", failed allocs: " << stats.failedAllocsNum;
+    return os;
+}
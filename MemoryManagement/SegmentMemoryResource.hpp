@@ -0,0 +1,87 @@
+#pragma once
+
+#include "HeapProfiler.hpp"
+#include "MyAllocatorBase.hpp"
+#include "SegmentManagerStats.hpp"
+#include "SharedPtr.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+namespace mybicycles
+{
+
+/**
+ * std::pmr::memory_resource over a segment manager of any type, for std::pmr containers: unlike with the
+ * MyAllocator* allocators, the container type doesn't depend on the segment manager type, so e.g. one
+ * std::pmr::vector<BicycleImpl> can be given a SimpleSegmentManager's segment or the heap at runtime
+ * (at the cost of a virtual call per allocation).
+ *
+ * The alignment asked for is passed on to the segment manager; if it can't provide it (e.g.
+ * FixedBlockSegmentManager beyond max_align_t) or has no block large enough, std::bad_alloc is thrown,
+ * as memory_resource requires. Two resources are equal if they share the segment manager.
+ */
+template <typename SegmentManagerType>
+class SegmentMemoryResource : public std::pmr::memory_resource
+{
+public:
+    using segment_manager_type = SegmentManagerType;
+
+    explicit SegmentMemoryResource(const SharedPtr<SegmentManagerType>& segmentManager) noexcept :
+        mSegmentManager(segmentManager)
+    {
+    }
+
+    SegmentMemoryResource(const SegmentMemoryResource& rhs) = delete;
+    SegmentMemoryResource& operator= (const SegmentMemoryResource& rhs) = delete;
+
+    const SharedPtr<SegmentManagerType>& getSegmentManager() const noexcept
+    {
+        return mSegmentManager;
+    }
+
+    SegmentManagerStats getStats() const
+    {
+        return mSegmentManager ? mSegmentManager->getStats() : SegmentManagerStats();
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* mem = mSegmentManager ? mSegmentManager->alloc(bytes, alignment) : nullptr;
+        if (nullptr == mem)
+        {
+            throw std::bad_alloc();
+        }
+        HeapProfiler::onAlloc(mem, bytes);
+        return mem;
+    }
+
+    void do_deallocate(void* mem, size_t bytes, size_t) override
+    {
+        HeapProfiler::onFree(mem);
+        if constexpr (HasSizedFree<SegmentManagerType>::value)
+        {
+            mSegmentManager->free(mem, bytes);
+        }
+        else
+        {
+            mSegmentManager->free(mem);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+    {
+        if (this == &rhs)
+        {
+            return true;
+        }
+        auto other = dynamic_cast<const SegmentMemoryResource*>(&rhs);
+        return other != nullptr && other->mSegmentManager.get() == mSegmentManager.get();
+    }
+
+    SharedPtr<SegmentManagerType> mSegmentManager;
+};
+
+} // mybicycles
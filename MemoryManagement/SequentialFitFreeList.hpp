@@ -0,0 +1,290 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+SEQUENTIAL FIT FREE LIST of @SimpleSegmentManager & @PersistentSegmentManager:
+
+Every block of the segment, allocated or free, is preceded by a control block (CB) with its size in
+mem units (a unit is a CB's size). The free blocks are linked into a circular list sorted by address,
+which starts & ends at a zero-sized sentinel CB (the header). Allocation is first fit, splitting off
+the rest of the free block when it can hold a CB & at least 1 unit; freeing merges the block with its
+free neighbours.
+
+The segment managers differ in how a CB refers to the next free one, which the Links policy defines:
+    using ControlBlock = ...; // has the size & next members
+    ControlBlock* next(const ControlBlock* cb) const;
+    void setNext(ControlBlock* cb, ControlBlock* next) const;
+Statistics, locking, tracing and pointer validation stay with the segment managers.
+*/
+
+// A CB pointing to the next free one: for segments which are used at one address only
+struct PointerLinkedBlock
+{
+    size_t size; // Size in mem units, not bytes
+    PointerLinkedBlock* next;
+};
+
+struct PointerLinks
+{
+    using ControlBlock = PointerLinkedBlock;
+
+    ControlBlock* next(const ControlBlock* cb) const
+    {
+        return cb->next;
+    }
+
+    void setNext(ControlBlock* cb, ControlBlock* next) const
+    {
+        cb->next = next;
+    }
+};
+
+// A CB keeping the next free one's offset from the segment's start: for segments mapped at different addresses
+struct OffsetLinkedBlock
+{
+    uint64_t size; // Size in mem units, not bytes
+    uint64_t next;
+};
+
+struct OffsetLinks
+{
+    using ControlBlock = OffsetLinkedBlock;
+
+    char* segment;
+
+    ControlBlock* next(const ControlBlock* cb) const
+    {
+        return reinterpret_cast<ControlBlock*>(segment + cb->next);
+    }
+
+    void setNext(ControlBlock* cb, ControlBlock* next) const
+    {
+        cb->next = reinterpret_cast<char*>(next) - segment;
+    }
+};
+
+template <typename Links>
+class SequentialFitFreeList
+{
+public:
+    using ControlBlock = typename Links::ControlBlock;
+
+    static constexpr size_t UNIT_SZ = sizeof(ControlBlock);
+    // The least free block worth keeping: a CB + 1 unit
+    static constexpr size_t MIN_FREE_BLOCK_UNITS = 2;
+
+    SequentialFitFreeList(const Links& links, ControlBlock* header) :
+        mLinks(links),
+        mHeader(header)
+    {
+    }
+
+    // Sets up the list with a single free block of @units units (its CB included) at @firstCb
+    void init(ControlBlock* firstCb, size_t units)
+    {
+        firstCb->size = units - 1; // -1 CB of firstCb
+        mLinks.setNext(firstCb, mHeader);
+        mHeader->size = 0;
+        mLinks.setNext(mHeader, firstCb);
+    }
+
+    static size_t unitsFor(size_t bytes)
+    {
+        size_t units = (bytes + UNIT_SZ - 1) / UNIT_SZ;
+        return 0 == units ? 1 : units;
+    }
+
+    /**
+     * First fit of @neededUnits units aligned to @alignment (a power of 2, at least UNIT_SZ). Returns the
+     * CB of the allocated block, or nullptr. The block may be larger than needed by a remainder too small
+     * to be a free block.
+     */
+    ControlBlock* allocFirstFit(size_t neededUnits, size_t alignment)
+    {
+        ControlBlock* prevCb = mHeader;
+        ControlBlock* currCb = mLinks.next(mHeader);
+        while (currCb != mHeader)
+        {
+            // For over-aligned requests the user's memory might not start right after currCb. The gap
+            // before it (the lead) stays a free block headed by currCb, so it must fit a CB + at least
+            // 1 unit; with the default alignment there's no lead at all.
+            uintptr_t userAddr = reinterpret_cast<uintptr_t>(currCb + 1);
+            uintptr_t alignedAddr = (userAddr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (alignedAddr - userAddr == UNIT_SZ)
+            {
+                alignedAddr += alignment;
+            }
+            size_t leadUnits = (alignedAddr - userAddr) / UNIT_SZ;
+
+            if (currCb->size >= leadUnits + neededUnits)
+            {
+                size_t availableUnits = currCb->size - leadUnits;
+                size_t remainingUnits = availableUnits - neededUnits;
+                ControlBlock* nextFreeCb = mLinks.next(currCb);
+                ControlBlock* retCb = reinterpret_cast<ControlBlock*>(alignedAddr) - 1;
+
+                // Handle partial fit if any: the remainder must hold its own CB + at least 1 unit
+                if (remainingUnits >= MIN_FREE_BLOCK_UNITS)
+                {
+                    ControlBlock* newFreeCb = retCb + 1 + neededUnits;
+                    newFreeCb->size = remainingUnits - 1; // -1 CB of newFreeCb
+                    mLinks.setNext(newFreeCb, nextFreeCb);
+                    nextFreeCb = newFreeCb;
+                    retCb->size = neededUnits;
+                }
+                else
+                {
+                    // Exact fit (or the remainder is too small to be used): hand out the whole rest of the block
+                    retCb->size = availableUnits;
+                }
+
+                if (0 == leadUnits)
+                {
+                    mLinks.setNext(prevCb, nextFreeCb); // remove from freelist
+                }
+                else
+                {
+                    currCb->size = leadUnits - 1; // -1 CB of retCb
+                    mLinks.setNext(currCb, nextFreeCb);
+                }
+                return retCb;
+            }
+
+            prevCb = currCb;
+            currCb = mLinks.next(currCb);
+        }
+        return nullptr;
+    }
+
+    /**
+     * Puts the block of @userCb back into the list, merging it with its free neighbours. The list is
+     * searched from @searchFrom, a free block (or the header) preceding the block. Returns the free block
+     * the block ended up in, or nullptr if it's free already (wholly or within a free block).
+     */
+    ControlBlock* release(ControlBlock* userCb, ControlBlock* searchFrom)
+    {
+        // Find the free blocks surrounding our to-be-freed block:
+        ControlBlock* prevCb = searchFrom != nullptr ? searchFrom : mHeader;
+        ControlBlock* nextCb = mLinks.next(prevCb);
+        while (nextCb != mHeader && nextCb < userCb)
+        {
+            prevCb = nextCb;
+            nextCb = mLinks.next(nextCb);
+        }
+
+        if (nextCb == userCb || (prevCb != mHeader && userCb <= prevCb + prevCb->size))
+        {
+            return nullptr;
+        }
+
+        // If there is free space AFTER our to-be-freed block, merge with that free space:
+        if (nextCb != mHeader && userCb + 1 + userCb->size == nextCb)
+        {
+            userCb->size += nextCb->size + 1;
+            mLinks.setNext(userCb, mLinks.next(nextCb));
+        }
+        else
+        {
+            mLinks.setNext(userCb, nextCb);
+        }
+
+        // If there is free space BEFORE our to-be-freed block, merge with that free space:
+        if (prevCb != mHeader && prevCb + 1 + prevCb->size == userCb)
+        {
+            prevCb->size += userCb->size + 1;
+            mLinks.setNext(prevCb, mLinks.next(userCb));
+            return prevCb;
+        }
+        mLinks.setNext(prevCb, userCb);
+        return userCb;
+    }
+
+    /**
+     * Grows the block of @userCb to @newUnits in place, by taking over (a part of) the free block right
+     * after it. Returns false, leaving the block intact, if there's not enough free space there.
+     */
+    bool expand(ControlBlock* userCb, size_t newUnits)
+    {
+        if (newUnits <= userCb->size)
+        {
+            return true;
+        }
+
+        // Find the free block right after ours (if any):
+        ControlBlock* adjacentCb = userCb + 1 + userCb->size;
+        ControlBlock* prevCb = mHeader;
+        while (mLinks.next(prevCb) != mHeader && mLinks.next(prevCb) < adjacentCb)
+        {
+            prevCb = mLinks.next(prevCb);
+        }
+        if (mLinks.next(prevCb) != adjacentCb)
+        {
+            return false;
+        }
+
+        size_t availableUnits = userCb->size + 1 + adjacentCb->size; // +1 CB of adjacentCb
+        if (availableUnits < newUnits)
+        {
+            return false;
+        }
+
+        size_t remainingUnits = availableUnits - newUnits;
+        if (remainingUnits >= MIN_FREE_BLOCK_UNITS)
+        {
+            // Move the free block's CB forward:
+            ControlBlock* newFreeCb = userCb + 1 + newUnits;
+            mLinks.setNext(newFreeCb, mLinks.next(adjacentCb));
+            newFreeCb->size = remainingUnits - 1; // -1 CB of newFreeCb
+            mLinks.setNext(prevCb, newFreeCb);
+            userCb->size = newUnits;
+        }
+        else
+        {
+            mLinks.setNext(prevCb, mLinks.next(adjacentCb)); // swallow the whole free block
+            userCb->size = availableUnits;
+        }
+        return true;
+    }
+
+    /**
+     * Cuts the block of @userCb down to @newUnits, if the tail is large enough to be a free block.
+     * Returns the tail's CB, to be released by the caller, or nullptr if there's nothing to cut off.
+     */
+    static ControlBlock* cutTail(ControlBlock* userCb, size_t newUnits)
+    {
+        if (newUnits >= userCb->size || userCb->size - newUnits < MIN_FREE_BLOCK_UNITS)
+        {
+            return nullptr;
+        }
+        ControlBlock* tailCb = userCb + 1 + newUnits;
+        tailCb->size = userCb->size - newUnits - 1; // -1 CB of tailCb
+        userCb->size = newUnits;
+        return tailCb;
+    }
+
+    // The free block with the highest address, or the header if there are none
+    ControlBlock* lastFree() const
+    {
+        ControlBlock* lastCb = mHeader;
+        while (mLinks.next(lastCb) != mHeader)
+        {
+            lastCb = mLinks.next(lastCb);
+        }
+        return lastCb;
+    }
+
+    template <typename Visitor>
+    void forEachFree(Visitor&& visitor) const
+    {
+        for (ControlBlock* currCb = mLinks.next(mHeader); currCb != mHeader; currCb = mLinks.next(currCb))
+        {
+            visitor(currCb);
+        }
+    }
+
+private:
+    Links mLinks;
+    ControlBlock* mHeader;
+};
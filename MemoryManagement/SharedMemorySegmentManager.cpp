@@ -0,0 +1,36 @@
+#include "SharedMemorySegmentManager.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // How long to wait for the creator of the segment to format the heap
+    const std::chrono::seconds FORMAT_TIMEOUT(5);
+    const std::chrono::milliseconds FORMAT_POLL_INTERVAL(1);
+
+    char* waitForHeap(const ShmSegment& segment)
+    {
+        if (segment.isCreator())
+        {
+            return segment.data(); // we're the one to format it
+        }
+        auto deadline = std::chrono::steady_clock::now() + FORMAT_TIMEOUT;
+        while (nullptr == PersistentSegmentManager::formattedAt(segment.data(), segment.size()))
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                throw std::runtime_error("Shared memory doesn't hold a heap");
+            }
+            std::this_thread::sleep_for(FORMAT_POLL_INTERVAL);
+        }
+        return segment.data();
+    }
+}
+
+SharedMemorySegmentManager::SharedMemorySegmentManager(const std::string& name, size_t size, bool verboseDebugging) :
+    mSegment(name, size),
+    mManager(waitForHeap(mSegment), mSegment.size(), verboseDebugging, PersistentSegmentManager::Sharing::Shared)
+{
+}
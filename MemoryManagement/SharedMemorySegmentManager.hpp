@@ -0,0 +1,95 @@
+#pragma once
+
+#include "PersistentSegmentManager.hpp"
+#include "ShmSegment.hpp"
+
+#include <string>
+
+/**
+ * This class manages a heap in shared memory: a @ShmSegment managed by a @PersistentSegmentManager
+ * in Sharing::Shared mode. Every process constructs its own SharedMemorySegmentManager with the same
+ * @name; the first one formats the heap, and then all of them can allocate and free concurrently.
+ * The lock is a process-shared robust mutex, so a process dying inside the manager doesn't block
+ * the others. Each process maps the segment at its own address: objects kept there must not hold
+ * raw pointers; use offsets (toOffset()/fromOffset()) instead. getRoot() works in every process.
+ *
+ * The shared memory object outlives the processes until remove() is called.
+ */
+class SharedMemorySegmentManager
+{
+public:
+    SharedMemorySegmentManager(const std::string& name,
+                               size_t size,
+                               bool verboseDebugging = false);
+    ~SharedMemorySegmentManager() = default;
+
+    SharedMemorySegmentManager(const SharedMemorySegmentManager& rhs) = delete;
+    SharedMemorySegmentManager& operator= (const SharedMemorySegmentManager& rhs) = delete;
+    SharedMemorySegmentManager(SharedMemorySegmentManager&& rhs) = delete;
+    SharedMemorySegmentManager& operator= (SharedMemorySegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes)
+    {
+        return mManager.alloc(neededBytes);
+    }
+
+    void* alloc(size_t neededBytes, size_t alignment)
+    {
+        return mManager.alloc(neededBytes, alignment);
+    }
+
+    void free(void* addr)
+    {
+        mManager.free(addr);
+    }
+
+    bool tryExpand(void* addr, size_t newBytes)
+    {
+        return mManager.tryExpand(addr, newBytes);
+    }
+
+    void shrink(void* addr, size_t newBytes)
+    {
+        mManager.shrink(addr, newBytes);
+    }
+
+    void* realloc(void* addr, size_t newBytes)
+    {
+        return mManager.realloc(addr, newBytes);
+    }
+
+    SegmentManagerStats getStats() const
+    {
+        return mManager.getStats();
+    }
+
+    void setRoot(const void* root)
+    {
+        mManager.setRoot(root);
+    }
+
+    void* getRoot() const
+    {
+        return mManager.getRoot();
+    }
+
+    // Position-independent references to the memory of the segment, valid in every process:
+    size_t toOffset(const void* addr) const
+    {
+        return static_cast<const char*>(addr) - mSegment.data();
+    }
+
+    void* fromOffset(size_t offset) const
+    {
+        return mSegment.data() + offset;
+    }
+
+    static bool remove(const std::string& name)
+    {
+        return ShmSegment::unlink(name);
+    }
+
+private:
+    ShmSegment mSegment;
+    PersistentSegmentManager mManager;
+};
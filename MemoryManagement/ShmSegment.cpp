@@ -0,0 +1,82 @@
+#include "ShmSegment.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // How long to wait for the creator of a shared memory object to size it
+    const std::chrono::seconds CREATION_TIMEOUT(5);
+    const std::chrono::milliseconds CREATION_POLL_INTERVAL(1);
+}
+
+ShmSegment::ShmSegment(const std::string& name, size_t size) :
+    mData(nullptr),
+    mSize(0),
+    mCreator(false)
+{
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+    {
+        mCreator = true;
+        if (0 == size || 0 != ftruncate(fd, static_cast<off_t>(size)))
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("Cannot size shared memory " + name);
+        }
+        mSize = size;
+    }
+    else if (EEXIST == errno)
+    {
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open shared memory " + name + ": " + strerror(errno));
+        }
+        // The creator might not have sized it yet:
+        auto deadline = std::chrono::steady_clock::now() + CREATION_TIMEOUT;
+        struct stat shmStat;
+        while (0 == fstat(fd, &shmStat) && 0 == shmStat.st_size && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(CREATION_POLL_INTERVAL);
+        }
+        mSize = static_cast<size_t>(shmStat.st_size);
+        if (0 == mSize)
+        {
+            close(fd);
+            throw std::runtime_error("Shared memory " + name + " was never sized");
+        }
+    }
+    else
+    {
+        throw std::runtime_error("Cannot create shared memory " + name + ": " + strerror(errno));
+    }
+
+    void* mem = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd); // the mapping keeps the object open
+    if (MAP_FAILED == mem)
+    {
+        throw std::runtime_error("Cannot map shared memory " + name + ": " + strerror(error));
+    }
+    mData = static_cast<char*>(mem);
+}
+
+ShmSegment::~ShmSegment()
+{
+    munmap(mData, mSize);
+}
+
+bool ShmSegment::unlink(const std::string& name)
+{
+    return 0 == shm_unlink(name.c_str());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * This class maps a POSIX shared memory object (shm_open) which several processes can map at once.
+ * The first process to open @name creates the object of @size bytes; the others map the object
+ * as it is, each at an address of its own, so only position-independent data may be kept there.
+ * The object is unmapped on destruction but exists until unlink() is called.
+ */
+class ShmSegment
+{
+public:
+    ShmSegment(const std::string& name, size_t size);
+    ~ShmSegment();
+
+    ShmSegment(const ShmSegment& rhs) = delete;
+    ShmSegment& operator= (const ShmSegment& rhs) = delete;
+    ShmSegment(ShmSegment&& rhs) = delete;
+    ShmSegment& operator= (ShmSegment&& rhs) = delete;
+
+    /**
+     * Removes the shared memory object @name; processes which have it mapped keep using it.
+     */
+    static bool unlink(const std::string& name);
+
+    char* data() const
+    {
+        return mData;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool isCreator() const
+    {
+        return mCreator;
+    }
+
+private:
+    char* mData;
+    size_t mSize; // bytes
+    bool mCreator;
+};
@@ -1,11 +1,33 @@
 #include "SimpleSegmentManager.hpp"
+#include "AllocTracer.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace
 {
     const char* V_LOG_TAG = "__SSM__ "; // tag for verbose debugging
+
+    size_t pageSize()
+    {
+        static const size_t sPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return sPageSize;
+    }
+
+    // The share of an epoch's dirty pages allowed to stay resident @epochsAgo epochs later:
+    // goes down from 1 to 0 along a smoothstep curve, the same shape as jemalloc's decay
+    double decayWeight(size_t epochsAgo, size_t epochsNum)
+    {
+        double x = static_cast<double>(epochsAgo + 1) / epochsNum;
+        return 1.0 - x * x * (3.0 - 2.0 * x);
+    }
 }
 
 // All size calculations are made in units equal to MemControlBlock's size.
@@ -14,6 +36,7 @@ const size_t SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ = sizeof(MemControlBlo
 const size_t SimpleSegmentManager::MIN_USABLE_FRAGMENT_CB_SZ = MIN_USABLE_FRAGMENT_SZ + sizeof(MemControlBlock);
 const size_t SimpleSegmentManager::MIN_SEGMENT_SZ =
         sizeof(MemControlBlock) + MIN_USABLE_FRAGMENT_CB_SZ; // free list header + min usable fragment
+const size_t SimpleSegmentManager::BLOCK_OVERHEAD = sizeof(MemControlBlock);
 
 SimpleSegmentManager::SimpleSegmentManager(char* segment,
                                            size_t size, bool verboseDebugging) :
@@ -24,9 +47,33 @@ SimpleSegmentManager::SimpleSegmentManager(char* segment,
     mFreeListHeader(nullptr),
     // Stat data:
     mFreeUnits(0),
-    mOccupUnits(0)
+    mOccupUnits(0),
+    mPeakOccupUnits(0),
+    mAllocsNum(0),
+    mFreesNum(0),
+    mFailedAllocsNum(0),
+    mPurgeMode(PurgeMode::None),
+    mDecayTime(DEFAULT_DECAY_TIME),
+    mFirstPage(0),
+    mPurgedPages(),
+    mPurgedPagesNum(0),
+    mLastDirtyPages(0),
+    mDirtyBacklog(),
+    mEpochStart(),
+    mFreesSinceTick(0),
+    mPurgeCandidates()
 {
     assert(mSegment != nullptr && mSegmentSize != 0);
+
+    // Control blocks must be aligned to the mem unit, so skip the misaligned head of the segment (if any):
+    size_t misalignment = reinterpret_cast<uintptr_t>(mSegment) % MIN_USABLE_FRAGMENT_SZ;
+    if (misalignment != 0)
+    {
+        size_t skip = MIN_USABLE_FRAGMENT_SZ - misalignment;
+        mSegment += skip;
+        mSegmentSize = mSegmentSize > skip ? mSegmentSize - skip : 0;
+    }
+    mSegmentSize -= mSegmentSize % MIN_USABLE_FRAGMENT_SZ; // the tail smaller than a unit is unusable anyway
     // Check we have at least the minimum required amount of usable memory:
     if (mSegmentSize < MIN_SEGMENT_SZ)
     {
@@ -34,15 +81,215 @@ SimpleSegmentManager::SimpleSegmentManager(char* segment,
     }
 
     initStatData();
+    // The header is a zero-sized sentinel at the very beginning of the segment; all the rest
+    // of the segment is a single free block right after it:
     mFreeListHeader = (MemControlBlock*)mSegment;
-    mFreeListHeader->size = mFreeUnits;
-    mFreeListHeader->next = mFreeListHeader; // circular linked list
+    freeList().init(mFreeListHeader + 1, mFreeUnits);
+    ALLOC_TRACE(SegmentInit, mSegment, mSegmentSize);
+}
+
+SegmentManagerStats SimpleSegmentManager::getStats() const
+{
+    SegmentManagerStats stats;
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    stats.failedAllocsNum = mFailedAllocsNum.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    stats.segmentBytes = mSegmentSize;
+    stats.freeBytes = mFreeUnits * MIN_USABLE_FRAGMENT_SZ;
+    stats.occupiedBytes = mOccupUnits * MIN_USABLE_FRAGMENT_SZ;
+    stats.peakOccupiedBytes = mPeakOccupUnits * MIN_USABLE_FRAGMENT_SZ;
+    stats.committedBytes = mSegmentSize;
+    stats.residentBytes = mSegmentSize - std::min(mSegmentSize, mPurgedPagesNum * pageSize());
+
+    freeList().forEachFree([&stats](const MemControlBlock* cb) {
+        stats.addFreeBlock((cb->size + 1) * MIN_USABLE_FRAGMENT_SZ); // +1 CB of cb
+    });
+    stats.updateFragmentation();
+    return stats;
+}
+
+void SimpleSegmentManager::setPurging(PurgeMode mode, std::chrono::milliseconds decayTime)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPurgeMode = mode;
+    mDecayTime = decayTime;
+    if (PurgeMode::None == mode)
+    {
+        return;
+    }
+
+    // A bit per page the segment touches, even partially (extend() adds more):
+    mFirstPage = reinterpret_cast<uintptr_t>(mSegment) / pageSize();
+    size_t pagesNum = (reinterpret_cast<uintptr_t>(mSegment) + mSegmentSize - 1) / pageSize() - mFirstPage + 1;
+    mPurgedPages.resize((pagesNum + 63) / 64, 0);
+    mLastDirtyPages = dirtyPagesUnlocked();
+    mDirtyBacklog.fill(0);
+    mEpochStart = std::chrono::steady_clock::now();
+    mFreesSinceTick = 0;
+}
+
+size_t SimpleSegmentManager::purge()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (PurgeMode::None == mPurgeMode)
+    {
+        return 0;
+    }
+    size_t purgedPages = purgeUnlocked(SIZE_MAX);
+    mLastDirtyPages = dirtyPagesUnlocked();
+    mDirtyBacklog.fill(0);
+    return purgedPages * pageSize();
+}
+
+void SimpleSegmentManager::purgeAfterFreeUnlocked(MemControlBlock* containingCb)
+{
+    if (PurgeMode::None == mPurgeMode)
+    {
+        return;
+    }
+    if (0 == mDecayTime.count())
+    {
+        purgeBlockUnlocked(containingCb, SIZE_MAX);
+    }
+    else if (++mFreesSinceTick >= PURGE_TICK_FREES)
+    {
+        mFreesSinceTick = 0;
+        decayPurgeUnlocked();
+    }
+}
+
+void SimpleSegmentManager::decayPurgeUnlocked()
+{
+    auto epochTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(mDecayTime) / DECAY_EPOCHS_NUM;
+    auto now = std::chrono::steady_clock::now();
+    if (now - mEpochStart < epochTime)
+    {
+        return;
+    }
+    size_t epochsPassed = epochTime.count() > 0 ? static_cast<size_t>((now - mEpochStart) / epochTime) : DECAY_EPOCHS_NUM;
+    mEpochStart += epochTime * epochsPassed;
+
+    // The pages that became dirty since the last epoch go to the newest slot, the older ones age:
+    size_t shift = std::min(epochsPassed, DECAY_EPOCHS_NUM);
+    std::move_backward(mDirtyBacklog.begin(), mDirtyBacklog.end() - shift, mDirtyBacklog.end());
+    std::fill(mDirtyBacklog.begin(), mDirtyBacklog.begin() + shift, 0);
+    size_t dirtyPages = dirtyPagesUnlocked();
+    mDirtyBacklog[0] = dirtyPages > mLastDirtyPages ? dirtyPages - mLastDirtyPages : 0;
+
+    double allowedPages = 0.0;
+    for (size_t i = 0; i < DECAY_EPOCHS_NUM; i++)
+    {
+        allowedPages += mDirtyBacklog[i] * decayWeight(i, DECAY_EPOCHS_NUM);
+    }
+    if (dirtyPages > allowedPages)
+    {
+        size_t purgedPages = purgeUnlocked(dirtyPages - static_cast<size_t>(allowedPages));
+        if (mVerboseDebug)
+        {
+            std::cout << V_LOG_TAG << "Purged " << purgedPages << " of " << dirtyPages << " dirty pages" << std::endl;
+        }
+    }
+    mLastDirtyPages = dirtyPagesUnlocked();
+}
+
+size_t SimpleSegmentManager::purgeUnlocked(size_t maxPages)
+{
+    // The highest blocks first: first fit reuses the lowest ones, so they'd be faulted back in soon
+    mPurgeCandidates.clear();
+    for (MemControlBlock* currCb = mFreeListHeader->next; currCb != mFreeListHeader; currCb = currCb->next)
+    {
+        if ((currCb->size + 1) * MIN_USABLE_FRAGMENT_SZ > pageSize())
+        {
+            mPurgeCandidates.push_back(currCb);
+        }
+    }
+
+    size_t purgedPages = 0;
+    for (auto it = mPurgeCandidates.rbegin(); it != mPurgeCandidates.rend() && purgedPages < maxPages; ++it)
+    {
+        purgedPages += purgeBlockUnlocked(*it, maxPages - purgedPages);
+    }
+    return purgedPages;
+}
+
+size_t SimpleSegmentManager::purgeBlockUnlocked(MemControlBlock* cb, size_t maxPages)
+{
+    // Only the whole pages past the block's CB, which has to stay
+    uintptr_t from = (reinterpret_cast<uintptr_t>(cb + 1) + pageSize() - 1) / pageSize();
+    uintptr_t page = reinterpret_cast<uintptr_t>(cb + 1 + cb->size) / pageSize();
+    auto isPurged = [this](uintptr_t p) {
+        size_t bit = p - mFirstPage;
+        return (mPurgedPages[bit / 64] >> (bit % 64)) & 1;
+    };
+
+    size_t purgedPages = 0;
+    while (page > from && purgedPages < maxPages)
+    {
+        if (isPurged(page - 1))
+        {
+            page--;
+            continue;
+        }
+
+        // A run of pages not purged yet, from its end backwards:
+        uintptr_t runEnd = page;
+        while (page > from && !isPurged(page - 1) && purgedPages < maxPages)
+        {
+            size_t bit = --page - mFirstPage;
+            mPurgedPages[bit / 64] |= uint64_t(1) << (bit % 64);
+            purgedPages++;
+        }
+
+        void* addr = reinterpret_cast<void*>(page * pageSize());
+        size_t len = (runEnd - page) * pageSize();
+        if (PurgeMode::Free == mPurgeMode && 0 != madvise(addr, len, MADV_FREE))
+        {
+            mPurgeMode = PurgeMode::DontNeed; // MADV_FREE needs Linux 4.5 & private anonymous memory
+        }
+        if (PurgeMode::DontNeed == mPurgeMode)
+        {
+            madvise(addr, len, MADV_DONTNEED);
+        }
+    }
+    mPurgedPagesNum += purgedPages;
+    return purgedPages;
+}
+
+void SimpleSegmentManager::markResidentUnlocked(const void* from, const void* to)
+{
+    if (0 == mPurgedPagesNum)
+    {
+        return;
+    }
+    uintptr_t lastByte = std::min(reinterpret_cast<uintptr_t>(to), reinterpret_cast<uintptr_t>(mSegment + mSegmentSize)) - 1;
+    for (uintptr_t page = reinterpret_cast<uintptr_t>(from) / pageSize(); page <= lastByte / pageSize(); page++)
+    {
+        size_t bit = page - mFirstPage;
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        if (mPurgedPages[bit / 64] & mask)
+        {
+            mPurgedPages[bit / 64] &= ~mask;
+            mPurgedPagesNum--;
+        }
+    }
+}
+
+size_t SimpleSegmentManager::dirtyPagesUnlocked() const
+{
+    size_t freePages = mFreeUnits * MIN_USABLE_FRAGMENT_SZ / pageSize();
+    return freePages > mPurgedPagesNum ? freePages - mPurgedPagesNum : 0;
 }
 
 void SimpleSegmentManager::printFreeList() const
 {
     std::lock_guard<std::mutex> lock(mMutex);
+    printFreeListUnlocked();
+}
 
+void SimpleSegmentManager::printFreeListUnlocked() const
+{
     std::cout << "-------- FREE LIST LAYOUT ---------" << std::endl;
     std::cout << "Header addr: " << reinterpret_cast<long>((void*)mFreeListHeader)
               << ", next free CB: " << reinterpret_cast<long>((void*)mFreeListHeader->next) << std::endl;
@@ -61,6 +308,7 @@ void SimpleSegmentManager::initStatData()
 {
     mFreeUnits = (mSegmentSize / MIN_USABLE_FRAGMENT_SZ) - 1; // -1 for initial CB as mFreeListHeader
     mOccupUnits = 1;
+    mPeakOccupUnits = mOccupUnits;
 
     if (mVerboseDebug)
     {
@@ -90,13 +338,17 @@ void SimpleSegmentManager::incrStatData(size_t neededBytes, size_t neededUnitsWi
 
     mOccupUnits += neededUnitsWithCb;
     mFreeUnits -= neededUnitsWithCb;
+    if (mOccupUnits > mPeakOccupUnits)
+    {
+        mPeakOccupUnits = mOccupUnits;
+    }
 
     if (mVerboseDebug)
     {
         std::cout << V_LOG_TAG << "------- ALLOC END --------" << std::endl;
         std::cout << V_LOG_TAG << "Updated free units: " << mFreeUnits << " --> " << mFreeUnits * MIN_USABLE_FRAGMENT_SZ << " bytes.\n"
                   << V_LOG_TAG << "Updated occupied units (with CBs): " << mOccupUnits << std::endl;
-        printFreeList();
+        printFreeListUnlocked();
     }
 }
 
@@ -112,7 +364,7 @@ void SimpleSegmentManager::decrStatData(void* addr, size_t freedUnits)
         std::cout << V_LOG_TAG << "Updated free units: " << mFreeUnits
                                << " --> free bytes: " << mFreeUnits * MIN_USABLE_FRAGMENT_SZ
                                << ", occupied units (with CBs): " << mOccupUnits << std::endl;
-        printFreeList();
+        printFreeListUnlocked();
         std::cout << std::endl;
     }
 }
@@ -120,60 +372,207 @@ void SimpleSegmentManager::decrStatData(void* addr, size_t freedUnits)
 void* SimpleSegmentManager::alloc(size_t neededBytes)
 {
     std::lock_guard<std::mutex> lock(mMutex);
+    return allocUnlocked(neededBytes, MIN_USABLE_FRAGMENT_SZ);
+}
+
+void SimpleSegmentManager::free(void* addr)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    freeUnlocked(addr);
+}
+
+size_t SimpleSegmentManager::allocBatch(size_t count, size_t neededBytes, void** out)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return allocBatchUnlocked(count, neededBytes, out);
+}
+
+void SimpleSegmentManager::freeBatch(void** ptrs, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    freeBatchUnlocked(ptrs, count);
+}
+
+size_t SimpleSegmentManager::tryFreeBatch(void** ptrs, size_t count, AllocError& error) noexcept
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return tryFreeBatchUnlocked(ptrs, count, error);
+}
+
+bool SimpleSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!tryExpandUnlocked(addr, newBytes))
+    {
+        return false;
+    }
+    ALLOC_TRACE(Resize, addr, newBytes);
+    return true;
+}
+
+void SimpleSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    shrinkUnlocked(addr, newBytes);
+    ALLOC_TRACE(Resize, addr, newBytes);
+}
+
+void* SimpleSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (nullptr == addr)
+    {
+        return allocUnlocked(newBytes, MIN_USABLE_FRAGMENT_SZ);
+    }
+
+    if (tryExpandUnlocked(addr, newBytes))
+    {
+        shrinkUnlocked(addr, newBytes); // no-op unless it's actually a shrink
+        ALLOC_TRACE(Resize, addr, newBytes);
+        return addr;
+    }
+
+    // Traced as an Alloc & a Free
+    void* newAddr = allocUnlocked(newBytes, MIN_USABLE_FRAGMENT_SZ);
+    if (newAddr != nullptr)
+    {
+        std::memcpy(newAddr, addr, usableSize(addr)); // the old block is smaller than the new one
+        freeUnlocked(addr);
+    }
+    return newAddr;
+}
+
+SimpleSegmentManager::MemControlBlock* SimpleSegmentManager::getOwnCb(void* addr) const
+{
+    if (nullptr == addr)
+    {
+        throw std::invalid_argument("Cannot resize a null pointer");
+    }
+
+    MemControlBlock* userCb = (MemControlBlock*)addr - 1;
+    if ((char*)userCb < mSegment + sizeof(MemControlBlock) || (char*)userCb >= mSegment + mSegmentSize ||
+        ((char*)userCb - mSegment) % MIN_USABLE_FRAGMENT_SZ != 0)
+    {
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+    return userCb;
+}
+
+bool SimpleSegmentManager::tryExpandUnlocked(void* addr, size_t newBytes)
+{
+    MemControlBlock* userCb = getOwnCb(addr);
+    size_t oldUnits = userCb->size;
+    if (!freeList().expand(userCb, FreeList::unitsFor(newBytes)))
+    {
+        return false;
+    }
+    if (userCb->size != oldUnits)
+    {
+        incrStatData(newBytes, userCb->size - oldUnits);
+        markResidentUnlocked(userCb + 1 + oldUnits, userCb + 2 + userCb->size); // +2: as in allocUnlocked()
+    }
+    return true;
+}
+
+void SimpleSegmentManager::shrinkUnlocked(void* addr, size_t newBytes)
+{
+    // Turn the tail into a separate block and free it, which merges it with the free space after it:
+    MemControlBlock* tailCb = FreeList::cutTail(getOwnCb(addr), FreeList::unitsFor(newBytes));
+    if (tailCb != nullptr)
+    {
+        releaseUnlocked(tailCb + 1);
+    }
+}
+
+void SimpleSegmentManager::extend(size_t additionalBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t additionalUnits = additionalBytes / MIN_USABLE_FRAGMENT_SZ;
+    if (additionalUnits * MIN_USABLE_FRAGMENT_SZ < MIN_USABLE_FRAGMENT_CB_SZ)
+    {
+        return; // too small to make a block of
+    }
+
+    // Pretend the new space is an allocated block and free it: this merges it with the free tail
+    MemControlBlock* newCb = (MemControlBlock*)(mSegment + mSegmentSize);
+    newCb->size = additionalUnits - 1; // -1 CB of newCb
+    mSegmentSize += additionalUnits * MIN_USABLE_FRAGMENT_SZ;
+    mOccupUnits += additionalUnits;
+    if (!mPurgedPages.empty())
+    {
+        size_t pagesNum = (reinterpret_cast<uintptr_t>(mSegment) + mSegmentSize - 1) / pageSize() - mFirstPage + 1;
+        mPurgedPages.resize((pagesNum + 63) / 64, 0);
+    }
+    ALLOC_TRACE(SegmentInit, mSegment, mSegmentSize); // the analyzer updates the segment's bounds
+
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Segment extended by " << additionalUnits * MIN_USABLE_FRAGMENT_SZ
+                               << " bytes, new size: " << mSegmentSize << std::endl;
+    }
+    releaseUnlocked(newCb + 1);
+}
+
+bool SimpleSegmentManager::reachesEnd(void* addr) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    MemControlBlock* userCb = getOwnCb(addr);
+    MemControlBlock* segmentEnd = (MemControlBlock*)(mSegment + mSegmentSize);
+    MemControlBlock* adjacentCb = userCb + 1 + userCb->size;
+    if (adjacentCb == segmentEnd)
+    {
+        return true;
+    }
+
+    // The free list is sorted by address, so the free block at the end (if any) is the last one:
+    return freeList().lastFree() == adjacentCb && adjacentCb + 1 + adjacentCb->size == segmentEnd;
+}
 
-    size_t neededUnitsWithCb = ((neededBytes + MIN_USABLE_FRAGMENT_SZ - 1) / MIN_USABLE_FRAGMENT_SZ) + 1;
-    size_t neededUnits = neededUnitsWithCb - 1;
-    MemControlBlock* retCb = nullptr;
+size_t SimpleSegmentManager::usableSize(const void* addr)
+{
+    return ((const MemControlBlock*)addr - 1)->size * MIN_USABLE_FRAGMENT_SZ;
+}
+
+void* SimpleSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return allocUnlocked(neededBytes, alignment);
+}
+
+void* SimpleSegmentManager::allocUnlocked(size_t neededBytes, size_t alignment)
+{
+    if (0 == alignment || (alignment & (alignment - 1)) != 0)
+    {
+        return nullptr; // not a power of 2
+    }
+    if (alignment < MIN_USABLE_FRAGMENT_SZ)
+    {
+        alignment = MIN_USABLE_FRAGMENT_SZ; // every block is aligned to the mem unit anyway
+    }
+
+    size_t neededUnits = FreeList::unitsFor(neededBytes);
+    size_t neededUnitsWithCb = neededUnits + 1;
     void* retAddr = nullptr;
 
-    // Base case: we are starting from scratch, mem segment is completely free
-    if (mFreeListHeader->next == mFreeListHeader)
+    // First fit: walk the free list until a large enough block is found
+    MemControlBlock* retCb = freeList().allocFirstFit(neededUnits, alignment);
+    if (retCb != nullptr)
     {
-        if (mFreeListHeader->size >= neededUnitsWithCb)
-        {
-            // Mem block to return to user + its CB right before it:
-            retCb = mFreeListHeader + 1;
-            retAddr = (void*)(retCb + 1);
-            retCb->size = neededUnits;
-            // Update free list:
-            MemControlBlock* newFreeCb = (MemControlBlock*)((char*)retAddr + neededBytes);
-            newFreeCb->size = mFreeUnits - neededUnitsWithCb - 1; // -1 CB of newFreeCb
-            newFreeCb->next = mFreeListHeader;
-            mFreeListHeader->next = newFreeCb;
-            incrStatData(neededBytes, neededUnitsWithCb);
-        }
+        incrStatData(neededBytes, retCb->size + 1);
+        markResidentUnlocked(retCb, retCb + 2 + retCb->size); // +2: retCb & the CB after the block
+        retAddr = retCb + 1;
+    }
+
+    if (retAddr != nullptr)
+    {
+        mAllocsNum.fetch_add(1, std::memory_order_relaxed);
+        ALLOC_TRACE(Alloc, retAddr, neededBytes);
     }
     else
     {
-        MemControlBlock* prevCb = mFreeListHeader;
-        MemControlBlock* currCb = mFreeListHeader->next;
-        while (currCb != mFreeListHeader)
-        {
-            if (currCb->size >= neededUnits)
-            {
-                size_t remainingUnits = currCb->size - neededUnits;
-
-                retCb = currCb;
-                retAddr = (void*)(retCb + 1);
-                retCb->size = neededUnits;
-
-                // Handle partial fit if any
-                MemControlBlock* newFreeCb = nullptr;
-                if (remainingUnits >= MIN_USABLE_FRAGMENT_CB_SZ)
-                {
-                    newFreeCb = (MemControlBlock*)((char*)retAddr + neededBytes);
-                    newFreeCb->size = remainingUnits - 1; // -1 CB of newFreeCb
-                    newFreeCb->next = currCb->next;
-                }
-
-                prevCb->next = newFreeCb; // remove from freelist
-                incrStatData(neededBytes, neededUnitsWithCb + (remainingUnits >= MIN_USABLE_FRAGMENT_CB_SZ ? 1 : 0)); // +1 CB of newFreeCb
-                break; // proceed to returning an address
-            }
-
-            prevCb = currCb;
-            currCb = currCb->next;
-        }
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+        ALLOC_TRACE(Failure, nullptr, neededBytes);
     }
 
     if (mVerboseDebug)
@@ -194,66 +593,184 @@ void* SimpleSegmentManager::alloc(size_t neededBytes)
     return retAddr;
 }
 
-void SimpleSegmentManager::free(void* addr)
+void SimpleSegmentManager::freeUnlocked(void* addr)
+{
+    MemControlBlock* containingCb = releaseUnlocked(addr);
+    mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    ALLOC_TRACE(Free, addr, 0);
+    purgeAfterFreeUnlocked(containingCb);
+}
+
+AllocError SimpleSegmentManager::tryFree(void* addr) noexcept
 {
     std::lock_guard<std::mutex> lock(mMutex);
-    if (nullptr == addr)
+    AllocError error = AllocError::None;
+    MemControlBlock* containingCb = tryReleaseUnlocked(addr, nullptr, error);
+    if (nullptr == containingCb)
     {
-        throw std::invalid_argument("Cannot free a null pointer");
+        return error;
     }
+    mFreesNum.fetch_add(1, std::memory_order_relaxed);
+    ALLOC_TRACE(Free, addr, 0);
+    purgeAfterFreeUnlocked(containingCb);
+    return AllocError::None;
+}
 
-    MemControlBlock* userCb = (MemControlBlock*)addr - 1;
-
-    // Ensure the block belongs to us:
-    char* startAddress = mSegment;
-    char* endAddress = startAddress + mSegmentSize;
-    if ((char*)userCb < startAddress || (char*)userCb >= endAddress) {
-        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+size_t SimpleSegmentManager::allocBatchUnlocked(size_t count, size_t neededBytes, void** out)
+{
+    size_t neededUnits = (neededBytes + MIN_USABLE_FRAGMENT_SZ - 1) / MIN_USABLE_FRAGMENT_SZ;
+    if (0 == neededUnits)
+    {
+        neededUnits = 1;
     }
+    size_t neededUnitsWithCb = neededUnits + 1;
+    size_t allocated = 0;
 
-    // Check if the block is already freed:
+    MemControlBlock* prevCb = mFreeListHeader;
     MemControlBlock* currCb = mFreeListHeader->next;
-    while (currCb != mFreeListHeader)
+    while (allocated < count && currCb != mFreeListHeader)
     {
-        if (currCb == userCb)
+        if (currCb->size < neededUnits)
         {
-            throw std::runtime_error("Memory block is already freed");
+            prevCb = currCb;
+            currCb = currCb->next;
+            continue;
         }
-        currCb = currCb->next;
+
+        // Carve as many blocks as fit (and are needed) from the front of the free block:
+        size_t totalUnits = currCb->size + 1; // +1 CB of currCb
+        size_t carvedNum = std::min(totalUnits / neededUnitsWithCb, count - allocated);
+        size_t remainingUnits = totalUnits - carvedNum * neededUnitsWithCb;
+        MemControlBlock* nextFreeCb = currCb->next;
+        MemControlBlock* retCb = currCb;
+        for (size_t i = 0; i < carvedNum; i++, retCb += neededUnitsWithCb)
+        {
+            retCb->size = neededUnits;
+            out[allocated++] = retCb + 1;
+            incrStatData(neededBytes, neededUnitsWithCb);
+            ALLOC_TRACE(Alloc, retCb + 1, neededBytes);
+        }
+        markResidentUnlocked(currCb, retCb + 1); // +1: the remainder's CB
+
+        if (remainingUnits * MIN_USABLE_FRAGMENT_SZ >= MIN_USABLE_FRAGMENT_CB_SZ)
+        {
+            // What's left stays a free block, right after the carved ones
+            retCb->size = remainingUnits - 1; // -1 CB of retCb
+            retCb->next = nextFreeCb;
+            prevCb->next = retCb;
+            prevCb = retCb;
+        }
+        else
+        {
+            // The last carved block takes the remainder too small to be used
+            (retCb - neededUnitsWithCb)->size += remainingUnits;
+            mOccupUnits += remainingUnits;
+            mFreeUnits -= remainingUnits;
+            prevCb->next = nextFreeCb;
+        }
+        currCb = nextFreeCb;
     }
 
-    // Insert the block back into the freelist:
-    MemControlBlock* prevCb = mFreeListHeader;
-    currCb = mFreeListHeader->next;
+    mAllocsNum.fetch_add(allocated, std::memory_order_relaxed);
+    if (allocated < count)
+    {
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+        ALLOC_TRACE(Failure, nullptr, neededBytes);
+    }
+    if (mPeakOccupUnits < mOccupUnits)
+    {
+        mPeakOccupUnits = mOccupUnits;
+    }
+    return allocated;
+}
 
-    while (currCb != mFreeListHeader)
+void SimpleSegmentManager::freeBatchUnlocked(void** ptrs, size_t count)
+{
+    AllocError error = AllocError::None;
+    tryFreeBatchUnlocked(ptrs, count, error);
+    if (error != AllocError::None)
     {
-        // If there is free space AFTER our to-be-freed block, merge with that free space:
-        if (currCb == (userCb + sizeof(MemControlBlock) + userCb->size))
+        throwFreeError(error);
+    }
+}
+
+size_t SimpleSegmentManager::tryFreeBatchUnlocked(void** ptrs, size_t count, AllocError& error)
+{
+    // Runs of ascending addresses continue the free list search where the previous block landed;
+    // anything else starts over from the header, which costs the same as a plain free() would.
+    // (Sorting the batch first doesn't pay off: node containers release their nodes in order, or close to it.)
+    MemControlBlock* searchFrom = mFreeListHeader;
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((MemControlBlock*)ptrs[i] <= searchFrom)
         {
-            userCb->size += currCb->size + 1;
-            userCb->next = currCb->next;
-            prevCb->next = userCb;
-            decrStatData(addr, userCb->size);
-            break;
+            searchFrom = mFreeListHeader;
         }
-        // If there is free space BEFORE our to-be-freed block, merge with that free space:
-        if ((currCb + sizeof(MemControlBlock) + currCb->size) == userCb)
+        searchFrom = tryReleaseUnlocked(ptrs[i], searchFrom, error);
+        if (error != AllocError::None)
         {
-            currCb->size += userCb->size + 1;
-            decrStatData(addr, currCb->size);
-            break;
+            return i;
         }
+        mFreesNum.fetch_add(1, std::memory_order_relaxed);
+        ALLOC_TRACE(Free, ptrs[i], 0);
+        purgeAfterFreeUnlocked(searchFrom);
+    }
+    return count;
+}
 
-        prevCb = currCb;
-        currCb = currCb->next;
+SimpleSegmentManager::MemControlBlock* SimpleSegmentManager::releaseUnlocked(void* addr, MemControlBlock* searchFrom)
+{
+    AllocError error = AllocError::None;
+    MemControlBlock* containingCb = tryReleaseUnlocked(addr, searchFrom, error);
+    if (error != AllocError::None)
+    {
+        throwFreeError(error);
+    }
+    return containingCb;
+}
 
-        // If we've looped back to the start, insert the block
-        if (currCb == mFreeListHeader) {
-            userCb->next = currCb->next;
-            currCb->next = userCb;
-            decrStatData(addr, userCb->size);
-            break;
-        }
+void SimpleSegmentManager::throwFreeError(AllocError error)
+{
+    switch (error)
+    {
+    case AllocError::NullPointer:
+        throw std::invalid_argument("Cannot free a null pointer");
+    case AllocError::DoubleFree:
+        throw std::runtime_error("Memory block is already freed");
+    default:
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+}
+
+SimpleSegmentManager::MemControlBlock* SimpleSegmentManager::tryReleaseUnlocked(void* addr,
+                                                                                MemControlBlock* searchFrom,
+                                                                                AllocError& error) noexcept
+{
+    if (nullptr == addr)
+    {
+        error = AllocError::NullPointer;
+        return nullptr;
+    }
+
+    MemControlBlock* userCb = (MemControlBlock*)addr - 1;
+
+    // Ensure the block belongs to us:
+    char* startAddress = mSegment + sizeof(MemControlBlock); // the header is never handed out
+    char* endAddress = mSegment + mSegmentSize;
+    if ((char*)userCb < startAddress || (char*)userCb >= endAddress ||
+        ((char*)userCb - mSegment) % MIN_USABLE_FRAGMENT_SZ != 0) {
+        error = AllocError::InvalidPointer;
+        return nullptr;
     }
+
+    size_t freedUnits = userCb->size + 1; // +1 CB of userCb
+    MemControlBlock* containingCb = freeList().release(userCb, searchFrom);
+    if (nullptr == containingCb)
+    {
+        error = AllocError::DoubleFree;
+        return nullptr;
+    }
+
+    decrStatData(addr, freedUnits);
+    return containingCb;
 }
@@ -1,6 +1,15 @@
 #pragma once
 
+#include "AllocError.hpp"
+#include "SegmentManagerStats.hpp"
+#include "SequentialFitFreeList.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 
 // TODO _IK_:
 // Implement rbtree_best_fit algorithm (best-fit logarithmic-time complexity allocation)
@@ -15,14 +24,21 @@
  */
 class SimpleSegmentManager
 {
+    friend class ThreadCacheSegmentManager;
+
 private:
-    struct MemControlBlock
+    using MemControlBlock = PointerLinkedBlock;
+    using FreeList = SequentialFitFreeList<PointerLinks>;
+
+public:
+    // How free pages are given back to the OS, see setPurging()
+    enum class PurgeMode
     {
-        size_t size; // Size in mem units, not bytes. Mem unit size is implementation-defined
-        MemControlBlock* next;
+        None, // free blocks stay resident
+        DontNeed, // MADV_DONTNEED: the pages are dropped right away & read as zeros afterwards
+        Free // MADV_FREE: the kernel drops them lazily, under memory pressure (falls back to DontNeed)
     };
 
-public:
     SimpleSegmentManager(char* segment,
                          size_t size,
                          bool verboseDebugging = false);
@@ -34,14 +50,138 @@ public:
     SimpleSegmentManager& operator= (SimpleSegmentManager&& rhs) = delete;
 
     void* alloc(size_t neededBytes);
+    /**
+     * Allocates a block aligned to @alignment (a power of 2). The space skipped to get the alignment
+     * stays free unless it's too small to hold a block.
+     */
+    void* alloc(size_t neededBytes, size_t alignment);
     void free(void* addr);
+    // free() which returns the error instead of throwing it
+    AllocError tryFree(void* addr) noexcept;
+
+    /**
+     * Allocates up to @count blocks of @neededBytes each under a single lock acquisition, carving as many
+     * of them as fit out of every free block in turn, so they are mostly adjacent. The blocks are written
+     * to @out in ascending address order. Returns the number of blocks allocated, which is less than
+     * @count only if the segment ran out of memory.
+     */
+    size_t allocBatch(size_t count, size_t neededBytes, void** out);
+    /**
+     * Frees @count blocks under a single lock acquisition. While @ptrs ascend, the free list is walked only
+     * once for all of them. An invalid pointer throws, the pointers before it being freed.
+     */
+    void freeBatch(void** ptrs, size_t count);
+    // freeBatch() which stops at the first pointer it can't free rather than throwing: sets @error & returns
+    // the number of pointers freed, i.e. the index of the bad one
+    size_t tryFreeBatch(void** ptrs, size_t count, AllocError& error) noexcept;
+
+    /**
+     * Tries to grow the block at @addr to @newBytes in place, by taking over (a part of) the free
+     * block right after it. Returns false, leaving the block intact, if there's not enough free space there.
+     */
+    bool tryExpand(void* addr, size_t newBytes);
+    /**
+     * Shrinks the block at @addr to @newBytes in place; the freed tail (if large enough) becomes free.
+     */
+    void shrink(void* addr, size_t newBytes);
+    /**
+     * Resizes the block at @addr in place if possible; otherwise allocates a new block, copies the
+     * contents bytewise & frees the old block. Returns nullptr (keeping the old block) on failure.
+     */
+    void* realloc(void* addr, size_t newBytes);
+
+    /**
+     * Returns the number of bytes actually usable at @addr, which must have been returned by alloc().
+     * It is never less than the number of bytes requested, but might be greater.
+     */
+    static size_t usableSize(const void* addr);
+
+    /**
+     * Appends @additionalBytes to the end of the managed segment. The caller guarantees that this memory
+     * immediately follows the segment and is usable.
+     */
+    void extend(size_t additionalBytes);
+    /**
+     * Whether the block at @addr ends where the segment does, right away or after a free block: then
+     * extend() makes room for the block to grow in place, and otherwise it doesn't.
+     */
+    bool reachesEnd(void* addr) const;
+
+    /**
+     * Makes the manager give the whole pages inside its free blocks back to the OS with madvise(), so
+     * that memory freed after a spike stops being resident. The segment must be private anonymous
+     * memory (MmapSegment, HugePageSegment, a large heap array): purged pages read as zeros or keep
+     * stale data, which is fine for free blocks only. Allocating a block that covers purged pages needs
+     * no special care, the kernel faults them back in on the first touch.
+     *
+     * Purging is rate-limited the way jemalloc's dirty page decay is: the pages that became free during
+     * each of the last DECAY_EPOCHS_NUM epochs of @decayTime are allowed to stay resident for a share
+     * that goes down smoothly from 1 to 0 over @decayTime; whatever is above that is purged, at high
+     * addresses first (first fit reuses the low ones). So a spike is given back within @decayTime after
+     * it's over, while churn within @decayTime doesn't pay for madvise() & page faults at all.
+     * The clock is checked every PURGE_TICK_FREES frees. With a zero @decayTime, each free purges
+     * the block it lands in right away.
+     */
+    void setPurging(PurgeMode mode, std::chrono::milliseconds decayTime = DEFAULT_DECAY_TIME);
+    /**
+     * Purges all the free pages right away, regardless of the decay (but not with PurgeMode::None).
+     * Returns the number of bytes purged.
+     */
+    size_t purge();
+
+    /**
+     * Returns a snapshot of the segment's usage. The free list is walked under the lock, so it's
+     * meant for monitoring rather than for the hot path.
+     */
+    SegmentManagerStats getStats() const;
+
+    // Bookkeeping bytes which precede every allocated block:
+    static const size_t BLOCK_OVERHEAD;
+
+    static constexpr std::chrono::milliseconds DEFAULT_DECAY_TIME{10000};
+    static constexpr size_t DECAY_EPOCHS_NUM = 20;
+    static constexpr size_t PURGE_TICK_FREES = 64;
 
 private:
+    // The same as alloc()/free() but to be called with mMutex held:
+    void* allocUnlocked(size_t neededBytes, size_t alignment);
+    void freeUnlocked(void* addr);
+    size_t allocBatchUnlocked(size_t count, size_t neededBytes, void** out);
+    void freeBatchUnlocked(void** ptrs, size_t count);
+    size_t tryFreeBatchUnlocked(void** ptrs, size_t count, AllocError& error);
+    // freeUnlocked() which doesn't count as a user's free. The free list is searched from @searchFrom,
+    // a free block (or the header) preceding @addr. Returns the free block @addr ended up in.
+    MemControlBlock* releaseUnlocked(void* addr, MemControlBlock* searchFrom = nullptr);
+    // The same, but returns nullptr & sets @error rather than throwing if @addr can't be freed
+    MemControlBlock* tryReleaseUnlocked(void* addr, MemControlBlock* searchFrom, AllocError& error) noexcept;
+    // Throws what free() does for a pointer tryReleaseUnlocked() rejected with @error
+    static void throwFreeError(AllocError error);
+    bool tryExpandUnlocked(void* addr, size_t newBytes);
+    void shrinkUnlocked(void* addr, size_t newBytes);
+    MemControlBlock* getOwnCb(void* addr) const;
+
+    FreeList freeList() const
+    {
+        return FreeList(PointerLinks(), mFreeListHeader);
+    }
+
+    // Purging, to be called with mMutex held:
+    void purgeAfterFreeUnlocked(MemControlBlock* containingCb);
+    void decayPurgeUnlocked();
+    // Purges up to @maxPages pages of the free blocks, the highest ones first. Returns the pages purged.
+    size_t purgeUnlocked(size_t maxPages);
+    // Purges the pages of the free block @cb not purged yet, up to @maxPages of them, the highest ones first
+    size_t purgeBlockUnlocked(MemControlBlock* cb, size_t maxPages);
+    // Called for memory which is about to be written to: its pages are resident again
+    void markResidentUnlocked(const void* from, const void* to);
+    size_t dirtyPagesUnlocked() const;
+
     void initStatData();
     void incrStatData(size_t neededBytes, size_t neededUnitsWithCb);
     void decrStatData(void *addr, size_t freedUnits);
 
     void printFreeList() const;
+    void printFreeListUnlocked() const;
 
     char* mSegment;
     size_t mSegmentSize; // bytes
@@ -54,6 +194,23 @@ private:
     // Statistics data:
     size_t mFreeUnits;
     size_t mOccupUnits;
+    size_t mPeakOccupUnits;
+    // Updated with relaxed ordering, as nothing else is synchronised through them:
+    std::atomic<uint64_t> mAllocsNum;
+    std::atomic<uint64_t> mFreesNum;
+    std::atomic<uint64_t> mFailedAllocsNum;
+
+    // Purging data:
+    PurgeMode mPurgeMode;
+    std::chrono::milliseconds mDecayTime;
+    uintptr_t mFirstPage; // index of the segment's first page in the address space
+    std::vector<uint64_t> mPurgedPages; // a bit per page of the segment
+    size_t mPurgedPagesNum;
+    size_t mLastDirtyPages; // free & resident pages after the previous epoch
+    std::array<size_t, DECAY_EPOCHS_NUM> mDirtyBacklog; // pages that became dirty in each epoch, newest first
+    std::chrono::steady_clock::time_point mEpochStart;
+    size_t mFreesSinceTick;
+    std::vector<MemControlBlock*> mPurgeCandidates; // kept to avoid reallocating it on every purge
 
     // Minimum required size of a fragment that can be allocated to user:
     static const size_t MIN_USABLE_FRAGMENT_SZ;
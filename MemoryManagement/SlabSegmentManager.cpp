@@ -0,0 +1,359 @@
+#include "SlabSegmentManager.hpp"
+#include "AllocTracer.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const char* V_LOG_TAG = "__SLSM__ "; // tag for verbose debugging
+
+    // The slab header takes a whole number of cache lines, so colouring shifts objects by cache lines too
+    const size_t SLAB_HEADER_SZ = 64;
+
+    // The backing manager's control block of the next block takes the last bytes of a slab's chunk.
+    // That's what makes slabs allocated one after another fill their chunks back to back.
+    const size_t SLAB_USABLE_SZ = SlabSegmentManager::SLAB_SZ - SimpleSegmentManager::BLOCK_OVERHEAD;
+}
+
+void SlabSegmentManager::SlabList::push(Slab* slab)
+{
+    slab->prev = nullptr;
+    slab->next = head;
+    if (head != nullptr)
+    {
+        head->prev = slab;
+    }
+    head = slab;
+    size++;
+}
+
+void SlabSegmentManager::SlabList::remove(Slab* slab)
+{
+    if (slab->prev != nullptr)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        head = slab->next;
+    }
+    if (slab->next != nullptr)
+    {
+        slab->next->prev = slab->prev;
+    }
+    size--;
+}
+
+SlabSegmentManager::SlabSegmentManager(char* segment, size_t size, bool verboseDebugging) :
+    mFirstChunk(reinterpret_cast<uintptr_t>(segment) / SLAB_SZ),
+    mChunksNum((reinterpret_cast<uintptr_t>(segment) + size - 1) / SLAB_SZ - mFirstChunk + 1),
+    mVerboseDebug(verboseDebugging),
+    mBacking(segment, size, verboseDebugging),
+    mSlabMap(nullptr),
+    mCaches(),
+    mAllocsNum(0),
+    mFreesNum(0),
+    mFailedAllocsNum(0)
+{
+    static_assert(sizeof(Slab) <= SLAB_HEADER_SZ, "Slab header doesn't fit");
+    static_assert((SLAB_SZ & (SLAB_SZ - 1)) == 0, "Slab size must be a power of 2");
+
+    mSlabMap = static_cast<uint8_t*>(mBacking.alloc(mChunksNum));
+    if (nullptr == mSlabMap)
+    {
+        throw std::runtime_error("Segment is too small to be used");
+    }
+    std::memset(mSlabMap, 0, mChunksNum);
+
+    for (size_t i = 0; i < CACHES_NUM; i++)
+    {
+        Cache& cache = mCaches[i];
+        cache.objectSize = (i + 1) * OBJECT_ALIGNMENT;
+        cache.objectsPerSlab = static_cast<uint32_t>((SLAB_USABLE_SZ - SLAB_HEADER_SZ) / cache.objectSize);
+        size_t leftover = SLAB_USABLE_SZ - SLAB_HEADER_SZ - cache.objectsPerSlab * cache.objectSize;
+        cache.coloursNum = leftover / CACHE_LINE_SZ + 1;
+    }
+}
+
+void* SlabSegmentManager::alloc(size_t neededBytes)
+{
+    void* retAddr = nullptr;
+    if (neededBytes <= MAX_OBJECT_SZ)
+    {
+        Cache& cache = mCaches[cacheIndexOf(neededBytes)];
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        retAddr = allocObject(cache);
+        if (retAddr != nullptr)
+        {
+            ALLOC_TRACE(Alloc, retAddr, neededBytes);
+        }
+    }
+    if (nullptr == retAddr)
+    {
+        retAddr = mBacking.alloc(neededBytes); // large, or no room for another slab
+    }
+
+    if (retAddr != nullptr)
+    {
+        mAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        mFailedAllocsNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    return retAddr;
+}
+
+void* SlabSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    // Slab objects are aligned to OBJECT_ALIGNMENT only
+    if (alignment <= OBJECT_ALIGNMENT)
+    {
+        return alloc(neededBytes);
+    }
+    void* retAddr = mBacking.alloc(neededBytes, alignment);
+    (retAddr != nullptr ? mAllocsNum : mFailedAllocsNum).fetch_add(1, std::memory_order_relaxed);
+    return retAddr;
+}
+
+void SlabSegmentManager::free(void* addr)
+{
+    Slab* slab = slabOf(addr);
+    if (nullptr == slab)
+    {
+        mBacking.free(addr);
+    }
+    else
+    {
+        // The slab stays as long as the object is in use, so its header can be read unlocked
+        Cache& cache = mCaches[slab->cacheIndex];
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        checkObject(slab, addr);
+        freeObject(cache, slab, addr);
+    }
+    mFreesNum.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SlabSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    Slab* slab = slabOf(addr);
+    if (nullptr == slab)
+    {
+        return mBacking.tryExpand(addr, newBytes);
+    }
+    return newBytes <= mCaches[slab->cacheIndex].objectSize;
+}
+
+void SlabSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    if (nullptr == slabOf(addr))
+    {
+        mBacking.shrink(addr, newBytes);
+    }
+    // A slab object keeps its size
+}
+
+void* SlabSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    if (nullptr == addr)
+    {
+        return alloc(newBytes);
+    }
+    Slab* slab = slabOf(addr);
+    if (nullptr == slab)
+    {
+        return mBacking.realloc(addr, newBytes);
+    }
+
+    size_t oldSize = mCaches[slab->cacheIndex].objectSize;
+    if (newBytes <= oldSize)
+    {
+        return addr;
+    }
+    void* newAddr = alloc(newBytes);
+    if (newAddr != nullptr)
+    {
+        std::memcpy(newAddr, addr, oldSize);
+        free(addr);
+    }
+    return newAddr;
+}
+
+void SlabSegmentManager::releaseEmptySlabs()
+{
+    for (auto& cache : mCaches)
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        while (cache.empty.head != nullptr)
+        {
+            Slab* slab = cache.empty.head;
+            cache.empty.remove(slab);
+            releaseSlab(slab);
+        }
+    }
+}
+
+size_t SlabSegmentManager::getSlabsNum() const
+{
+    size_t slabsNum = 0;
+    for (const auto& cache : mCaches)
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        slabsNum += cache.partial.size + cache.full.size + cache.empty.size;
+    }
+    return slabsNum;
+}
+
+SegmentManagerStats SlabSegmentManager::getStats() const
+{
+    SegmentManagerStats stats = mBacking.getStats();
+    stats.allocsNum = mAllocsNum.load(std::memory_order_relaxed);
+    stats.freesNum = mFreesNum.load(std::memory_order_relaxed);
+    stats.failedAllocsNum = mFailedAllocsNum.load(std::memory_order_relaxed);
+
+    // Slabs are occupied as far as the backing manager is concerned, but their free objects are free to be reused:
+    for (const auto& cache : mCaches)
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (const SlabList* list : {&cache.partial, &cache.empty})
+        {
+            for (const Slab* slab = list->head; slab != nullptr; slab = slab->next)
+            {
+                size_t freeObjectsNum = cache.objectsPerSlab - slab->inUseNum;
+                for (size_t i = 0; i < freeObjectsNum; i++)
+                {
+                    stats.addFreeBlock(cache.objectSize);
+                }
+                stats.occupiedBytes -= freeObjectsNum * cache.objectSize;
+                stats.freeBytes += freeObjectsNum * cache.objectSize;
+            }
+        }
+    }
+    stats.updateFragmentation();
+    return stats;
+}
+
+SlabSegmentManager::Slab* SlabSegmentManager::slabOf(const void* addr) const
+{
+    uintptr_t chunk = reinterpret_cast<uintptr_t>(addr) / SLAB_SZ;
+    if (chunk < mFirstChunk || chunk - mFirstChunk >= mChunksNum || 0 == mSlabMap[chunk - mFirstChunk])
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<Slab*>(chunk * SLAB_SZ);
+}
+
+void SlabSegmentManager::checkObject(const Slab* slab, const void* addr) const
+{
+    const char* object = static_cast<const char*>(addr);
+    size_t objectSize = mCaches[slab->cacheIndex].objectSize;
+    if (object < slab->objects || (object - slab->objects) % objectSize != 0 ||
+        static_cast<size_t>(object - slab->objects) / objectSize >= slab->carvedNum)
+    {
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+}
+
+void* SlabSegmentManager::allocObject(Cache& cache)
+{
+    Slab* slab = cache.partial.head;
+    if (nullptr == slab)
+    {
+        slab = cache.empty.head;
+        if (slab != nullptr)
+        {
+            cache.empty.remove(slab);
+        }
+        else if (nullptr == (slab = createSlab(cache)))
+        {
+            return nullptr;
+        }
+        cache.partial.push(slab);
+    }
+
+    void* object = nullptr;
+    if (slab->freeList != nullptr)
+    {
+        object = slab->freeList; // the most recently freed one, likely still in the CPU cache
+        slab->freeList = slab->freeList->next;
+    }
+    else
+    {
+        object = slab->objects + slab->carvedNum * cache.objectSize;
+        slab->carvedNum++;
+    }
+
+    if (++slab->inUseNum == cache.objectsPerSlab)
+    {
+        cache.partial.remove(slab);
+        cache.full.push(slab);
+    }
+    return object;
+}
+
+void SlabSegmentManager::freeObject(Cache& cache, Slab* slab, void* addr)
+{
+    FreeObject* object = static_cast<FreeObject*>(addr);
+    object->next = slab->freeList;
+    slab->freeList = object;
+    ALLOC_TRACE(Free, addr, 0);
+
+    if (slab->inUseNum-- == cache.objectsPerSlab)
+    {
+        cache.full.remove(slab);
+        cache.partial.push(slab);
+    }
+    if (0 == slab->inUseNum)
+    {
+        cache.partial.remove(slab);
+        if (cache.empty.size < MAX_EMPTY_SLABS)
+        {
+            cache.empty.push(slab);
+        }
+        else
+        {
+            releaseSlab(slab);
+        }
+    }
+}
+
+SlabSegmentManager::Slab* SlabSegmentManager::createSlab(Cache& cache)
+{
+    char* mem = static_cast<char*>(mBacking.alloc(SLAB_USABLE_SZ, SLAB_SZ));
+    if (nullptr == mem)
+    {
+        return nullptr;
+    }
+    mSlabMap[reinterpret_cast<uintptr_t>(mem) / SLAB_SZ - mFirstChunk] = 1;
+
+    size_t colour = cache.nextColour;
+    cache.nextColour = (cache.nextColour + 1) % cache.coloursNum;
+
+    Slab* slab = reinterpret_cast<Slab*>(mem);
+    slab->prev = nullptr;
+    slab->next = nullptr;
+    slab->freeList = nullptr;
+    slab->objects = mem + SLAB_HEADER_SZ + colour * CACHE_LINE_SZ;
+    slab->inUseNum = 0;
+    slab->carvedNum = 0;
+    slab->cacheIndex = static_cast<uint32_t>(&cache - mCaches.data());
+
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "New slab for " << cache.objectSize << "-byte objects at "
+                               << reinterpret_cast<long>(mem) << ", colour " << colour << std::endl;
+    }
+    return slab;
+}
+
+void SlabSegmentManager::releaseSlab(Slab* slab)
+{
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Releasing an empty slab at " << reinterpret_cast<long>((void*)slab) << std::endl;
+    }
+    mSlabMap[reinterpret_cast<uintptr_t>(slab) / SLAB_SZ - mFirstChunk] = 0;
+    mBacking.free(slab);
+}
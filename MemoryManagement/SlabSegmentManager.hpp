@@ -0,0 +1,144 @@
+#pragma once
+
+#include "SimpleSegmentManager.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * This class is a slab allocator for objects allocated over and over again at the same size (list & map
+ * nodes, BicycleImpl instances): every object size (rounded up to OBJECT_ALIGNMENT, up to MAX_OBJECT_SZ)
+ * has its own cache of slabs. A slab is a SLAB_SZ-aligned block of SLAB_SZ bytes, taken from
+ * a @SimpleSegmentManager managing the whole segment, which starts with a header and is packed with
+ * objects of a single size. Objects have no per-object header: a slab map (a byte per SLAB_SZ chunk of
+ * the segment) tells slab objects from the backing manager's blocks, and masking an object's address
+ * gives its slab. Larger and over-aligned requests go straight to the backing manager.
+ *
+ * Every cache keeps its slabs in partial, full & empty lists: objects are taken from partial slabs first,
+ * so the others can become empty. An empty slab is given back to the backing segment as soon as the
+ * cache has MAX_EMPTY_SLABS of them already, so it can be reused by other sizes & large blocks.
+ *
+ * Cache colouring: the space a slab can't fill with whole objects is used to shift its first object
+ * by a multiple of CACHE_LINE_SZ, a different one for every next slab of the cache. Objects at the same
+ * index of different slabs then map to different cache sets instead of evicting each other.
+ *
+ * Each cache has its own lock, so objects of different sizes are allocated without contention.
+ *
+ * NOTE: double frees of slab objects are not detected.
+ */
+class SlabSegmentManager
+{
+public:
+    SlabSegmentManager(char* segment,
+                       size_t size,
+                       bool verboseDebugging = false);
+    ~SlabSegmentManager() = default;
+
+    SlabSegmentManager(const SlabSegmentManager& rhs) = delete;
+    SlabSegmentManager& operator= (const SlabSegmentManager& rhs) = delete;
+    SlabSegmentManager(SlabSegmentManager&& rhs) = delete;
+    SlabSegmentManager& operator= (SlabSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+
+    // A slab object can be resized within its object size only
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    /**
+     * Gives all the empty slabs of all the caches back to the backing segment.
+     */
+    void releaseEmptySlabs();
+
+    /**
+     * Number of slabs taken from the backing segment (partial, full & empty ones).
+     */
+    size_t getSlabsNum() const;
+
+    /**
+     * Statistics of the segment: free objects of the slabs count as free memory. The peak comes from
+     * the backing manager, so it counts whole slabs.
+     */
+    SegmentManagerStats getStats() const;
+
+    static constexpr size_t SLAB_SZ = 16 * 1024; // a power of 2
+    static constexpr size_t MAX_OBJECT_SZ = 1024;
+    static constexpr size_t OBJECT_ALIGNMENT = 16;
+    static constexpr size_t CACHE_LINE_SZ = 64;
+    static constexpr size_t MAX_EMPTY_SLABS = 1; // per cache
+
+private:
+    static constexpr size_t CACHES_NUM = MAX_OBJECT_SZ / OBJECT_ALIGNMENT;
+
+    struct FreeObject
+    {
+        FreeObject* next;
+    };
+
+    // At the start of every slab
+    struct Slab
+    {
+        Slab* prev;
+        Slab* next;
+        FreeObject* freeList; // objects freed back to the slab
+        char* objects; // the first object, after the header & the colour
+        uint32_t inUseNum;
+        uint32_t carvedNum; // objects [0, carvedNum) have been handed out at least once, the rest are untouched
+        uint32_t cacheIndex;
+    };
+
+    struct SlabList
+    {
+        Slab* head = nullptr;
+        size_t size = 0;
+
+        void push(Slab* slab);
+        void remove(Slab* slab);
+    };
+
+    struct Cache
+    {
+        mutable std::mutex mutex;
+        size_t objectSize = 0;
+        uint32_t objectsPerSlab = 0;
+        size_t coloursNum = 0;
+        size_t nextColour = 0;
+        SlabList partial;
+        SlabList full;
+        SlabList empty;
+    };
+
+    static size_t cacheIndexOf(size_t bytes)
+    {
+        return bytes == 0 ? 0 : (bytes - 1) / OBJECT_ALIGNMENT;
+    }
+
+    // The slab @addr lies in, or nullptr if it's not a slab object
+    Slab* slabOf(const void* addr) const;
+    // Checks that @addr is an object of @slab; throws if it's not one we handed out
+    void checkObject(const Slab* slab, const void* addr) const;
+
+    void* allocObject(Cache& cache);
+    void freeObject(Cache& cache, Slab* slab, void* addr);
+    Slab* createSlab(Cache& cache);
+    void releaseSlab(Slab* slab);
+
+    uintptr_t mFirstChunk; // index of the segment's first SLAB_SZ chunk in the address space
+    size_t mChunksNum;
+
+    bool mVerboseDebug;
+
+    SimpleSegmentManager mBacking;
+    uint8_t* mSlabMap; // a byte per chunk: 1 if it's a slab; taken from the backing segment
+    std::array<Cache, CACHES_NUM> mCaches;
+    // Of the user's calls (the backing manager also counts slabs):
+    std::atomic<uint64_t> mAllocsNum;
+    std::atomic<uint64_t> mFreesNum;
+    std::atomic<uint64_t> mFailedAllocsNum;
+};
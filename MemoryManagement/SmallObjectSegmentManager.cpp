@@ -0,0 +1,260 @@
+#include "SmallObjectSegmentManager.hpp"
+#include "AllocTracer.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const char* V_LOG_TAG = "__SOSM__ "; // tag for verbose debugging
+
+    // Where the small-object region of the segment ends
+    size_t smallRegionSize(size_t size, double smallRegionShare)
+    {
+        if (smallRegionShare < 0.0 || smallRegionShare >= 1.0)
+        {
+            throw std::invalid_argument("Small-object region share must be within [0, 1)");
+        }
+        size_t bytes = static_cast<size_t>(size * smallRegionShare);
+        return bytes - bytes % SmallObjectSegmentManager::SIZE_CLASS_STEP;
+    }
+}
+
+const double SmallObjectSegmentManager::DEFAULT_SMALL_REGION_SHARE = 0.5;
+
+SmallObjectSegmentManager::SmallObjectSegmentManager(char* segment, size_t size,
+                                                     bool verboseDebugging, double smallRegionShare) :
+    mRunClasses(reinterpret_cast<uint8_t*>(segment)),
+    mRuns(nullptr),
+    mRunsNum(0),
+    mAssignedRunsNum(0),
+    mVerboseDebug(verboseDebugging),
+    mMutex(),
+    mFreeLists{},
+    mSmallOccupBytes(0),
+    mSmallPeakOccupBytes(0),
+    mSmallAllocsNum(0),
+    mSmallFreesNum(0),
+    mLargeManager(segment + smallRegionSize(size, smallRegionShare),
+                  size - smallRegionSize(size, smallRegionShare), verboseDebugging)
+{
+    // The run table takes a byte per run, followed by the runs aligned to the size class step:
+    size_t regionSize = smallRegionSize(size, smallRegionShare);
+    size_t misalignment = reinterpret_cast<uintptr_t>(segment) % SIZE_CLASS_STEP;
+    size_t skip = misalignment != 0 ? SIZE_CLASS_STEP - misalignment : 0;
+    if (regionSize > skip)
+    {
+        mRunsNum = (regionSize - skip) / (RUN_SZ + 1);
+        size_t tableSize = (mRunsNum + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP * SIZE_CLASS_STEP;
+        mRuns = segment + skip + tableSize;
+        mRunClasses = reinterpret_cast<uint8_t*>(segment + skip);
+        std::memset(mRunClasses, UNASSIGNED_RUN, mRunsNum);
+    }
+
+    if (mVerboseDebug)
+    {
+        std::cout << V_LOG_TAG << "Small-object region: " << mRunsNum << " runs of " << RUN_SZ << " bytes, "
+                               << "large-object region: " << size - regionSize << " bytes" << std::endl;
+    }
+}
+
+void* SmallObjectSegmentManager::alloc(size_t neededBytes)
+{
+    if (neededBytes <= MAX_SMALL_SZ)
+    {
+        void* retAddr = allocSmall(sizeClassOf(neededBytes));
+        if (retAddr != nullptr)
+        {
+            ALLOC_TRACE(Alloc, retAddr, neededBytes);
+            return retAddr;
+        }
+    }
+    return mLargeManager.alloc(neededBytes);
+}
+
+void* SmallObjectSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    // Small blocks are aligned to the size class step only (a block is at a multiple of its size within a run)
+    if (alignment <= SIZE_CLASS_STEP)
+    {
+        return alloc(neededBytes);
+    }
+    return mLargeManager.alloc(neededBytes, alignment);
+}
+
+void SmallObjectSegmentManager::free(void* addr)
+{
+    if (!isSmall(addr))
+    {
+        mLargeManager.free(addr);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    freeSmall(addr, blockSizeClass(addr));
+}
+
+void SmallObjectSegmentManager::free(void* addr, size_t size)
+{
+    if (!isSmall(addr))
+    {
+        mLargeManager.free(addr); // the header knows the size anyway
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t sizeClass = blockSizeClass(addr);
+    if (size > classSize(sizeClass))
+    {
+        throw std::invalid_argument("Freed size exceeds the block's size");
+    }
+    freeSmall(addr, sizeClass);
+}
+
+bool SmallObjectSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    if (!isSmall(addr))
+    {
+        return mLargeManager.tryExpand(addr, newBytes);
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    return newBytes <= classSize(blockSizeClass(addr));
+}
+
+void SmallObjectSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    if (!isSmall(addr))
+    {
+        mLargeManager.shrink(addr, newBytes);
+    }
+    // A small block keeps its size class
+}
+
+void* SmallObjectSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    if (nullptr == addr)
+    {
+        return alloc(newBytes);
+    }
+    if (!isSmall(addr))
+    {
+        return mLargeManager.realloc(addr, newBytes);
+    }
+
+    size_t oldSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        oldSize = classSize(blockSizeClass(addr));
+    }
+    if (newBytes <= oldSize)
+    {
+        return addr;
+    }
+    void* newAddr = alloc(newBytes);
+    if (newAddr != nullptr)
+    {
+        std::memcpy(newAddr, addr, oldSize);
+        free(addr);
+    }
+    return newAddr;
+}
+
+SegmentManagerStats SmallObjectSegmentManager::getStats() const
+{
+    SegmentManagerStats stats = mLargeManager.getStats();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t regionSize = mRuns + mRunsNum * RUN_SZ - reinterpret_cast<char*>(mRunClasses);
+    size_t unassignedBytes = (mRunsNum - mAssignedRunsNum) * RUN_SZ;
+    stats.segmentBytes += regionSize;
+    stats.committedBytes += regionSize;
+    stats.residentBytes += regionSize;
+    stats.occupiedBytes += regionSize - unassignedBytes; // the run table & all the assigned runs
+    stats.peakOccupiedBytes += mSmallPeakOccupBytes;
+    stats.allocsNum += mSmallAllocsNum;
+    stats.freesNum += mSmallFreesNum;
+
+    // Free blocks of the assigned runs are occupied as far as the large-object region is concerned,
+    // but they are free to be reused:
+    for (size_t sizeClass = 0; sizeClass < SIZE_CLASSES_NUM; sizeClass++)
+    {
+        for (FreeBlock* block = mFreeLists[sizeClass]; block != nullptr; block = block->next)
+        {
+            stats.addFreeBlock(classSize(sizeClass));
+        }
+    }
+    size_t smallFreeBytes = (mAssignedRunsNum * RUN_SZ) - mSmallOccupBytes;
+    stats.occupiedBytes -= smallFreeBytes;
+    stats.freeBytes += smallFreeBytes + unassignedBytes;
+    if (unassignedBytes != 0)
+    {
+        stats.addFreeBlock(unassignedBytes);
+    }
+    stats.updateFragmentation();
+    return stats;
+}
+
+void* SmallObjectSegmentManager::allocSmall(size_t sizeClass)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (nullptr == mFreeLists[sizeClass] && !assignRun(sizeClass))
+    {
+        return nullptr;
+    }
+
+    FreeBlock* block = mFreeLists[sizeClass];
+    mFreeLists[sizeClass] = block->next;
+    mSmallOccupBytes += classSize(sizeClass);
+    if (mSmallOccupBytes > mSmallPeakOccupBytes)
+    {
+        mSmallPeakOccupBytes = mSmallOccupBytes;
+    }
+    mSmallAllocsNum++;
+    return block;
+}
+
+void SmallObjectSegmentManager::freeSmall(void* addr, size_t sizeClass)
+{
+    FreeBlock* block = static_cast<FreeBlock*>(addr);
+    block->next = mFreeLists[sizeClass];
+    mFreeLists[sizeClass] = block;
+    mSmallOccupBytes -= classSize(sizeClass);
+    mSmallFreesNum++;
+    ALLOC_TRACE(Free, addr, 0);
+}
+
+size_t SmallObjectSegmentManager::blockSizeClass(void* addr) const
+{
+    size_t offset = static_cast<char*>(addr) - mRuns;
+    uint8_t sizeClass = mRunClasses[offset / RUN_SZ];
+    if (UNASSIGNED_RUN == sizeClass || (offset % RUN_SZ) % classSize(sizeClass) != 0 ||
+        offset % RUN_SZ + classSize(sizeClass) > RUN_SZ)
+    {
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+    return sizeClass;
+}
+
+bool SmallObjectSegmentManager::assignRun(size_t sizeClass)
+{
+    if (mAssignedRunsNum == mRunsNum)
+    {
+        return false;
+    }
+
+    mRunClasses[mAssignedRunsNum] = static_cast<uint8_t>(sizeClass);
+    char* run = mRuns + mAssignedRunsNum * RUN_SZ;
+    mAssignedRunsNum++;
+
+    // Carve the run into blocks, the first one being the top of the free list:
+    const size_t blockSize = classSize(sizeClass);
+    const size_t blocksNum = RUN_SZ / blockSize;
+    for (size_t i = blocksNum; i > 0; i--)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(run + (i - 1) * blockSize);
+        block->next = mFreeLists[sizeClass];
+        mFreeLists[sizeClass] = block;
+    }
+    // The tail of the run smaller than a block is lost, so count it as occupied for good:
+    mSmallOccupBytes += RUN_SZ - blocksNum * blockSize;
+    return true;
+}
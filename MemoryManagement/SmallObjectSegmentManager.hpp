@@ -0,0 +1,111 @@
+#pragma once
+
+#include "SimpleSegmentManager.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * This class serves small blocks without any per-block header, which matters for node-based containers:
+ * a 32-byte node from @SimpleSegmentManager costs 48 bytes.
+ *
+ * The front part of the segment (@smallRegionShare of it) is the small-object region. It's divided into
+ * runs of RUN_SZ bytes, and each run serves blocks of a single size class (multiples of 16 bytes, up to
+ * MAX_SMALL_SZ). Each run's size class is kept in a table of one byte per run. Any address within
+ * the region gives its run, and that gives the block's size. So free() works without a size as well,
+ * and free(addr, size) only checks the size against the run's class. Free blocks of a size class are
+ * linked through their first bytes.
+ *
+ * The rest of the segment is managed by a @SimpleSegmentManager, which serves larger and over-aligned
+ * requests, and small ones too once the small-object region is exhausted.
+ *
+ * NOTE: double frees of small blocks are not detected; runs are never given back to the region.
+ */
+class SmallObjectSegmentManager
+{
+public:
+    SmallObjectSegmentManager(char* segment,
+                              size_t size,
+                              bool verboseDebugging = false,
+                              double smallRegionShare = DEFAULT_SMALL_REGION_SHARE);
+    ~SmallObjectSegmentManager() = default;
+
+    SmallObjectSegmentManager(const SmallObjectSegmentManager& rhs) = delete;
+    SmallObjectSegmentManager& operator= (const SmallObjectSegmentManager& rhs) = delete;
+    SmallObjectSegmentManager(SmallObjectSegmentManager&& rhs) = delete;
+    SmallObjectSegmentManager& operator= (SmallObjectSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+    /**
+     * Sized free: @size is the number of bytes requested at allocation (or any smaller number that
+     * resizing left the block with). Throws std::invalid_argument if the block is smaller than @size.
+     */
+    void free(void* addr, size_t size);
+
+    // A small block can be resized within its size class only
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    /**
+     * Statistics of both regions together. The peak is the sum of the regions' peaks, so it might
+     * exceed the actual peak.
+     */
+    SegmentManagerStats getStats() const;
+
+    static constexpr size_t SIZE_CLASS_STEP = 16;
+    static constexpr size_t MAX_SMALL_SZ = 256;
+    static constexpr size_t RUN_SZ = 4096;
+    static const double DEFAULT_SMALL_REGION_SHARE;
+
+private:
+    static constexpr size_t SIZE_CLASSES_NUM = MAX_SMALL_SZ / SIZE_CLASS_STEP;
+    static constexpr uint8_t UNASSIGNED_RUN = 0xFF;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    static size_t sizeClassOf(size_t bytes)
+    {
+        return bytes == 0 ? 0 : (bytes - 1) / SIZE_CLASS_STEP;
+    }
+
+    static size_t classSize(size_t sizeClass)
+    {
+        return (sizeClass + 1) * SIZE_CLASS_STEP;
+    }
+
+    bool isSmall(const void* addr) const
+    {
+        return addr >= mRuns && addr < mRuns + mRunsNum * RUN_SZ;
+    }
+
+    void* allocSmall(size_t sizeClass);
+    void freeSmall(void* addr, size_t sizeClass);
+    // Size class of the small block at @addr; throws if it's not a block we handed out
+    size_t blockSizeClass(void* addr) const;
+    bool assignRun(size_t sizeClass);
+
+    uint8_t* mRunClasses; // the run table, at the region's start
+    char* mRuns;
+    size_t mRunsNum;
+    size_t mAssignedRunsNum; // runs are taken from the region's start, in order
+
+    bool mVerboseDebug;
+
+    mutable std::mutex mMutex; // guards the small-object region
+    std::array<FreeBlock*, SIZE_CLASSES_NUM> mFreeLists;
+    // Statistics data:
+    size_t mSmallOccupBytes;
+    size_t mSmallPeakOccupBytes;
+    uint64_t mSmallAllocsNum;
+    uint64_t mSmallFreesNum;
+
+    SimpleSegmentManager mLargeManager;
+};
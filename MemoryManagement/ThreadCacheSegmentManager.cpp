@@ -0,0 +1,262 @@
+#include "ThreadCacheSegmentManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    size_t getThreadSlot(size_t slotsNum)
+    {
+        static std::atomic<size_t> sNextSlot(0);
+        thread_local size_t tSlot = sNextSlot.fetch_add(1, std::memory_order_relaxed);
+        return tSlot % slotsNum;
+    }
+}
+
+const size_t ThreadCacheSegmentManager::MAX_CACHED_SZ =
+        SIZE_CLASSES_NUM * SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ;
+
+void ThreadCacheSegmentManager::ThreadCache::lock()
+{
+    // Uncontended unless several threads share the slot
+    while (busy.test_and_set(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void ThreadCacheSegmentManager::ThreadCache::unlock()
+{
+    busy.clear(std::memory_order_release);
+}
+
+ThreadCacheSegmentManager::ThreadCacheSegmentManager(char* segment,
+                                                     size_t size, bool verboseDebugging) :
+    mSharedManager(segment, size, verboseDebugging)
+{
+    for (auto& cache : mCaches)
+    {
+        cache.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ThreadCacheSegmentManager::~ThreadCacheSegmentManager()
+{
+    // Cached blocks belong to the segment, which we don't own, so there's nothing to free there
+    for (auto& cache : mCaches)
+    {
+        delete cache.load(std::memory_order_acquire);
+    }
+}
+
+ThreadCacheSegmentManager::ThreadCache& ThreadCacheSegmentManager::getThreadCache()
+{
+    std::atomic<ThreadCache*>& slot = mCaches[getThreadSlot(CACHE_SLOTS_NUM)];
+    ThreadCache* cache = slot.load(std::memory_order_acquire);
+    if (nullptr == cache)
+    {
+        ThreadCache* newCache = new ThreadCache();
+        if (slot.compare_exchange_strong(cache, newCache, std::memory_order_acq_rel))
+        {
+            cache = newCache;
+        }
+        else
+        {
+            delete newCache; // another thread mapped onto this slot was faster
+        }
+    }
+    return *cache;
+}
+
+void ThreadCacheSegmentManager::refill(Magazine& mag, size_t sizeClass)
+{
+    size_t classBytes = (sizeClass + 1) * SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ;
+
+    std::lock_guard<std::mutex> lock(mSharedManager.mMutex);
+    if (mag.count < BATCH_SZ)
+    {
+        mag.count += mSharedManager.allocBatchUnlocked(BATCH_SZ - mag.count, classBytes, mag.blocks + mag.count);
+    }
+}
+
+void ThreadCacheSegmentManager::flush(Magazine& mag, size_t blocksNum)
+{
+    if (blocksNum > mag.count)
+    {
+        blocksNum = mag.count;
+    }
+    if (0 == blocksNum)
+    {
+        return;
+    }
+
+    AllocError error = AllocError::None;
+    size_t freedNum = 0;
+    {
+        // The oldest blocks are at the bottom of the magazine; the hot ones stay cached
+        std::lock_guard<std::mutex> lock(mSharedManager.mMutex);
+        freedNum = mSharedManager.tryFreeBatchUnlocked(mag.blocks, blocksNum, error);
+    }
+
+    // A block the shared manager refused (e.g. freed twice) must not be handed out either: drop it too
+    size_t droppedNum = AllocError::None == error ? freedNum : freedNum + 1;
+    mag.count -= droppedNum;
+    std::memmove(mag.blocks, mag.blocks + droppedNum, mag.count * sizeof(void*));
+    if (error != AllocError::None)
+    {
+        SimpleSegmentManager::throwFreeError(error);
+    }
+}
+
+void ThreadCacheSegmentManager::flushAll()
+{
+    for (auto& slot : mCaches)
+    {
+        ThreadCache* cache = slot.load(std::memory_order_acquire);
+        if (nullptr == cache)
+        {
+            continue;
+        }
+        std::lock_guard<ThreadCache> lock(*cache);
+        for (auto& mag : cache->magazines)
+        {
+            flush(mag, mag.count);
+        }
+    }
+}
+
+void ThreadCacheSegmentManager::countAlloc(const void* retAddr)
+{
+    ThreadCache& cache = getThreadCache();
+    (retAddr != nullptr ? cache.allocsNum : cache.failedAllocsNum).fetch_add(1, std::memory_order_relaxed);
+}
+
+SegmentManagerStats ThreadCacheSegmentManager::getStats() const
+{
+    SegmentManagerStats stats = mSharedManager.getStats();
+    stats.allocsNum = 0;
+    stats.freesNum = 0;
+    stats.failedAllocsNum = 0;
+    for (const auto& slot : mCaches)
+    {
+        const ThreadCache* cache = slot.load(std::memory_order_acquire);
+        if (cache != nullptr)
+        {
+            stats.allocsNum += cache->allocsNum.load(std::memory_order_relaxed);
+            stats.freesNum += cache->freesNum.load(std::memory_order_relaxed);
+            stats.failedAllocsNum += cache->failedAllocsNum.load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
+
+void* ThreadCacheSegmentManager::alloc(size_t neededBytes)
+{
+    void* retAddr = nullptr;
+    if (neededBytes <= MAX_CACHED_SZ)
+    {
+        size_t units = (neededBytes + SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ - 1) /
+                       SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ;
+        size_t sizeClass = units > 0 ? units - 1 : 0;
+
+        ThreadCache& cache = getThreadCache();
+        std::lock_guard<ThreadCache> lock(cache);
+        Magazine& mag = cache.magazines[sizeClass];
+        if (0 == mag.count)
+        {
+            refill(mag, sizeClass);
+        }
+        if (mag.count > 0)
+        {
+            retAddr = mag.blocks[--mag.count];
+        }
+    }
+    else
+    {
+        retAddr = mSharedManager.alloc(neededBytes);
+    }
+
+    if (nullptr == retAddr)
+    {
+        // The memory we need might be sitting in magazines, possibly fragmented: give it all back
+        flushAll();
+        retAddr = mSharedManager.alloc(neededBytes);
+    }
+    countAlloc(retAddr);
+    return retAddr;
+}
+
+void* ThreadCacheSegmentManager::alloc(size_t neededBytes, size_t alignment)
+{
+    if (alignment <= SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ)
+    {
+        return alloc(neededBytes);
+    }
+
+    // Over-aligned blocks are rare: don't cache them, but they are freed as any other block
+    void* retAddr = mSharedManager.alloc(neededBytes, alignment);
+    if (nullptr == retAddr)
+    {
+        flushAll();
+        retAddr = mSharedManager.alloc(neededBytes, alignment);
+    }
+    countAlloc(retAddr);
+    return retAddr;
+}
+
+void ThreadCacheSegmentManager::free(void* addr)
+{
+    if (nullptr == addr)
+    {
+        throw std::invalid_argument("Cannot free a null pointer");
+    }
+
+    // Ensure the block belongs to us before reading its CB:
+    const char* startAddress = mSharedManager.mSegment + sizeof(SimpleSegmentManager::MemControlBlock);
+    const char* endAddress = mSharedManager.mSegment + mSharedManager.mSegmentSize;
+    if ((const char*)addr <= startAddress || (const char*)addr >= endAddress)
+    {
+        throw std::runtime_error("Invalid ptr: we did not allocate this memory");
+    }
+
+    ThreadCache& cache = getThreadCache();
+    size_t units = SimpleSegmentManager::usableSize(addr) / SimpleSegmentManager::MIN_USABLE_FRAGMENT_SZ;
+    if (0 == units || units > SIZE_CLASSES_NUM)
+    {
+        mSharedManager.free(addr);
+        cache.freesNum.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::lock_guard<ThreadCache> lock(cache);
+    Magazine& mag = cache.magazines[units - 1];
+    // The block's CB can't be marked as cached: if the block is free already, the CB is a free list's one
+    if (std::find(mag.blocks, mag.blocks + mag.count, addr) != mag.blocks + mag.count)
+    {
+        throw std::runtime_error("Memory block is already freed");
+    }
+    if (MAGAZINE_CAPACITY == mag.count)
+    {
+        flush(mag, BATCH_SZ);
+    }
+    mag.blocks[mag.count++] = addr;
+    cache.freesNum.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ThreadCacheSegmentManager::tryExpand(void* addr, size_t newBytes)
+{
+    return mSharedManager.tryExpand(addr, newBytes);
+}
+
+void ThreadCacheSegmentManager::shrink(void* addr, size_t newBytes)
+{
+    mSharedManager.shrink(addr, newBytes);
+}
+
+void* ThreadCacheSegmentManager::realloc(void* addr, size_t newBytes)
+{
+    return mSharedManager.realloc(addr, newBytes);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "SimpleSegmentManager.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * This class puts per-thread caches of recently freed blocks in front of @SimpleSegmentManager,
+ * so that small allocations don't contend on the shared manager's mutex.
+ *
+ * Small requests (up to MAX_CACHED_SZ bytes) are grouped into size classes, one class per mem unit of
+ * @SimpleSegmentManager. Every thread has its own "magazine" (a small stack of free blocks) per size
+ * class. alloc() pops a block from the calling thread's magazine and free() pushes it back; an empty
+ * magazine is refilled from the shared manager and an overflowing one hands its oldest blocks back,
+ * BATCH_SZ blocks at a time under a single lock acquisition.
+ *
+ * Remote frees (a block freed by a thread other than the one that allocated it) go to the freeing
+ * thread's magazine: all the blocks come from the same segment, so any thread may reuse them. Since
+ * magazines are bounded, a producer/consumer pair of threads doesn't make a magazine grow forever:
+ * the consumer's surplus flows back to the shared manager, where the producer picks it up.
+ *
+ * Threads are mapped onto CACHE_SLOTS_NUM cache slots. A slot is created on first use and lives as
+ * long as the segment manager does, so the blocks cached by an exited thread are not lost. When the
+ * shared manager runs out of memory, all the magazines are flushed and the allocation is retried.
+ *
+ * A block freed again while it's still in the freeing thread's magazine is detected right away. A block
+ * freed again after it went back to the shared manager (or by another thread) is cached anew, and only
+ * caught, and dropped, when its magazine is flushed: until then it may be handed out twice.
+ */
+class ThreadCacheSegmentManager
+{
+public:
+    ThreadCacheSegmentManager(char* segment,
+                              size_t size,
+                              bool verboseDebugging = false);
+    ~ThreadCacheSegmentManager();
+
+    ThreadCacheSegmentManager(const ThreadCacheSegmentManager& rhs) = delete;
+    ThreadCacheSegmentManager& operator= (const ThreadCacheSegmentManager& rhs) = delete;
+    ThreadCacheSegmentManager(ThreadCacheSegmentManager&& rhs) = delete;
+    ThreadCacheSegmentManager& operator= (ThreadCacheSegmentManager&& rhs) = delete;
+
+    void* alloc(size_t neededBytes);
+    void* alloc(size_t neededBytes, size_t alignment);
+    void free(void* addr);
+
+    // Resizing goes straight to the shared manager; a resized small block then falls into another size class
+    bool tryExpand(void* addr, size_t newBytes);
+    void shrink(void* addr, size_t newBytes);
+    void* realloc(void* addr, size_t newBytes);
+
+    /**
+     * Returns all the cached blocks of all the threads to the shared manager.
+     */
+    void flushAll();
+
+    /**
+     * Statistics of the shared manager, with alloc/free counts of this manager's users. Blocks sitting
+     * in the thread caches are counted as occupied.
+     */
+    SegmentManagerStats getStats() const;
+
+    static const size_t MAX_CACHED_SZ; // bytes
+
+private:
+    static constexpr size_t SIZE_CLASSES_NUM = 16;
+    static constexpr size_t MAGAZINE_CAPACITY = 32;
+    static constexpr size_t BATCH_SZ = MAGAZINE_CAPACITY / 2;
+    static constexpr size_t CACHE_SLOTS_NUM = 64;
+
+    struct Magazine
+    {
+        size_t count = 0;
+        void* blocks[MAGAZINE_CAPACITY];
+    };
+
+    struct ThreadCache
+    {
+        std::atomic_flag busy = ATOMIC_FLAG_INIT;
+        Magazine magazines[SIZE_CLASSES_NUM];
+
+        // Statistics, relaxed & practically uncontended:
+        std::atomic<uint64_t> allocsNum{0};
+        std::atomic<uint64_t> freesNum{0};
+        std::atomic<uint64_t> failedAllocsNum{0};
+
+        // Used with std::lock_guard
+        void lock();
+        void unlock();
+    };
+
+    ThreadCache& getThreadCache();
+    void countAlloc(const void* retAddr);
+    void refill(Magazine& mag, size_t sizeClass);
+    void flush(Magazine& mag, size_t blocksNum);
+
+    SimpleSegmentManager mSharedManager;
+    std::atomic<ThreadCache*> mCaches[CACHE_SLOTS_NUM];
+};
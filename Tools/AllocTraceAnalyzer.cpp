@@ -0,0 +1,218 @@
+// Offline analyzer of the binary traces written by mybicycles::AllocTracer::dump().
+//
+// Usage: AllocTraceAnalyzer <trace file> [fragmentation samples] [slack bytes]
+//
+// Reports allocation sizes, block lifetimes, blocks never freed and the fragmentation of the traced
+// segments over time. Blocks are taken as [address, address + requested size), so free gaps not bigger
+// than the slack (control blocks and size rounding of the segment manager) are counted as occupied.
+
+#include "MemoryManagement/AllocTracer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using mybicycles::AllocEventType;
+using mybicycles::AllocTraceEvent;
+
+namespace
+{
+    const size_t DEFAULT_SAMPLES = 20;
+    const size_t DEFAULT_SLACK = 32;
+    const size_t HISTOGRAM_BUCKETS = 32;
+
+    struct LiveBlock
+    {
+        uint64_t size;
+        uint64_t allocTimestampNs;
+    };
+
+    size_t log2Bucket(uint64_t value)
+    {
+        size_t bucket = 0;
+        while (value > 1 && bucket < HISTOGRAM_BUCKETS - 1)
+        {
+            value >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    void printHistogram(const char* title, const char* unit, const std::vector<uint64_t>& histogram)
+    {
+        std::cout << title << ":\n";
+        for (size_t i = 0; i < histogram.size(); i++)
+        {
+            if (histogram[i] != 0)
+            {
+                std::cout << "  [" << std::setw(12) << (1ULL << i) << ", " << std::setw(12) << (2ULL << i) << ") "
+                          << unit << ": " << histogram[i] << "\n";
+            }
+        }
+    }
+
+    class FragmentationSampler
+    {
+    public:
+        explicit FragmentationSampler(size_t slack) : mSlack(slack) {}
+
+        void initSegment(uint64_t base, uint64_t size) { mSegments[base] = size; }
+
+        void printHeader() const
+        {
+            std::cout << "Fragmentation over time (1 - largest free gap / free bytes):\n"
+                      << "  " << std::setw(12) << "time, ms" << std::setw(14) << "live bytes"
+                      << std::setw(14) << "free bytes" << std::setw(14) << "largest gap"
+                      << std::setw(10) << "frag" << "\n";
+        }
+
+        void printSample(uint64_t timeNs, const std::map<uint64_t, LiveBlock>& live) const
+        {
+            uint64_t liveBytes = 0;
+            uint64_t freeBytes = 0;
+            uint64_t largestGap = 0;
+            for (const auto& [base, size] : mSegments)
+            {
+                uint64_t end = base + size;
+                uint64_t gapStart = base;
+                for (auto it = live.lower_bound(base); it != live.end() && it->first < end; ++it)
+                {
+                    addGap(it->first > gapStart ? it->first - gapStart : 0, freeBytes, largestGap);
+                    liveBytes += it->second.size;
+                    gapStart = std::max(gapStart, it->first + it->second.size);
+                }
+                addGap(end > gapStart ? end - gapStart : 0, freeBytes, largestGap);
+            }
+            double fragmentation = freeBytes != 0 ? 1.0 - static_cast<double>(largestGap) / freeBytes : 0.0;
+            std::cout << "  " << std::setw(12) << std::fixed << std::setprecision(3) << timeNs / 1e6
+                      << std::setw(14) << liveBytes << std::setw(14) << freeBytes << std::setw(14) << largestGap
+                      << std::setw(10) << std::setprecision(3) << fragmentation << "\n";
+        }
+
+    private:
+        void addGap(uint64_t gap, uint64_t& freeBytes, uint64_t& largestGap) const
+        {
+            if (gap > mSlack)
+            {
+                freeBytes += gap;
+                largestGap = std::max(largestGap, gap);
+            }
+        }
+
+        size_t mSlack;
+        std::map<uint64_t, uint64_t> mSegments; // base -> size
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [fragmentation samples] [slack bytes]" << std::endl;
+        return 1;
+    }
+    size_t samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : DEFAULT_SAMPLES;
+    size_t slack = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : DEFAULT_SLACK;
+
+    std::vector<AllocTraceEvent> events;
+    try
+    {
+        events = mybicycles::AllocTracer::load(argv[1]);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (events.empty())
+    {
+        std::cout << "The trace is empty" << std::endl;
+        return 0;
+    }
+
+    uint64_t startNs = events.front().timestampNs;
+    uint64_t counts[5] = {};
+    uint32_t threadsNum = 0;
+    std::vector<uint64_t> sizes(HISTOGRAM_BUCKETS);
+    std::vector<uint64_t> failedSizes(HISTOGRAM_BUCKETS);
+    std::vector<uint64_t> lifetimes(HISTOGRAM_BUCKETS);
+    uint64_t unmatchedFrees = 0;
+    std::map<uint64_t, LiveBlock> live; // ordered by address for the gap scan
+
+    FragmentationSampler sampler(slack);
+    sampler.printHeader();
+    size_t sampleStep = std::max<size_t>(1, events.size() / std::max<size_t>(1, samples));
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const AllocTraceEvent& event = events[i];
+        threadsNum = std::max(threadsNum, event.threadId + 1);
+        counts[std::min<size_t>(static_cast<size_t>(event.type), std::size(counts) - 1)]++;
+        switch (event.type)
+        {
+        case AllocEventType::SegmentInit:
+            sampler.initSegment(event.address, event.size);
+            break;
+        case AllocEventType::Alloc:
+            sizes[log2Bucket(event.size)]++;
+            live[event.address] = LiveBlock{event.size, event.timestampNs};
+            break;
+        case AllocEventType::Free:
+        {
+            auto it = live.find(event.address);
+            if (it == live.end())
+            {
+                unmatchedFrees++; // allocated before the trace's window
+                break;
+            }
+            lifetimes[log2Bucket(event.timestampNs - it->second.allocTimestampNs)]++;
+            live.erase(it);
+            break;
+        }
+        case AllocEventType::Failure:
+            failedSizes[log2Bucket(event.size)]++;
+            break;
+        case AllocEventType::Resize:
+        {
+            auto it = live.find(event.address);
+            if (it != live.end()) // otherwise allocated before the trace's window
+            {
+                it->second.size = event.size;
+            }
+            break;
+        }
+        }
+
+        if ((i + 1) % sampleStep == 0 || i + 1 == events.size())
+        {
+            sampler.printSample(event.timestampNs - startNs, live);
+        }
+    }
+
+    uint64_t leakedBytes = 0;
+    for (const auto& block : live)
+    {
+        leakedBytes += block.second.size;
+    }
+
+    std::cout << "\nEvents: " << events.size() << " over "
+              << (events.back().timestampNs - startNs) / 1e6 << " ms from " << threadsNum << " thread(s)\n"
+              << "  segments: " << counts[static_cast<size_t>(AllocEventType::SegmentInit)]
+              << ", allocs: " << counts[static_cast<size_t>(AllocEventType::Alloc)]
+              << ", frees: " << counts[static_cast<size_t>(AllocEventType::Free)]
+              << ", failures: " << counts[static_cast<size_t>(AllocEventType::Failure)]
+              << ", in-place resizes: " << counts[static_cast<size_t>(AllocEventType::Resize)]
+              << ", frees of untraced blocks: " << unmatchedFrees << "\n"
+              << "Blocks never freed: " << live.size() << " (" << leakedBytes << " bytes)\n\n";
+    printHistogram("Allocation sizes", "bytes", sizes);
+    printHistogram("Failed allocation sizes", "bytes", failedSizes);
+    printHistogram("Block lifetimes", "ns", lifetimes);
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/AllocTracer.hpp"
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorRecording.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <list>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const char* TRACE_PATH = "tst_AllocTracer.trace";
+}
+
+TEST(BicyclesAllocTracerTestSuite, DumpAndLoad_MultipleThreads)
+{
+    const size_t THREADS_NUM = 4;
+    const size_t EVENTS_PER_THREAD = 1000;
+    const uint64_t TAG = 0xB1C0000000000000ULL; // keeps our events apart from the traced segment managers'
+    AllocTracer& tracer = AllocTracer::instance();
+    tracer.clear();
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS_NUM; t++)
+    {
+        threads.emplace_back([&tracer, t, TAG]() {
+            for (size_t i = 0; i < EVENTS_PER_THREAD; i++)
+            {
+                tracer.record(AllocEventType::Alloc, reinterpret_cast<void*>(TAG | (t << 32) | i), i + 1);
+                tracer.record(AllocEventType::Free, reinterpret_cast<void*>(TAG | (t << 32) | i), 0);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+
+    EXPECT_TRUE(std::is_sorted(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.timestampNs < rhs.timestampNs;
+    }));
+    events.erase(std::remove_if(events.begin(), events.end(), [TAG](const auto& e) {
+        return (e.address & TAG) != TAG;
+    }), events.end());
+    ASSERT_EQ(events.size(), 2 * THREADS_NUM * EVENTS_PER_THREAD);
+
+    // Every thread got its own id and its events are in program order:
+    std::vector<std::vector<AllocTraceEvent>> byThread(THREADS_NUM);
+    for (const auto& e : events)
+    {
+        byThread[(e.address >> 32) & 0xFFFF].push_back(e);
+    }
+    for (const auto& threadEvents : byThread)
+    {
+        ASSERT_EQ(threadEvents.size(), 2 * EVENTS_PER_THREAD);
+        for (size_t i = 0; i < EVENTS_PER_THREAD; i++)
+        {
+            EXPECT_EQ(threadEvents[2 * i].type, AllocEventType::Alloc);
+            EXPECT_EQ(threadEvents[2 * i].size, i + 1);
+            EXPECT_EQ(threadEvents[2 * i + 1].type, AllocEventType::Free);
+            EXPECT_EQ(threadEvents[2 * i + 1].address, threadEvents[2 * i].address);
+            EXPECT_EQ(threadEvents[2 * i].threadId, threadEvents.front().threadId);
+        }
+    }
+    EXPECT_NE(byThread[0].front().threadId, byThread[1].front().threadId);
+}
+
+TEST(BicyclesAllocTracerTestSuite, RingBufferKeepsLatestEvents)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    std::thread([&tracer]() {
+        tracer.clear();
+        for (size_t i = 0; i < AllocTracer::THREAD_BUFFER_EVENTS + 10; i++)
+        {
+            tracer.record(AllocEventType::Failure, nullptr, i);
+        }
+        ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    }).join();
+
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), AllocTracer::THREAD_BUFFER_EVENTS);
+    EXPECT_EQ(events.front().size, 10u); // the first 10 got overwritten
+    EXPECT_EQ(events.back().size, AllocTracer::THREAD_BUFFER_EVENTS + 9);
+}
+
+TEST(BicyclesAllocTracerTestSuite, KeepAllEvents)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    tracer.setKeepAllEvents(true);
+    std::thread([&tracer]() {
+        tracer.clear();
+        for (size_t i = 0; i < 2 * AllocTracer::THREAD_BUFFER_EVENTS + 10; i++)
+        {
+            tracer.record(AllocEventType::Failure, nullptr, i);
+        }
+        ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    }).join();
+    tracer.setKeepAllEvents(false);
+
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), 2 * AllocTracer::THREAD_BUFFER_EVENTS + 10);
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        ASSERT_EQ(events[i].size, i);
+    }
+}
+
+TEST(BicyclesAllocTracerTestSuite, RecordingAllocator)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    std::vector<AllocTraceEvent> events;
+    std::thread([&tracer, &events]() {
+        tracer.clear();
+        {
+            SharedPtr<DummySegmentManager> manager = makeShared<DummySegmentManager>(nullptr, 0, false);
+            std::list<int, MyAllocatorRecording<int, DummySegmentManager>> ints(manager);
+            for (int i = 0; i < 10; i++)
+            {
+                ints.push_back(i);
+            }
+            ints.pop_front();
+        }
+        ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    }).join();
+
+    events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), 20u);
+    EXPECT_EQ(events[0].type, AllocEventType::Alloc);
+    EXPECT_GE(events[0].size, sizeof(int) + 2 * sizeof(void*)); // a list node
+    EXPECT_EQ(events[10].type, AllocEventType::Free); // pop_front()
+    EXPECT_EQ(events[10].address, events[0].address);
+    for (size_t i = 11; i < events.size(); i++)
+    {
+        EXPECT_EQ(events[i].type, AllocEventType::Free);
+        EXPECT_EQ(events[i].address, events[i - 10].address);
+    }
+}
+
+TEST(BicyclesAllocTracerTestSuite, RecordingAllocatorTryPaths)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    std::vector<AllocTraceEvent> events;
+    std::thread([&tracer]() {
+        tracer.clear();
+        SharedPtr<DummySegmentManager> manager = makeShared<DummySegmentManager>(nullptr, 0, false);
+        MyAllocatorRecording<int, DummySegmentManager> myal(manager);
+        AllocResult<int> result = myal.tryAllocate(4);
+        ASSERT_TRUE(result);
+        EXPECT_FALSE(myal.tryExpand(result.ptr, 4, 8)); // the heap doesn't grow blocks in place
+        myal.shrink(result.ptr, 4, 2);
+        EXPECT_EQ(myal.tryDeallocate(result.ptr, 2), AllocError::None);
+        EXPECT_EQ(myal.tryDeallocate(nullptr, 2), AllocError::NullPointer); // a failed free isn't recorded
+        MyAllocatorRecording<int, DummySegmentManager> unbound;
+        EXPECT_EQ(unbound.tryAllocate(4).error, AllocError::NoSegmentManager);
+        ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    }).join();
+
+    events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0].type, AllocEventType::Alloc);
+    EXPECT_EQ(events[0].size, 4 * sizeof(int));
+    EXPECT_EQ(events[1].type, AllocEventType::Resize);
+    EXPECT_EQ(events[1].address, events[0].address);
+    EXPECT_EQ(events[1].size, 2 * sizeof(int));
+    EXPECT_EQ(events[2].type, AllocEventType::Free);
+    EXPECT_EQ(events[2].address, events[0].address);
+    EXPECT_EQ(events[3].type, AllocEventType::Failure);
+    EXPECT_EQ(events[3].size, 4 * sizeof(int));
+}
+
+TEST(BicyclesAllocTracerTestSuite, LoadRejectsBadFiles)
+{
+    EXPECT_THROW(AllocTracer::load("no_such_file.trace"), std::runtime_error);
+
+    FILE* file = std::fopen(TRACE_PATH, "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not a trace at all, but long enough", file);
+    std::fclose(file);
+    EXPECT_THROW(AllocTracer::load(TRACE_PATH), std::runtime_error);
+
+    // Traces of a future format version:
+    AllocTracer::instance().clear();
+    ASSERT_TRUE(AllocTracer::instance().dump(TRACE_PATH));
+    file = std::fopen(TRACE_PATH, "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, 7, SEEK_SET); // the version character of the magic
+    std::fputc('9', file);
+    std::fclose(file);
+    EXPECT_THROW(AllocTracer::load(TRACE_PATH), std::runtime_error);
+    std::remove(TRACE_PATH);
+}
+
+TEST(BicyclesAllocTracerTestSuite, LoadsVersion1Traces)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    tracer.clear();
+    int block;
+    tracer.record(AllocEventType::Alloc, &block, sizeof(block));
+    ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    tracer.clear();
+
+    FILE* file = std::fopen(TRACE_PATH, "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, 7, SEEK_SET);
+    std::fputc('1', file);
+    std::fclose(file);
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].type, AllocEventType::Alloc);
+}
+
+#ifdef MYBICYCLES_ALLOC_TRACING
+TEST(BicyclesAllocTracerTestSuite, SimpleSegmentManagerEvents)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    tracer.clear();
+
+    alignas(16) char segment[1024];
+    SimpleSegmentManager ssm(segment, sizeof(segment));
+    void* p = ssm.alloc(100);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(ssm.alloc(4096), nullptr);
+    ssm.free(p);
+
+    ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0].type, AllocEventType::SegmentInit);
+    EXPECT_EQ(events[0].address, reinterpret_cast<uintptr_t>(segment));
+    EXPECT_EQ(events[1].type, AllocEventType::Alloc);
+    EXPECT_EQ(events[1].address, reinterpret_cast<uintptr_t>(p));
+    EXPECT_EQ(events[1].size, 100u);
+    EXPECT_EQ(events[2].type, AllocEventType::Failure);
+    EXPECT_EQ(events[2].size, 4096u);
+    EXPECT_EQ(events[3].type, AllocEventType::Free);
+    EXPECT_EQ(events[3].address, reinterpret_cast<uintptr_t>(p));
+}
+
+TEST(BicyclesAllocTracerTestSuite, SimpleSegmentManagerResizeEvents)
+{
+    AllocTracer& tracer = AllocTracer::instance();
+    tracer.clear();
+
+    alignas(16) char segment[4096];
+    SimpleSegmentManager ssm(segment, sizeof(segment));
+    void* p = ssm.alloc(100);
+    ASSERT_TRUE(ssm.tryExpand(p, 1000));
+    ssm.shrink(p, 200);
+    ASSERT_EQ(ssm.realloc(p, 300), p);
+    void* blocker = ssm.alloc(16);
+    void* moved = ssm.realloc(p, 2000);
+    ASSERT_NE(moved, p);
+    ssm.free(moved);
+    ssm.free(blocker);
+
+    ASSERT_TRUE(tracer.dump(TRACE_PATH));
+    std::vector<AllocTraceEvent> events = AllocTracer::load(TRACE_PATH);
+    std::remove(TRACE_PATH);
+    std::vector<AllocEventType> types;
+    for (const auto& event : events)
+    {
+        types.push_back(event.type);
+    }
+    const std::vector<AllocEventType> expected = {
+        AllocEventType::SegmentInit, AllocEventType::Alloc,
+        AllocEventType::Resize, AllocEventType::Resize, AllocEventType::Resize,
+        AllocEventType::Alloc, // the blocker
+        AllocEventType::Alloc, AllocEventType::Free, // the block moved by realloc()
+        AllocEventType::Free, AllocEventType::Free};
+    EXPECT_EQ(types, expected);
+    EXPECT_EQ(events[2].size, 1000u);
+    EXPECT_EQ(events[3].size, 200u);
+    EXPECT_EQ(events[4].size, 300u);
+    EXPECT_EQ(events[7].address, reinterpret_cast<uintptr_t>(p));
+}
+#endif
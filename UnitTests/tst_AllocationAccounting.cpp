@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include "Containers/ExpandableVector.hpp"
+#include "MemoryManagement/AllocationAccounting.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/MyAllocatorOnStack.hpp"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const size_t SEG_SIZE = 1024 * 1024;
+
+    template <typename T>
+    using LabelledAllocator = MyAllocatorNonOwning<T, SimpleSegmentManager, LabelAccounting>;
+
+    AllocationAccountStats statsOf(const std::string& label)
+    {
+        return AllocationAccounts::instance().get(label).getStats();
+    }
+}
+
+TEST(BicyclesAllocationAccountingTestSuite, NoAccountingCostsNothing)
+{
+    static_assert(sizeof(MyAllocatorNonOwning<int>) == sizeof(SharedPtr<SimpleSegmentManager>),
+                  "The default policy must add no state");
+    static_assert(sizeof(LabelledAllocator<int>) == sizeof(SharedPtr<SimpleSegmentManager>) + sizeof(void*), "");
+}
+
+TEST(BicyclesAllocationAccountingTestSuite, PerLabelCounters)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    AllocationAccounts::instance().reset();
+
+    {
+        // Two containers sharing the segment, each accounted for separately (the map's nodes by a rebind):
+        std::vector<int, LabelledAllocator<int>> prices(LabelledAllocator<int>(ssm, "test.prices"));
+        std::map<int, int, std::less<int>, LabelledAllocator<std::pair<const int, int>>> orders(
+                    LabelledAllocator<std::pair<const int, int>>(ssm, "test.orders"));
+        prices.reserve(1000);
+        for (int i = 0; i < 10; i++)
+        {
+            orders.emplace(i, i);
+        }
+
+        AllocationAccountStats priceStats = statsOf("test.prices");
+        EXPECT_EQ(priceStats.liveBytes, 1000 * sizeof(int));
+        EXPECT_EQ(priceStats.allocsNum, 1u);
+        AllocationAccountStats orderStats = statsOf("test.orders");
+        EXPECT_EQ(orderStats.allocsNum, 10u);
+        EXPECT_EQ(orderStats.liveBytes % 10, 0u);
+        EXPECT_GE(orderStats.liveBytes, 10 * sizeof(std::pair<const int, int>));
+
+        prices.reserve(2000);
+        priceStats = statsOf("test.prices");
+        EXPECT_EQ(priceStats.liveBytes, 2000 * sizeof(int));
+        EXPECT_EQ(priceStats.peakBytes, 3000 * sizeof(int)); // both buffers while copying
+        EXPECT_EQ(priceStats.freesNum, 1u);
+
+        std::ostringstream dump;
+        AllocationAccounts::instance().dump(dump);
+        EXPECT_NE(dump.str().find("test.prices: live 8000 B (peak 12000 B), allocs: 2, frees: 1"), std::string::npos);
+    }
+
+    EXPECT_EQ(statsOf("test.prices").liveBytes, 0u);
+    EXPECT_EQ(statsOf("test.orders").liveBytes, 0u);
+    EXPECT_EQ(statsOf("test.orders").freesNum, 10u);
+
+    // Allocators made without a label account to nobody in particular
+    const uint64_t unlabelledAllocsNum = statsOf(LabelAccounting::UNLABELLED).allocsNum;
+    {
+        // The list allocates from the segment of the allocator it's given a copy of, which must outlive it
+        MyAllocatorOnStack<int, 1024, SimpleSegmentManager, LabelAccounting> stackAllocator;
+        std::list<int, decltype(stackAllocator)> ints({1, 2, 3}, stackAllocator);
+        EXPECT_EQ(statsOf(LabelAccounting::UNLABELLED).allocsNum, unlabelledAllocsNum + 3);
+    }
+}
+
+TEST(BicyclesAllocationAccountingTestSuite, SpliceBetweenLabels)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    using IntList = std::list<int, LabelledAllocator<int>>;
+    size_t nodesBytes = 0;
+
+    {
+        IntList giver({1, 2, 3}, LabelledAllocator<int>(ssm, "test.giver"));
+        IntList taker(LabelledAllocator<int>(ssm, "test.taker"));
+        ASSERT_TRUE(giver.get_allocator() == taker.get_allocator()); // splice() requires that
+        nodesBytes = statsOf("test.giver").liveBytes;
+        EXPECT_GT(nodesBytes, 0u);
+
+        taker.splice(taker.end(), giver);
+        EXPECT_EQ(taker.size(), 3u);
+    } // the taker frees the giver's nodes
+
+    // The giver keeps the bytes, and the taker's count goes below zero rather than wrapping around:
+    EXPECT_EQ(statsOf("test.giver").liveBytes, nodesBytes);
+    EXPECT_EQ(statsOf("test.taker").liveBytes, 0u);
+    EXPECT_EQ(statsOf("test.taker").freesNum, 3u);
+
+    // It's still counted, so the totals stay right: the taker's next nodes make up for it
+    {
+        IntList taker({1, 2, 3}, LabelledAllocator<int>(ssm, "test.taker"));
+        EXPECT_EQ(statsOf("test.taker").liveBytes, 0u);
+        taker.push_back(4);
+        EXPECT_EQ(statsOf("test.taker").liveBytes, nodesBytes / 3);
+    }
+}
+
+TEST(BicyclesAllocationAccountingTestSuite, ResizingInPlace)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    AllocationAccounts::instance().reset();
+
+    {
+        // Alone in the segment, the buffer grows in place: one allocation, resized rather than reallocated
+        ExpandableVector<int, LabelledAllocator<int>> prices(LabelledAllocator<int>(ssm, "test.resized"));
+        prices.reserve(100);
+        const int* data = prices.data();
+        prices.reserve(1000);
+        ASSERT_EQ(prices.data(), data);
+
+        AllocationAccountStats stats = statsOf("test.resized");
+        EXPECT_EQ(stats.liveBytes, 1000 * sizeof(int));
+        EXPECT_EQ(stats.peakBytes, 1000 * sizeof(int));
+        EXPECT_EQ(stats.allocsNum, 1u);
+        EXPECT_EQ(stats.freesNum, 0u);
+
+        prices.push_back(1);
+        prices.shrink_to_fit();
+        stats = statsOf("test.resized");
+        EXPECT_EQ(stats.liveBytes, sizeof(int));
+        EXPECT_EQ(stats.peakBytes, 1000 * sizeof(int));
+    } // deallocated with the shrunk capacity
+
+    AllocationAccountStats stats = statsOf("test.resized");
+    EXPECT_EQ(stats.liveBytes, 0u);
+    EXPECT_EQ(stats.allocsNum, 1u);
+    EXPECT_EQ(stats.freesNum, 1u);
+}
+
+TEST(BicyclesAllocationAccountingTestSuite, ConcurrentCounters)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    const LabelledAllocator<int> myal(ssm, "test.concurrent");
+    AllocationAccounts::instance().get("test.concurrent").reset();
+
+    const int threadsNum = 4;
+    const int iterations = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadsNum; t++)
+    {
+        threads.emplace_back([&myal]() {
+            LabelledAllocator<int> threadAllocator(myal);
+            for (int i = 0; i < iterations; i++)
+            {
+                int* mem = threadAllocator.allocate(4);
+                threadAllocator.deallocate(mem, 4);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    AllocationAccountStats stats = statsOf("test.concurrent");
+    EXPECT_EQ(stats.allocsNum, uint64_t(threadsNum * iterations));
+    EXPECT_EQ(stats.freesNum, uint64_t(threadsNum * iterations));
+    EXPECT_EQ(stats.liveBytes, 0u);
+    EXPECT_GE(stats.peakBytes, 4 * sizeof(int));
+    EXPECT_LE(stats.peakBytes, threadsNum * 4 * sizeof(int));
+}
@@ -2,9 +2,17 @@
 
 #include "BicycleImpl.hpp"
 #include "MemoryManagement/DummySegmentManager.hpp"
+#include "Containers/BulkInsert.hpp"
+#include "MemoryManagement/FallbackSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorHandle.hpp"
 #include "MemoryManagement/MyAllocatorOnStack.hpp"
 #include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/MyScopedAllocator.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+#include "MemoryManagement/ThreadCacheSegmentManager.hpp"
 
+#include <cstring>
+#include <memory>
 #include <vector>
 #include <list>
 #include <map>
@@ -56,7 +64,7 @@ void testAllocatorWithContainers(MyBicyclesAllocator myal)
 
     {
         std::cout << "=======================std::list=========================" << std::endl;
-        std::list<BicycleImpl, MyBicyclesPairAllocator> lst;
+        std::list<BicycleImpl, MyBicyclesPairAllocator> lst(myal);
 
         for (int i = 0; i < num; i++)
         {
@@ -75,7 +83,7 @@ void testAllocatorWithContainers(MyBicyclesAllocator myal)
 
     {
         std::cout << "=======================std::map===========================" << std::endl;
-        std::map<int, BicycleImpl, std::less<int>, MyBicyclesPairAllocator> mp;
+        std::map<int, BicycleImpl, std::less<int>, MyBicyclesPairAllocator> mp(myal);
 
         for (int i = 0; i < num; i++)
         {
@@ -92,18 +100,20 @@ void testAllocatorWithContainers(MyBicyclesAllocator myal)
 
     {
         std::cout << "=======================std::set===========================" << std::endl;
-        std::set<BicycleImpl, std::less<BicycleImpl>, MyBicyclesPairAllocator> st;
+        std::set<BicycleImpl, std::less<BicycleImpl>, MyBicyclesPairAllocator> st(myal);
+        std::set<std::string> expectedVendors; // bicycles are ordered by vendor name
 
         for (int i = 0; i < num; i++)
         {
             st.emplace("Bicycle-S-" + std::to_string(i));
+            expectedVendors.insert("Bicycle-S-" + std::to_string(i));
         }
         EXPECT_EQ(st.size(), num);
 
-        int index = 0;
+        auto expectedIt = expectedVendors.begin();
         for (const auto& s : st)
         {
-            EXPECT_EQ(s.getVendor(), "Bicycle-S-" + std::to_string(index++));
+            EXPECT_EQ(s.getVendor(), *expectedIt++);
         }
         st.clear();
         EXPECT_EQ(st.size(), 0);
@@ -112,19 +122,17 @@ void testAllocatorWithContainers(MyBicyclesAllocator myal)
 
 TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorOnStack_ContainerObjects)
 {
-    constexpr bool ALLOC_LOGGING = false;
     constexpr size_t SEG_SIZE = 5120; // 5KB
 
     using MyBicyclesAllocatorOnStack = MyAllocatorOnStack<BicycleImpl, SEG_SIZE, SimpleSegmentManager>;
     using MyBicyclesPairAllocatorOnStack = MyAllocatorOnStack<std::pair<const int, BicycleImpl>, SEG_SIZE, SimpleSegmentManager>;
 
-    MyBicyclesAllocatorOnStack myal(ALLOC_LOGGING);
+    MyBicyclesAllocatorOnStack myal;
     testAllocatorWithContainers<MyBicyclesAllocatorOnStack, MyBicyclesPairAllocatorOnStack>(myal);
 }
 
 TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorNonOwning_ContainerObjects)
 {
-    constexpr bool ALLOC_LOGGING = false;
     constexpr size_t SEG_SIZE = 5120; // 5KB
 
     using MyBicyclesAllocatorNonOwning = MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager>;
@@ -132,7 +140,291 @@ TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorNonOwning_ContainerObjects)
 
     char* seg = (char*)malloc(SEG_SIZE);
     SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg, SEG_SIZE);
-    MyBicyclesAllocatorNonOwning myal(ssm, ALLOC_LOGGING);
+    MyBicyclesAllocatorNonOwning myal(ssm);
+    testAllocatorWithContainers<MyBicyclesAllocatorNonOwning, MyBicyclesPairAllocatorNonOwning>(myal);
+    free(seg);
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorNonOwning_ThreadCache_ContainerObjects)
+{
+    constexpr size_t SEG_SIZE = 5120; // 5KB
+
+    using MyBicyclesAllocatorNonOwning = MyAllocatorNonOwning<BicycleImpl, ThreadCacheSegmentManager>;
+    using MyBicyclesPairAllocatorNonOwning = MyAllocatorNonOwning<std::pair<const int, BicycleImpl>, ThreadCacheSegmentManager>;
+
+    char* seg = (char*)malloc(SEG_SIZE);
+    SharedPtr<ThreadCacheSegmentManager> tcsm = makeShared<ThreadCacheSegmentManager>(seg, SEG_SIZE);
+    MyBicyclesAllocatorNonOwning myal(tcsm);
     testAllocatorWithContainers<MyBicyclesAllocatorNonOwning, MyBicyclesPairAllocatorNonOwning>(myal);
     free(seg);
 }
+
+TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorHandle_ContainerObjects)
+{
+    constexpr size_t SEG_SIZE = 5120; // 5KB
+
+    using MyBicyclesAllocatorHandle = MyAllocatorHandle<BicycleImpl, SimpleSegmentManager>;
+    using MyBicyclesPairAllocatorHandle = MyAllocatorHandle<std::pair<const int, BicycleImpl>, SimpleSegmentManager>;
+    static_assert(std::is_trivially_copyable_v<MyBicyclesPairAllocatorHandle>);
+    static_assert(sizeof(MyBicyclesPairAllocatorHandle) == sizeof(void*));
+
+    char* seg = (char*)malloc(SEG_SIZE);
+    SimpleSegmentManager ssm(seg, SEG_SIZE); // outlives all the containers
+    MyBicyclesAllocatorHandle myal(&ssm);
+    testAllocatorWithContainers<MyBicyclesAllocatorHandle, MyBicyclesPairAllocatorHandle>(myal);
+
+    // Rebinds & copies refer to the same segment manager:
+    MyBicyclesPairAllocatorHandle rebound(myal);
+    EXPECT_EQ(rebound.getSegmentManager(), &ssm);
+    EXPECT_TRUE(rebound == myal);
+    EXPECT_FALSE(MyBicyclesAllocatorHandle() == myal);
+    EXPECT_THROW(MyBicyclesAllocatorHandle().allocate(1), std::bad_alloc);
+
+    // Batches work through the handle too:
+    std::list<int, MyAllocatorHandle<int, SimpleSegmentManager>> ids(myal);
+    std::vector<int> source{1, 2, 3, 4};
+    bulkInsert(ids, source.begin(), source.end());
+    EXPECT_EQ(ids.size(), source.size());
+    bulkClear(ids);
+    EXPECT_EQ(ssm.getStats().allocsNum, ssm.getStats().freesNum);
+    free(seg);
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, MyAllocatorStackFirst_Overflow)
+{
+    constexpr size_t SEG_SIZE = 512;
+
+    {
+        // Small vectors stay in the stack segment, a large one goes to the heap:
+        MyAllocatorStackFirst<int, SEG_SIZE> myal;
+        auto manager = myal.getSegmentManager();
+        std::vector<int, MyAllocatorStackFirst<int, SEG_SIZE>> ids(myal);
+        ids.reserve(16);
+        EXPECT_TRUE(manager->isInSegment(ids.data()));
+        for (int i = 0; i < 1000; i++)
+        {
+            ids.push_back(i);
+        }
+        EXPECT_FALSE(manager->isInSegment(ids.data()));
+        EXPECT_EQ(ids[999], 999);
+        EXPECT_GT(manager->getOverflowsNum(), 0u);
+        ids.clear();
+        ids.shrink_to_fit();
+        SegmentManagerStats stats = manager->getStats();
+        EXPECT_EQ(stats.allocsNum, stats.freesNum);
+        EXPECT_EQ(stats.failedAllocsNum, 0u);
+    }
+
+    {
+        // Overflowing to a given segment manager; each node goes back to where it came from:
+        const size_t upstreamSegSize = 64 * 1024;
+        std::unique_ptr<char[]> upstreamSeg(new char[upstreamSegSize]);
+        auto upstream = makeShared<SimpleSegmentManager>(upstreamSeg.get(), upstreamSegSize);
+        using Allocator = MyAllocatorStackFirst<BicycleImpl, SEG_SIZE, SimpleSegmentManager, SimpleSegmentManager>;
+        Allocator myal(upstream);
+        const SegmentManagerStats initial = myal.getStats();
+
+        std::list<BicycleImpl, Allocator> bicycles(myal);
+        for (int i = 0; i < 50; i++)
+        {
+            bicycles.emplace_back("Bicycle", i, i);
+        }
+        auto manager = myal.getSegmentManager();
+        EXPECT_TRUE(manager->isInSegment(&bicycles.front()));
+        EXPECT_FALSE(manager->isInSegment(&bicycles.back()));
+        EXPECT_GT(upstream->getStats().allocsNum, 0u);
+        EXPECT_EQ(bicycles.back().getPressureFront(), 49);
+
+        bicycles.clear();
+        EXPECT_EQ(upstream->getStats().allocsNum, upstream->getStats().freesNum);
+        EXPECT_EQ(manager->getStats().occupiedBytes, initial.occupiedBytes);
+
+        // Growing a block out of the segment moves it upstream with its contents:
+        char* block = static_cast<char*>(manager->alloc(100));
+        std::strcpy(block, "on stack");
+        char* moved = static_cast<char*>(manager->realloc(block, 4096));
+        ASSERT_NE(moved, nullptr);
+        EXPECT_FALSE(manager->isInSegment(moved));
+        EXPECT_STREQ(moved, "on stack");
+        manager->free(moved);
+    }
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, Propagation)
+{
+    using Allocator = MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager>;
+    using Traits = std::allocator_traits<Allocator>;
+    static_assert(Traits::propagate_on_container_move_assignment::value, "");
+    static_assert(Traits::propagate_on_container_swap::value, "");
+    static_assert(!Traits::is_always_equal::value, "");
+    static_assert(std::allocator_traits<MyAllocatorHandle<int>>::propagate_on_container_move_assignment::value, "");
+    static_assert(!std::allocator_traits<MyAllocatorOnStack<int, 128>>::propagate_on_container_move_assignment::value,
+                  "The segment on stack can't go along with the containers' memory");
+
+    const size_t segSize = 64 * 1024;
+    std::unique_ptr<char[]> seg1(new char[segSize]);
+    std::unique_ptr<char[]> seg2(new char[segSize]);
+    auto ssm1 = makeShared<SimpleSegmentManager>(seg1.get(), segSize);
+    auto ssm2 = makeShared<SimpleSegmentManager>(seg2.get(), segSize);
+    Allocator myal1(ssm1);
+    Allocator myal2(ssm2);
+
+    // Equal if (and only if) they share the segment manager, rebinds included:
+    EXPECT_TRUE(myal1 == Allocator(ssm1));
+    EXPECT_TRUE(myal1 != myal2);
+    EXPECT_TRUE((MyAllocatorNonOwning<int, SimpleSegmentManager>(myal1) == myal1));
+
+    // Move assignment between segments steals the buffer, the allocator goes along with it:
+    std::vector<BicycleImpl, Allocator> bicycles1(myal1);
+    std::vector<BicycleImpl, Allocator> bicycles2(myal2);
+    for (int i = 0; i < 10; i++)
+    {
+        bicycles1.emplace_back("Bicycle", i, i);
+    }
+    const BicycleImpl* data = bicycles1.data();
+    const uint64_t allocsNum = ssm2->getStats().allocsNum;
+    bicycles2 = std::move(bicycles1);
+    EXPECT_EQ(bicycles2.data(), data);
+    EXPECT_TRUE(bicycles2.get_allocator() == myal1);
+    EXPECT_EQ(ssm2->getStats().allocsNum, allocsNum);
+
+    // ...and the moved-from container is still usable:
+    bicycles1.emplace_back("Bicycle", 1, 1);
+    EXPECT_TRUE(bicycles1.get_allocator() == myal1);
+
+    // Swapping swaps the allocators too:
+    std::list<int, MyAllocatorNonOwning<int, SimpleSegmentManager>> ints1({1, 2}, myal1);
+    std::list<int, MyAllocatorNonOwning<int, SimpleSegmentManager>> ints2({3}, myal2);
+    ints1.swap(ints2);
+    EXPECT_TRUE(ints1.get_allocator() == myal2);
+    EXPECT_EQ(ints1.front(), 3);
+    ints1.clear();
+    ints2.clear();
+    bicycles1.clear();
+    bicycles1.shrink_to_fit();
+    EXPECT_EQ(ssm2->getStats().allocsNum, ssm2->getStats().freesNum);
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, MyScopedAllocator_NestedContainers)
+{
+    const size_t segSize = 256 * 1024;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), segSize);
+    auto isInSegment = [&seg, segSize](const void* addr) {
+        return addr >= seg.get() && addr < seg.get() + segSize;
+    };
+
+    {
+        using Vendors = SegmentVector<SegmentString<>>;
+        SegmentMap<int, Vendors> vendorsByYear(ssm);
+        for (int year = 2000; year < 2010; year++)
+        {
+            // Neither the vector nor the strings are given an allocator: they get the map's one
+            Vendors& vendors = vendorsByYear[year];
+            vendors.emplace_back("A vendor name too long for the small string buffer");
+            vendors.push_back(vendors.front());
+        }
+
+        const Vendors& vendors = vendorsByYear.at(2005);
+        EXPECT_TRUE(isInSegment(vendors.data()));
+        EXPECT_TRUE(isInSegment(vendors.back().data()));
+        EXPECT_TRUE(vendors.get_allocator() == vendorsByYear.get_allocator());
+        EXPECT_GT(ssm->getStats().allocsNum, 40u);
+
+        // Copies of the elements stay in the segment too:
+        Vendors copied = vendors;
+        EXPECT_TRUE(isInSegment(copied.front().data()));
+    }
+
+    // The whole structure went back to the segment with the map
+    SegmentManagerStats stats = ssm->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, TryAllocate)
+{
+    const size_t segSize = 4096;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    MyAllocatorNonOwning<int> myal(makeShared<SimpleSegmentManager>(seg.get(), segSize));
+
+    AllocResult<int> result = myal.tryAllocate(100);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result.error, AllocError::None);
+
+    // Failures are returned, and allocate() throws the same as before:
+    AllocResult<int> exhausted = myal.tryAllocate(segSize);
+    EXPECT_FALSE(exhausted);
+    EXPECT_EQ(exhausted.error, AllocError::OutOfMemory);
+    EXPECT_THROW(static_cast<void>(myal.allocate(segSize)), std::runtime_error);
+    EXPECT_EQ(myal.tryAllocate(0).error, AllocError::ZeroSize);
+    EXPECT_THROW(static_cast<void>(myal.allocate(0)), std::bad_alloc);
+    EXPECT_EQ(myal.tryAllocate(SIZE_MAX / 2).error, AllocError::OutOfMemory);
+    EXPECT_EQ(MyAllocatorNonOwning<int>().tryAllocate(1).error, AllocError::NoSegmentManager);
+    EXPECT_EQ(myal.getStats().failedAllocsNum, 2);
+
+    int foreign[4];
+    EXPECT_EQ(myal.tryDeallocate(foreign, 4), AllocError::InvalidPointer);
+    EXPECT_EQ(myal.tryDeallocate(nullptr, 4), AllocError::NullPointer);
+    EXPECT_EQ(myal.tryDeallocate(result.ptr, 100), AllocError::None);
+    EXPECT_EQ(myal.tryDeallocate(result.ptr, 100), AllocError::DoubleFree);
+    EXPECT_EQ(myal.getStats().freesNum, 1);
+
+    // A segment manager with a sized free & without tryFree():
+    SmallObjectSegmentManager manager(seg.get(), segSize);
+    MyAllocatorHandle<int, SmallObjectSegmentManager> handle(&manager);
+    AllocResult<int> small = handle.tryAllocate(4);
+    ASSERT_TRUE(small);
+    EXPECT_EQ(handle.tryDeallocate(foreign, 4), AllocError::InvalidPointer);
+    EXPECT_EQ(handle.tryDeallocate(small.ptr, 4), AllocError::None);
+    EXPECT_EQ(manager.getStats().allocsNum, manager.getStats().freesNum);
+}
+
+TEST(BicyclesCustomAllocatorsTestSuite, FallbackChain)
+{
+    char segA[512];
+    const size_t segBSize = 64 * 1024;
+    std::unique_ptr<char[]> segB(new char[segBSize]);
+    using Chain = FallbackChain<SimpleSegmentManager, SmallObjectSegmentManager>;
+    SharedPtr<Chain> chain = makeFallbackChain<SimpleSegmentManager, SmallObjectSegmentManager>(
+                                 SegmentSpan{segA, sizeof(segA)}, SegmentSpan{segB.get(), segBSize});
+    const auto& upstream = chain->getUpstream();
+    auto isInB = [&segB, segBSize](const void* addr) {
+        return addr >= segB.get() && addr < segB.get() + segBSize;
+    };
+
+    // Segment A, then B, then the heap:
+    MyAllocatorNonOwning<char, Chain> myal(chain);
+    std::vector<char*> blocks;
+    for (size_t bytes : {256, 256, 1024, 1024, 128 * 1024})
+    {
+        AllocResult<char> result = myal.tryAllocate(bytes);
+        ASSERT_TRUE(result);
+        blocks.push_back(result.ptr);
+    }
+    EXPECT_TRUE(chain->isInSegment(blocks[0]));
+    EXPECT_FALSE(chain->isInSegment(blocks[1]));
+    EXPECT_TRUE(isInB(blocks[1]));
+    EXPECT_TRUE(isInB(blocks[3]));
+    EXPECT_FALSE(isInB(blocks[4]));
+    EXPECT_EQ(chain->getOverflowsNum(), 4);
+    EXPECT_EQ(upstream->getOverflowsNum(), 1);
+
+    // Every block goes back to its level:
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        EXPECT_EQ(chain->tryFree(blocks[i]), AllocError::None);
+    }
+    EXPECT_EQ(chain->tryFree(nullptr), AllocError::NullPointer);
+    SegmentManagerStats stats = chain->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    stats = upstream->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+
+    // The containers need nothing special:
+    std::vector<int, MyAllocatorNonOwning<int, Chain>> ints{MyAllocatorNonOwning<int, Chain>(chain)};
+    for (int i = 0; i < 10000; i++)
+    {
+        ints.push_back(i);
+    }
+    EXPECT_EQ(ints[9999], 9999);
+}
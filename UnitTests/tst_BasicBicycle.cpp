@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "BasicBicycle.hpp"
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyScopedAllocator.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const size_t SEG_SIZE = 1024 * 1024;
+    const char* LONG_VENDOR = "Santa Cruz Bicycles"; // beyond the small string buffer
+}
+
+TEST(BicyclesBasicBicycleTestSuite, BicycleImplMoves)
+{
+    // Vectors move (rather than copy) the bicycles when they grow:
+    static_assert(std::is_nothrow_move_constructible_v<BicycleImpl>, "");
+    static_assert(std::is_nothrow_move_assignable_v<BicycleImpl>, "");
+
+    BicycleImpl santaCruz(LONG_VENDOR, 40, 45);
+    BicycleImpl moved(std::move(santaCruz));
+    EXPECT_EQ(moved.getVendor(), LONG_VENDOR);
+    EXPECT_EQ(moved.getPressureRear(), 45);
+    EXPECT_EQ(santaCruz.getVendor(), "");
+    EXPECT_EQ(santaCruz.getPressureRear(), 0);
+
+    BicycleImpl giant("Giant");
+    giant = std::move(moved);
+    EXPECT_EQ(giant.getVendor(), LONG_VENDOR);
+    EXPECT_EQ(moved.getVendor(), "");
+}
+
+TEST(BicyclesBasicBicycleTestSuite, InlineBicycle)
+{
+    static_assert(std::is_trivially_copyable_v<InlineBicycle>, "");
+    static_assert(sizeof(InlineBicycle) == 28, "");
+    static_assert(!std::uses_allocator<InlineBicycle, std::allocator<char>>::value, "");
+
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    std::vector<InlineBicycle, MyAllocatorNonOwning<InlineBicycle>> bicycles(ssm);
+    bicycles.emplace_back(LONG_VENDOR, 40, 45);
+    bicycles.emplace_back("Giant");
+    std::sort(bicycles.begin(), bicycles.end());
+    EXPECT_EQ(bicycles.front().getVendor(), "Giant");
+    EXPECT_EQ(bicycles.front().getPressureFront(), CITY_BIKE_NORMAL_PRESSURE_PSI);
+    EXPECT_EQ(bicycles.back().getVendor(), LONG_VENDOR);
+
+    EXPECT_THROW(InlineBicycle("Specialized Bicycle Components"), std::length_error);
+}
+
+TEST(BicyclesBasicBicycleTestSuite, AllocBicycleInSegment)
+{
+    using Bike = AllocBicycle<MyScopedAllocator<char>>;
+    static_assert(std::uses_allocator<Bike, MyScopedAllocator<Bike>>::value, "");
+    static_assert(std::is_nothrow_move_constructible_v<Bike>, "");
+
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    auto isInSegment = [&seg](const void* addr) {
+        return addr >= seg.get() && addr < seg.get() + SEG_SIZE;
+    };
+
+    {
+        SegmentVector<Bike> bicycles(ssm);
+        for (int i = 0; i < 100; i++)
+        {
+            // The names are allocated by the vector's allocator, & moved along when the vector grows
+            bicycles.emplace_back(i % 2 ? LONG_VENDOR : "Giant", i, i);
+        }
+        std::sort(bicycles.begin(), bicycles.end());
+        EXPECT_EQ(bicycles.front().getVendor(), "Giant");
+        EXPECT_EQ(bicycles.back().getVendor(), LONG_VENDOR);
+        EXPECT_TRUE(isInSegment(bicycles.back().getVendor().data()));
+
+        SegmentVector<Bike> copied(bicycles);
+        EXPECT_TRUE(isInSegment(copied.back().getVendor().data()));
+    }
+
+    SegmentManagerStats stats = ssm->getStats();
+    EXPECT_GT(stats.allocsNum, 100u);
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "Containers/BulkInsert.hpp"
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+TEST(BicyclesBulkInsertTestSuite, ListNodesAreAdjacent)
+{
+    static_assert(HasBatchAlloc<SimpleSegmentManager>::value, "Batches not detected");
+    static_assert(!HasBatchAlloc<DummySegmentManager>::value, "Batches detected by mistake");
+
+    const size_t segSize = 1024 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> manager = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager> myal(manager);
+
+    std::vector<BicycleImpl> source;
+    for (int i = 0; i < 1000; i++)
+    {
+        source.emplace_back("Bicycle " + std::to_string(i));
+    }
+
+    std::list<BicycleImpl, MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager>> lst(myal);
+    lst.emplace_back("First");
+    bulkInsert(lst, source.begin(), source.end());
+    ASSERT_EQ(lst.size(), 1001);
+    EXPECT_EQ(lst.front().getVendor(), "First");
+    EXPECT_EQ(lst.back().getVendor(), "Bicycle 999");
+
+    // Nodes carved from a batch follow each other in memory:
+    auto it = std::next(lst.begin());
+    const char* prev = reinterpret_cast<const char*>(&*it);
+    size_t nodeStride = reinterpret_cast<const char*>(&*std::next(it)) - prev;
+    for (++it; it != lst.end(); ++it)
+    {
+        EXPECT_EQ(reinterpret_cast<const char*>(&*it) - prev, nodeStride);
+        prev = reinterpret_cast<const char*>(&*it);
+    }
+
+    bulkClear(lst);
+    EXPECT_TRUE(lst.empty());
+    SegmentManagerStats stats = manager->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+}
+
+TEST(BicyclesBulkInsertTestSuite, MapAndFallbacks)
+{
+    const size_t segSize = 1024 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> manager = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    using MapAllocator = MyAllocatorNonOwning<std::pair<const int, std::string>, SimpleSegmentManager>;
+
+    std::vector<std::pair<const int, std::string>> source;
+    for (int i = 0; i < 100; i++)
+    {
+        source.emplace_back(i % 50, std::to_string(i)); // duplicate keys are skipped by map
+    }
+    {
+        std::map<int, std::string, std::less<int>, MapAllocator> mp{MapAllocator(manager)};
+        bulkInsert(mp, source.begin(), source.end());
+        EXPECT_EQ(mp.size(), 50);
+        EXPECT_EQ(mp.at(49), "49");
+    }
+    SegmentManagerStats stats = manager->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    EXPECT_EQ(stats.freeBlocksNum, 1); // unused blocks of the batch are given back
+
+    // Managers without batches & allocators without managers insert one by one:
+    std::list<int, MyAllocatorNonOwning<int, DummySegmentManager>> dummyLst(
+                MyAllocatorNonOwning<int, DummySegmentManager>(makeShared<DummySegmentManager>(nullptr, 0, false)));
+    std::vector<int> ints{1, 2, 3};
+    bulkInsert(dummyLst, ints.begin(), ints.end());
+    EXPECT_EQ(dummyLst.size(), 3);
+}
+
+TEST(BicyclesBulkInsertTestSuite, InvalidDeferredFree)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> manager = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<int, SimpleSegmentManager> myal(manager);
+
+    int outside = 0;
+    int* before = myal.allocate(1);
+    int* after = myal.allocate(1);
+    testing::internal::CaptureStderr();
+    {
+        BulkAllocationScope<SimpleSegmentManager> scope(*manager, 8);
+        int* fromBatch = myal.allocate(1); // the rest of the batch goes unused
+        myal.deallocate(before, 1);
+        myal.deallocate(&outside, 1); // deferred, so it doesn't throw here...
+        myal.deallocate(after, 1);
+        myal.deallocate(fromBatch, 1);
+    } // ...and the scope's end doesn't terminate the program, but reports it
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("invalid pointer"), std::string::npos);
+
+    // Only the invalid pointer is skipped: the blocks after it & the unused batch are freed too
+    SegmentManagerStats stats = manager->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+}
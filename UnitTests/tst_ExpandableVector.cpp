@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "Containers/ExpandableVector.hpp"
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/MonotonicArenaSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    // Copying throws once the countdown runs out (and there's no move ctor, so relocation copies)
+    struct ThrowingCopy
+    {
+        static int sCopiesLeft;
+
+        explicit ThrowingCopy(int value) :
+            value(value)
+        {
+        }
+
+        ThrowingCopy(const ThrowingCopy& rhs) :
+            value(rhs.value)
+        {
+            if (0 == sCopiesLeft--)
+            {
+                throw std::runtime_error("Copy failed");
+            }
+        }
+
+        int value;
+    };
+
+    int ThrowingCopy::sCopiesLeft = 0;
+
+    template <typename SegmentManagerType>
+    using BicyclesVector = ExpandableVector<BicycleImpl, MyAllocatorNonOwning<BicycleImpl, SegmentManagerType>>;
+
+    template <typename Vector>
+    void fillAndCheck(Vector& vec, int num)
+    {
+        for (int i = 0; i < num; i++)
+        {
+            vec.push_back({"Bicycle-V-" + std::to_string(i)});
+        }
+        ASSERT_EQ(vec.size(), num);
+        for (int i = 0; i < num; i++)
+        {
+            EXPECT_EQ(vec[i].getVendor(), "Bicycle-V-" + std::to_string(i));
+        }
+    }
+}
+
+TEST(BicyclesExpandableVectorTestSuite, GrowsInPlace)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<BicycleImpl> myal(ssm);
+
+    BicyclesVector<SimpleSegmentManager> vec(myal);
+    vec.reserve(1);
+    const BicycleImpl* initialData = vec.data();
+    fillAndCheck(vec, 100);
+    EXPECT_EQ(vec.data(), initialData); // the elements have never moved
+    EXPECT_GE(vec.capacity(), 100);
+
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec.capacity(), 100);
+    // The cut off tail is free again:
+    void* p = ssm->alloc(64);
+    EXPECT_GT(p, (void*)(vec.data() + vec.size()));
+    EXPECT_LT(p, (void*)(vec.data() + 128));
+    ssm->free(p);
+
+    BicyclesVector<SimpleSegmentManager> copy(vec);
+    EXPECT_EQ(copy.size(), vec.size());
+    EXPECT_EQ(copy.back().getVendor(), "Bicycle-V-99");
+
+    BicyclesVector<SimpleSegmentManager> moved(std::move(copy));
+    EXPECT_EQ(moved.size(), vec.size());
+    EXPECT_TRUE(copy.empty());
+}
+
+TEST(BicyclesExpandableVectorTestSuite, RelocatesWhenBlocked)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<BicycleImpl> myal(ssm);
+
+    BicyclesVector<SimpleSegmentManager> vec(myal);
+    vec.reserve(4);
+    void* blocker = ssm->alloc(16); // right after the vector's buffer
+    const BicycleImpl* initialData = vec.data();
+    fillAndCheck(vec, 5);
+    EXPECT_NE(vec.data(), initialData);
+    ssm->free(blocker);
+}
+
+TEST(BicyclesExpandableVectorTestSuite, PushBackOfOwnElement)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    using Strings = ExpandableVector<std::string, MyAllocatorNonOwning<std::string>>;
+    const std::string longVendor(40, 'v'); // beyond the small string buffer
+
+    Strings vec{MyAllocatorNonOwning<std::string>(ssm)};
+    vec.push_back(longVendor);
+    for (int i = 0; i < 8; i++)
+    {
+        void* blocker = ssm->alloc(16); // the buffer has to move on every growth
+        vec.push_back(vec[0]);
+        vec.emplace_back(vec.back());
+        ssm->free(blocker);
+    }
+    ASSERT_EQ(vec.size(), 17);
+    for (const std::string& vendor : vec)
+    {
+        EXPECT_EQ(vendor, longVendor);
+    }
+}
+
+TEST(BicyclesExpandableVectorTestSuite, OtherSegmentManagers)
+{
+    {
+        SharedPtr<DummySegmentManager> dsm = makeShared<DummySegmentManager>(nullptr, 0, false);
+        BicyclesVector<DummySegmentManager> vec(MyAllocatorNonOwning<BicycleImpl, DummySegmentManager>{dsm});
+        fillAndCheck(vec, 50);
+    }
+
+    {
+        const size_t segSize = 64 * 1024;
+        std::vector<char> seg(segSize);
+        SharedPtr<MonotonicArenaSegmentManager> arena = makeShared<MonotonicArenaSegmentManager>(seg.data(), segSize);
+        BicyclesVector<MonotonicArenaSegmentManager> vec(MyAllocatorNonOwning<BicycleImpl, MonotonicArenaSegmentManager>{arena});
+        vec.reserve(1);
+        const BicycleImpl* initialData = vec.data();
+        fillAndCheck(vec, 100);
+        EXPECT_EQ(vec.data(), initialData);
+        EXPECT_EQ(arena->getUsedBytes(), 128 * sizeof(BicycleImpl));
+    }
+}
+
+TEST(BicyclesExpandableVectorTestSuite, RelocationThrows)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    using Vector = ExpandableVector<ThrowingCopy, MyAllocatorNonOwning<ThrowingCopy>>;
+
+    {
+        Vector vec{MyAllocatorNonOwning<ThrowingCopy>(ssm)};
+        vec.reserve(4);
+        for (int i = 0; i < 4; i++)
+        {
+            vec.emplace_back(i);
+        }
+        const uint64_t allocsNum = ssm->getStats().allocsNum;
+        const uint64_t freesNum = ssm->getStats().freesNum;
+
+        // The 3rd element fails to move over: the new buffer is given back & the vector is intact
+        void* blocker = ssm->alloc(16);
+        ThrowingCopy::sCopiesLeft = 2;
+        EXPECT_THROW(vec.reserve(8), std::runtime_error);
+        ThrowingCopy::sCopiesLeft = 2;
+        EXPECT_THROW(vec.emplace_back(4), std::runtime_error);
+        ssm->free(blocker);
+
+        EXPECT_EQ(ssm->getStats().allocsNum - allocsNum, ssm->getStats().freesNum - freesNum);
+        ASSERT_EQ(vec.size(), 4);
+        EXPECT_EQ(vec.capacity(), 4);
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT_EQ(vec[i].value, i);
+        }
+    }
+    SegmentManagerStats stats = ssm->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/FixedBlockSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorOnStack.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+
+#include <list>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+TEST(BicyclesFixedBlockSegmentManagerTestSuite, AllocFree)
+{
+    constexpr size_t BLOCK_SZ = 64;
+    const size_t segSize = 1024;
+    alignas(std::max_align_t) char seg[segSize];
+    FixedBlockSegmentManager<BLOCK_SZ> fbsm(seg, segSize);
+    ASSERT_EQ(fbsm.getBlocksNum(), segSize / BLOCK_SZ);
+
+    // Too large & over-aligned requests are rejected:
+    EXPECT_EQ(fbsm.alloc(BLOCK_SZ + 1), nullptr);
+    EXPECT_EQ(fbsm.alloc(16, 2 * alignof(std::max_align_t)), nullptr);
+
+    std::set<void*> blocks;
+    for (size_t i = 0; i < fbsm.getBlocksNum(); i++)
+    {
+        void* p = fbsm.alloc(BLOCK_SZ);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t), 0);
+        EXPECT_TRUE(blocks.insert(p).second);
+    }
+    // Exhausted:
+    EXPECT_EQ(fbsm.alloc(1), nullptr);
+
+    SegmentManagerStats stats = fbsm.getStats();
+    EXPECT_EQ(stats.allocsNum, fbsm.getBlocksNum());
+    EXPECT_EQ(stats.failedAllocsNum, 3);
+    EXPECT_EQ(stats.freeBytes, 0);
+    EXPECT_EQ(stats.occupiedBytes, segSize);
+    EXPECT_EQ(stats.peakOccupiedBytes, segSize);
+
+    void* last = *blocks.rbegin();
+    fbsm.free(last);
+    EXPECT_EQ(fbsm.alloc(BLOCK_SZ), last);
+
+    EXPECT_THROW(fbsm.free(nullptr), std::invalid_argument);
+    EXPECT_THROW(fbsm.free(seg + 1), std::runtime_error);
+    EXPECT_THROW(fbsm.free(seg + segSize), std::runtime_error);
+    EXPECT_EQ(fbsm.tryFree(nullptr), AllocError::NullPointer);
+    EXPECT_EQ(fbsm.tryFree(seg + 1), AllocError::InvalidPointer);
+    EXPECT_EQ(fbsm.tryFree(last), AllocError::None);
+
+    // A double free is reported, and the block isn't pushed twice:
+    EXPECT_EQ(fbsm.tryFree(last), AllocError::DoubleFree);
+    EXPECT_THROW(fbsm.free(last), std::runtime_error);
+    EXPECT_EQ(fbsm.getStats().freesNum, 2);
+    EXPECT_EQ(fbsm.alloc(BLOCK_SZ), last);
+    EXPECT_EQ(fbsm.alloc(BLOCK_SZ), nullptr);
+
+    for (void* p : blocks)
+    {
+        fbsm.free(p);
+    }
+}
+
+TEST(BicyclesFixedBlockSegmentManagerTestSuite, NodeContainers)
+{
+    constexpr size_t BLOCK_SZ = 128; // large enough for list, map & set nodes of BicycleImpl
+    constexpr size_t SEG_SIZE = 8192;
+    constexpr int num = 32;
+
+    using MyBicyclesAllocator = MyAllocatorOnStack<BicycleImpl, SEG_SIZE, FixedBlockSegmentManager<BLOCK_SZ>>;
+    using MyBicyclesPairAllocator = MyAllocatorOnStack<std::pair<const int, BicycleImpl>, SEG_SIZE,
+                                                       FixedBlockSegmentManager<BLOCK_SZ>>;
+
+    std::list<BicycleImpl, MyBicyclesAllocator> lst;
+    std::map<int, BicycleImpl, std::less<int>, MyBicyclesPairAllocator> mp;
+    for (int i = 0; i < num; i++)
+    {
+        lst.push_back({"Bicycle-L-" + std::to_string(i)});
+        mp.emplace(i, BicycleImpl("Bicycle-M-" + std::to_string(i)));
+    }
+
+    int index = 0;
+    for (const auto& l : lst)
+    {
+        EXPECT_EQ(l.getVendor(), "Bicycle-L-" + std::to_string(index++));
+    }
+    for (int i = 0; i < num; i++)
+    {
+        EXPECT_EQ(mp.at(i).getVendor(), "Bicycle-M-" + std::to_string(i));
+    }
+
+    // Arrays of nodes don't fit into a block:
+    std::vector<BicycleImpl, MyBicyclesAllocator> vec;
+    EXPECT_THROW(vec.reserve(num), std::runtime_error);
+}
+
+TEST(BicyclesFixedBlockSegmentManagerTestSuite, ConcurrentAllocFree)
+{
+    constexpr size_t BLOCK_SZ = 32;
+    const size_t blocksNum = 256;
+    const size_t threadsNum = 8;
+    const size_t roundsNum = 2000;
+    std::vector<char> seg(blocksNum * BLOCK_SZ + alignof(std::max_align_t));
+    FixedBlockSegmentManager<BLOCK_SZ> fbsm(seg.data(), seg.size());
+
+    std::atomic<size_t> corruptions(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadsNum; t++)
+    {
+        threads.emplace_back([&, t]() {
+            std::vector<size_t*> mine;
+            for (size_t round = 0; round < roundsNum; round++)
+            {
+                for (size_t i = 0; i < blocksNum / threadsNum; i++)
+                {
+                    size_t* p = static_cast<size_t*>(fbsm.alloc(BLOCK_SZ));
+                    if (p != nullptr)
+                    {
+                        *p = t;
+                        mine.push_back(p);
+                    }
+                }
+                for (size_t* p : mine)
+                {
+                    // Nobody else may have got our block
+                    if (*p != t)
+                    {
+                        corruptions++;
+                    }
+                    fbsm.free(p);
+                }
+                mine.clear();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(corruptions.load(), 0);
+
+    // All the blocks are back:
+    size_t freeBlocks = 0;
+    while (fbsm.alloc(BLOCK_SZ) != nullptr)
+    {
+        freeBlocks++;
+    }
+    EXPECT_EQ(freeBlocks, fbsm.getBlocksNum());
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/GrowableSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+TEST(BicyclesGrowableSegmentManagerTestSuite, MmapSegmentCommit)
+{
+    const size_t page = MmapSegment::pageSize();
+    MmapSegment seg(16 * page, 1);
+    EXPECT_EQ(seg.getReservedSize(), 16 * page);
+    EXPECT_EQ(seg.getCommittedSize(), page);
+
+    char* base = seg.data();
+    std::memset(base, 'a', page);
+    EXPECT_TRUE(seg.commit(3 * page + 1));
+    EXPECT_EQ(seg.getCommittedSize(), 4 * page);
+    EXPECT_EQ(seg.data(), base); // no relocation
+    std::memset(base + page, 'b', 3 * page);
+    EXPECT_EQ(base[page - 1], 'a');
+
+    EXPECT_TRUE(seg.commit(page)); // shrinking is a no-op
+    EXPECT_EQ(seg.getCommittedSize(), 4 * page);
+    EXPECT_FALSE(seg.commit(17 * page));
+
+    EXPECT_THROW(MmapSegment(page, 2 * page), std::invalid_argument);
+}
+
+TEST(BicyclesGrowableSegmentManagerTestSuite, GrowsInPlace)
+{
+    const size_t page = MmapSegment::pageSize();
+    GrowableSegmentManager gsm(page, 64 * page, 2 * page);
+    EXPECT_EQ(gsm.getCommittedSize(), page);
+    EXPECT_EQ(gsm.getMaxSize(), 64 * page);
+
+    char* first = static_cast<char*>(gsm.alloc(page / 2));
+    ASSERT_NE(first, nullptr);
+    std::memset(first, 'x', page / 2);
+
+    // Doesn't fit into the initial segment:
+    char* second = static_cast<char*>(gsm.alloc(page));
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(gsm.getCommittedSize(), 3 * page);
+    std::memset(second, 'y', page);
+    EXPECT_EQ(first[page / 2 - 1], 'x');
+
+    // Larger than the grow step:
+    char* third = static_cast<char*>(gsm.alloc(10 * page));
+    ASSERT_NE(third, nullptr);
+    std::memset(third, 'z', 10 * page);
+
+    // Larger than the reserve:
+    EXPECT_EQ(gsm.alloc(64 * page), nullptr);
+
+    gsm.free(third);
+    gsm.free(second);
+    gsm.free(first);
+
+    // Everything's merged back into a single free block:
+    EXPECT_NE(gsm.alloc(gsm.getCommittedSize() - page), nullptr);
+}
+
+TEST(BicyclesGrowableSegmentManagerTestSuite, ExpandGrowsForTheLastBlockOnly)
+{
+    const size_t page = MmapSegment::pageSize();
+    GrowableSegmentManager gsm(16 * page, 1024 * page, 16 * page);
+
+    void* a = gsm.alloc(64);
+    void* b = gsm.alloc(64);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    // A block followed by an occupied one can't grow in place, however large the segment gets:
+    for (int i = 0; i < 20; i++)
+    {
+        EXPECT_FALSE(gsm.tryExpand(a, 32 * page));
+    }
+    EXPECT_EQ(gsm.getCommittedSize(), 16 * page);
+
+    // The block before the free tail of the segment grows along with the segment:
+    EXPECT_TRUE(gsm.tryExpand(b, 32 * page));
+    EXPECT_GT(gsm.getCommittedSize(), 16 * page);
+
+    gsm.free(a);
+    gsm.free(b);
+}
+
+TEST(BicyclesGrowableSegmentManagerTestSuite, Containers)
+{
+    const size_t page = MmapSegment::pageSize();
+    using MyBicyclesAllocatorNonOwning = MyAllocatorNonOwning<BicycleImpl, GrowableSegmentManager>;
+
+    SharedPtr<GrowableSegmentManager> gsm = makeShared<GrowableSegmentManager>(page, 1024 * page, page);
+    MyBicyclesAllocatorNonOwning myal(gsm);
+    std::vector<BicycleImpl, MyBicyclesAllocatorNonOwning> vec(myal);
+
+    const int num = 1000;
+    for (int i = 0; i < num; i++)
+    {
+        vec.push_back({"Bicycle-V-" + std::to_string(i)});
+    }
+    for (int i = 0; i < num; i++)
+    {
+        EXPECT_EQ(vec[i].getVendor(), "Bicycle-V-" + std::to_string(i));
+    }
+    EXPECT_GT(gsm->getCommittedSize(), page);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/HeapProfiler.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+
+#include <cmath>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const size_t SEG_SIZE = 16 * 1024 * 1024;
+
+    using Bicycles = std::list<BicycleImpl, MyAllocatorNonOwning<BicycleImpl, SimpleSegmentManager>>;
+    using Buffer = std::vector<char, MyAllocatorNonOwning<char, SimpleSegmentManager>>;
+
+    // Two distinct call sites:
+    __attribute__((noinline)) void parkBicycles(Bicycles& bicycles, int num)
+    {
+        for (int i = 0; i < num; i++)
+        {
+            bicycles.emplace_back("Bicycle", i, i);
+        }
+    }
+
+    __attribute__((noinline)) void reserveBuffer(Buffer& buffer, size_t bytes)
+    {
+        buffer.reserve(bytes);
+    }
+}
+
+TEST(BicyclesHeapProfilerTestSuite, SitesAndDumps)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    HeapProfiler& profiler = HeapProfiler::instance();
+    profiler.clear();
+    profiler.start(1); // every allocation is sampled, each standing for itself
+
+    Bicycles bicycles(ssm);
+    Buffer buffer(ssm);
+    parkBicycles(bicycles, 100);
+    reserveBuffer(buffer, 10000);
+    profiler.stop();
+
+    std::vector<HeapProfiler::Site> sites = profiler.getSites();
+    ASSERT_EQ(sites.size(), 2u);
+    // The buffer first, as it has more live bytes:
+    EXPECT_EQ(sites[0].sampledLiveObjects, 1u);
+    EXPECT_EQ(sites[0].sampledLiveBytes, 10000u);
+    EXPECT_NEAR(sites[0].liveBytes, 10000.0, 1.0);
+    EXPECT_EQ(sites[1].sampledLiveObjects, 100u);
+    EXPECT_NEAR(sites[1].liveObjects, 100.0, 0.01);
+    EXPECT_FALSE(sites[1].stack.empty());
+
+    std::ostringstream flat;
+    profiler.write(flat, HeapProfiler::Format::Flat);
+    EXPECT_EQ(flat.str().rfind("Heap profile (sampling every 1 bytes): 2 sites", 0), 0u);
+
+    std::ostringstream pprof;
+    profiler.write(pprof, HeapProfiler::Format::Pprof);
+    std::string header = "heap profile: 101: " + std::to_string(10000 + sites[1].sampledLiveBytes) + " [101: ";
+    EXPECT_EQ(pprof.str().rfind(header, 0), 0u);
+    EXPECT_NE(pprof.str().find("] @ heap_v2/1\n"), std::string::npos);
+    EXPECT_NE(pprof.str().find("\nMAPPED_LIBRARIES:\n"), std::string::npos);
+
+    // Deallocations are accounted for even after sampling stops; the totals stay:
+    bicycles.clear();
+    sites = profiler.getSites();
+    EXPECT_EQ(sites[1].sampledLiveObjects, 0u);
+    EXPECT_NEAR(sites[1].liveBytes, 0.0, 0.01);
+    EXPECT_EQ(sites[1].sampledTotalObjects, 100u);
+
+    profiler.clear();
+    EXPECT_TRUE(profiler.getSites().empty());
+}
+
+TEST(BicyclesHeapProfilerTestSuite, SampledEstimates)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    HeapProfiler& profiler = HeapProfiler::instance();
+    profiler.clear();
+    const size_t interval = 4096;
+    profiler.start(interval);
+
+    // About 1 in 80 of the nodes is sampled, but the estimate is of all of them:
+    Bicycles bicycles(ssm);
+    const int bicyclesNum = 20000;
+    parkBicycles(bicycles, bicyclesNum);
+    profiler.stop();
+
+    std::vector<HeapProfiler::Site> sites = profiler.getSites();
+    ASSERT_EQ(sites.size(), 1u);
+    EXPECT_LT(sites[0].sampledLiveObjects, bicyclesNum / 10);
+    EXPECT_NEAR(sites[0].liveObjects, bicyclesNum, bicyclesNum * 0.2);
+    double nodeSize = static_cast<double>(sites[0].sampledLiveBytes) / sites[0].sampledLiveObjects;
+    EXPECT_NEAR(sites[0].liveBytes, bicyclesNum * nodeSize, bicyclesNum * nodeSize * 0.2);
+
+    bicycles.clear();
+    EXPECT_NEAR(profiler.getSites()[0].liveBytes, 0.0, 1.0);
+    profiler.clear();
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/HugePageSegment.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace testing;
+
+namespace
+{
+    size_t residentPages(const HugePageSegment& seg)
+    {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        std::vector<unsigned char> residency((seg.size() + page - 1) / page);
+        if (0 != mincore(seg.data(), seg.size(), residency.data()))
+        {
+            return 0;
+        }
+        size_t resident = 0;
+        for (unsigned char r : residency)
+        {
+            resident += r & 1;
+        }
+        return resident;
+    }
+}
+
+TEST(BicyclesHugePageSegmentTestSuite, ModesFallBackGracefully)
+{
+    const size_t size = 3 * 1024 * 1024;
+    for (auto mode : {HugePageSegment::PageMode::Regular, HugePageSegment::PageMode::Transparent,
+                      HugePageSegment::PageMode::Explicit})
+    {
+        HugePageSegment seg(size, mode);
+        ASSERT_NE(seg.data(), nullptr);
+        EXPECT_GE(seg.size(), size);
+        EXPECT_LE(seg.getPageMode(), mode); // never more than requested
+        if (seg.getPageMode() != HugePageSegment::PageMode::Regular)
+        {
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(seg.data()) % HugePageSegment::hugePageSize(), 0);
+            EXPECT_EQ(seg.size() % HugePageSegment::hugePageSize(), 0);
+        }
+
+        SimpleSegmentManager ssm(seg.data(), seg.size());
+        char* p = static_cast<char*>(ssm.alloc(size / 2));
+        ASSERT_NE(p, nullptr);
+        std::memset(p, 'x', size / 2);
+        ssm.free(p);
+    }
+    EXPECT_THROW(HugePageSegment(0), std::invalid_argument);
+}
+
+TEST(BicyclesHugePageSegmentTestSuite, Prefault)
+{
+    const size_t size = 4 * 1024 * 1024;
+    for (auto mode : {HugePageSegment::PageMode::Regular, HugePageSegment::PageMode::Transparent})
+    {
+        HugePageSegment lazy(size, mode, false);
+        EXPECT_EQ(residentPages(lazy), 0);
+
+        HugePageSegment prefaulted(size, mode, true);
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        EXPECT_EQ(residentPages(prefaulted), prefaulted.size() / page);
+    }
+}
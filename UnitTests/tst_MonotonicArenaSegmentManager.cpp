@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MonotonicArenaSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorOnStack.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    struct DestructionCounter
+    {
+        DestructionCounter(int& counter, std::vector<int>& order, int id) :
+            mCounter(counter), mOrder(order), mId(id) {}
+        ~DestructionCounter() { mCounter++; mOrder.push_back(mId); }
+
+        int& mCounter;
+        std::vector<int>& mOrder;
+        int mId;
+    };
+}
+
+TEST(BicyclesMonotonicArenaSegmentManagerTestSuite, BumpAllocationAndReset)
+{
+    const size_t segSize = 1024;
+    alignas(std::max_align_t) char seg[segSize];
+    MonotonicArenaSegmentManager arena(seg, segSize);
+
+    char* p1 = static_cast<char*>(arena.alloc(1));
+    char* p2 = static_cast<char*>(arena.alloc(24));
+    char* p3 = static_cast<char*>(arena.alloc(16));
+    ASSERT_NE(p1, nullptr);
+    EXPECT_EQ(p2, p1 + alignof(std::max_align_t));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p3) % alignof(std::max_align_t), 0);
+    EXPECT_GT(p3, p2);
+
+    arena.free(p2); // no-op
+    EXPECT_EQ(arena.alloc(segSize), nullptr);
+    EXPECT_NE(arena.alloc(16), nullptr); // a failed allocation doesn't waste the rest of the arena
+
+    SegmentManagerStats stats = arena.getStats();
+    EXPECT_EQ(stats.allocsNum, 4);
+    EXPECT_EQ(stats.freesNum, 1);
+    EXPECT_EQ(stats.failedAllocsNum, 1);
+    EXPECT_EQ(stats.occupiedBytes, arena.getUsedBytes());
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+
+    arena.reset();
+    EXPECT_EQ(arena.getUsedBytes(), 0);
+    EXPECT_EQ(arena.getStats().peakOccupiedBytes, stats.occupiedBytes);
+    EXPECT_EQ(arena.alloc(segSize), p1);
+}
+
+TEST(BicyclesMonotonicArenaSegmentManagerTestSuite, Realloc)
+{
+    const size_t segSize = 1024;
+    alignas(std::max_align_t) char seg[segSize];
+    MonotonicArenaSegmentManager arena(seg, segSize);
+
+    char* p1 = static_cast<char*>(arena.alloc(32));
+    std::memset(p1, 'a', 32);
+    EXPECT_EQ(arena.realloc(p1, 32, 64), p1); // the top block grows in place
+
+    char* p2 = static_cast<char*>(arena.alloc(16));
+    std::memset(p2, 'b', 16);
+    size_t usedBytes = arena.getUsedBytes();
+    EXPECT_EQ(arena.realloc(p1, 64, 16), p1); // shrinking never moves
+    EXPECT_EQ(arena.getUsedBytes(), usedBytes);
+
+    // p1 isn't the top block any more: it moves, taking along its own bytes only
+    char* moved = static_cast<char*>(arena.realloc(p1, 16, 128));
+    ASSERT_NE(moved, nullptr);
+    EXPECT_NE(moved, p1);
+    EXPECT_EQ(std::string(moved, 16), std::string(16, 'a'));
+    EXPECT_EQ(std::string(p2, 16), std::string(16, 'b'));
+    EXPECT_EQ(arena.realloc(moved, 128, segSize), nullptr);
+}
+
+TEST(BicyclesMonotonicArenaSegmentManagerTestSuite, DestructorRegistry)
+{
+    const size_t segSize = 1024;
+    alignas(std::max_align_t) char seg[segSize];
+    int destroyed = 0;
+    std::vector<int> order;
+
+    {
+        MonotonicArenaSegmentManager arena(seg, segSize);
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_NE(arena.create<DestructionCounter>(destroyed, order, i), nullptr);
+        }
+
+        // Trivially destructible objects don't need a registry entry:
+        size_t usedBefore = arena.getUsedBytes();
+        int* i = arena.create<int>(42);
+        ASSERT_NE(i, nullptr);
+        EXPECT_EQ(*i, 42);
+        EXPECT_EQ(arena.getUsedBytes() - usedBefore, alignof(std::max_align_t));
+
+        arena.reset();
+        EXPECT_EQ(destroyed, 3);
+        EXPECT_EQ(order, std::vector<int>({2, 1, 0}));
+
+        ASSERT_NE(arena.create<DestructionCounter>(destroyed, order, 3), nullptr);
+    }
+    // The rest is destroyed along with the arena:
+    EXPECT_EQ(destroyed, 4);
+}
+
+TEST(BicyclesMonotonicArenaSegmentManagerTestSuite, Containers)
+{
+    constexpr size_t SEG_SIZE = 8192;
+    constexpr int num = 16;
+
+    {
+        using MyBicyclesAllocator = MyAllocatorOnStack<BicycleImpl, SEG_SIZE, MonotonicArenaSegmentManager>;
+        std::vector<BicycleImpl, MyBicyclesAllocator> vec;
+        for (int i = 0; i < num; i++)
+        {
+            vec.push_back({"Bicycle-V-" + std::to_string(i)});
+        }
+        for (int i = 0; i < num; i++)
+        {
+            EXPECT_EQ(vec[i].getVendor(), "Bicycle-V-" + std::to_string(i));
+        }
+    }
+
+    {
+        using MyBicyclesPairAllocator = MyAllocatorNonOwning<std::pair<const int, BicycleImpl>, MonotonicArenaSegmentManager>;
+        std::vector<char> seg(SEG_SIZE);
+        SharedPtr<MonotonicArenaSegmentManager> arena = makeShared<MonotonicArenaSegmentManager>(seg.data(), SEG_SIZE);
+        MyBicyclesPairAllocator myal(arena);
+
+        for (int round = 0; round < 3; round++)
+        {
+            {
+                std::map<int, BicycleImpl, std::less<int>, MyBicyclesPairAllocator> mp(myal);
+                for (int i = 0; i < num; i++)
+                {
+                    mp.emplace(i, BicycleImpl("Bicycle-M-" + std::to_string(i)));
+                }
+                EXPECT_EQ(mp.at(num - 1).getVendor(), "Bicycle-M-" + std::to_string(num - 1));
+            }
+            EXPECT_GT(arena->getUsedBytes(), 0);
+            arena->reset();
+        }
+    }
+}
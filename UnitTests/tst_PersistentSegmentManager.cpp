@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/MappedFileSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/PersistentSegmentManager.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const char* HEAP_PATH = "tst_PersistentSegmentManager.heap";
+
+    struct Node
+    {
+        int value;
+        Node* next;
+    };
+}
+
+TEST(BicyclesPersistentSegmentManagerTestSuite, AllocFreeCoalesce)
+{
+    const size_t segSize = 4096;
+    alignas(16) char seg[segSize];
+    PersistentSegmentManager psm(seg, segSize);
+    EXPECT_FALSE(psm.isRestored());
+    const size_t initialFree = psm.getStats().freeBytes;
+
+    char* p1 = static_cast<char*>(psm.alloc(100));
+    char* p2 = static_cast<char*>(psm.alloc(1));
+    char* p3 = static_cast<char*>(psm.alloc(200, 256));
+    ASSERT_NE(p1, nullptr);
+    ASSERT_NE(p2, nullptr);
+    ASSERT_NE(p3, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p3) % 256, 0);
+    EXPECT_EQ(psm.alloc(segSize), nullptr);
+
+    EXPECT_TRUE(psm.tryExpand(p3, 400));
+    psm.shrink(p3, 16);
+    char* p4 = static_cast<char*>(psm.realloc(p2, 1000));
+    ASSERT_NE(p4, nullptr);
+
+    psm.free(p1);
+    EXPECT_THROW(psm.free(p1), std::runtime_error);
+    EXPECT_THROW(psm.free(nullptr), std::invalid_argument);
+    EXPECT_THROW(psm.free(seg + segSize), std::runtime_error);
+    psm.free(p3);
+    psm.free(p4);
+
+    SegmentManagerStats stats = psm.getStats();
+    EXPECT_EQ(stats.freeBytes, initialFree);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+    EXPECT_EQ(stats.allocsNum, 4);
+    EXPECT_EQ(stats.freesNum, 4); // including the one made by realloc()
+    EXPECT_EQ(stats.failedAllocsNum, 1);
+    EXPECT_EQ(psm.alloc(segSize - PersistentSegmentManager::HEADER_SIZE - 16), seg + PersistentSegmentManager::HEADER_SIZE + 16);
+}
+
+TEST(BicyclesPersistentSegmentManagerTestSuite, RestoreRelocated)
+{
+    const size_t segSize = 4096;
+    alignas(16) char seg[segSize];
+    alignas(16) char movedSeg[segSize];
+    char* kept = nullptr;
+    {
+        PersistentSegmentManager psm(seg, segSize);
+        kept = static_cast<char*>(psm.alloc(64));
+        std::strcpy(kept, "persistent");
+        psm.free(psm.alloc(32)); // leaves a hole
+        psm.setRoot(kept);
+        EXPECT_THROW(psm.setRoot(movedSeg), std::runtime_error);
+    }
+    EXPECT_EQ(PersistentSegmentManager::formattedAt(seg, segSize), seg);
+    std::memcpy(movedSeg, seg, segSize);
+
+    PersistentSegmentManager psm(movedSeg, segSize);
+    EXPECT_TRUE(psm.isRestored());
+    EXPECT_TRUE(psm.isRelocated());
+    char* root = static_cast<char*>(psm.getRoot());
+    EXPECT_EQ(root, movedSeg + (kept - seg));
+    EXPECT_STREQ(root, "persistent");
+
+    SegmentManagerStats stats = psm.getStats();
+    EXPECT_EQ(stats.allocsNum, 2);
+    EXPECT_EQ(stats.freesNum, 1);
+    psm.free(root);
+    EXPECT_EQ(psm.getStats().freeBlocksNum, 1);
+
+    // Too small a segment can't hold the heap stored in it:
+    EXPECT_THROW(PersistentSegmentManager(movedSeg, segSize / 2), std::runtime_error);
+}
+
+TEST(BicyclesPersistentSegmentManagerTestSuite, MappedFileReopen)
+{
+    const size_t segSize = 1024 * 1024;
+    const int nodesNum = 10000;
+    std::remove(HEAP_PATH);
+    {
+        SharedPtr<MappedFileSegmentManager> manager = makeShared<MappedFileSegmentManager>(HEAP_PATH, segSize);
+        EXPECT_FALSE(manager->isRestored());
+        MyAllocatorNonOwning<Node, MappedFileSegmentManager> myal(manager);
+
+        Node* head = nullptr;
+        for (int i = 0; i < nodesNum; i++)
+        {
+            Node* node = myal.allocate(1);
+            *node = Node{i, head};
+            head = node;
+        }
+        manager->setRoot(head);
+        EXPECT_TRUE(manager->sync());
+    }
+    {
+        SharedPtr<MappedFileSegmentManager> manager = makeShared<MappedFileSegmentManager>(HEAP_PATH, segSize);
+        ASSERT_TRUE(manager->isRestored());
+        ASSERT_FALSE(manager->isRelocated());
+        MyAllocatorNonOwning<Node, MappedFileSegmentManager> myal(manager);
+
+        int expected = nodesNum - 1;
+        Node* node = static_cast<Node*>(manager->getRoot());
+        while (node != nullptr)
+        {
+            EXPECT_EQ(node->value, expected--);
+            Node* next = node->next;
+            myal.deallocate(node, 1);
+            node = next;
+        }
+        EXPECT_EQ(expected, -1);
+        manager->setRoot(nullptr);
+
+        SegmentManagerStats stats = manager->getStats();
+        EXPECT_EQ(stats.allocsNum, nodesNum);
+        EXPECT_EQ(stats.freesNum, nodesNum);
+        EXPECT_EQ(stats.freeBlocksNum, 1);
+    }
+    std::remove(HEAP_PATH);
+}
+
+TEST(BicyclesPersistentSegmentManagerTestSuite, OwnerDeathBeforeExclusiveReopen)
+{
+    const size_t segSize = 256 * 1024;
+    std::remove(HEAP_PATH);
+    size_t segmentBytes = 0;
+    {
+        // Fragment the first half of the heap, so that the child's allocs walk a long free list to get
+        // to the free tail: then it's likely to be killed holding the lock, inside alloc()
+        MappedFileSegmentManager manager(HEAP_PATH, segSize);
+        segmentBytes = manager.getStats().segmentBytes;
+        std::vector<void*> blocks;
+        while (manager.getStats().occupiedBytes < segmentBytes / 2)
+        {
+            blocks.push_back(manager.alloc(16));
+        }
+        for (size_t i = 0; i < blocks.size(); i += 2)
+        {
+            manager.free(blocks[i]);
+        }
+    }
+
+    for (int round = 0; round < 20; round++)
+    {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (0 == child)
+        {
+            MappedFileSegmentManager childManager(HEAP_PATH, segSize);
+            for (;;)
+            {
+                childManager.free(childManager.alloc(64)); // only fits in the tail
+            }
+        }
+        usleep(1000 + round * 500);
+        kill(child, SIGKILL);
+        int status = 0;
+        waitpid(child, &status, 0);
+        ASSERT_TRUE(WIFSIGNALED(status));
+
+        // Reopening re-initializes the dead child's lock, but the heap is still checked: it's usable &
+        // its statistics match the free list, whatever the child was doing
+        MappedFileSegmentManager manager(HEAP_PATH, segSize);
+        ASSERT_TRUE(manager.isRestored());
+        SegmentManagerStats stats = manager.getStats();
+        EXPECT_EQ(stats.freeBytes + stats.occupiedBytes, segmentBytes);
+        EXPECT_LE(stats.largestFreeBlockBytes, stats.freeBytes);
+        void* block = manager.alloc(stats.largestFreeBlockBytes - 16); // -16 its CB
+        ASSERT_NE(block, nullptr);
+        manager.free(block);
+    }
+    std::remove(HEAP_PATH);
+}
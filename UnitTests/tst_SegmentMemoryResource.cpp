@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/FixedBlockSegmentManager.hpp"
+#include "MemoryManagement/SegmentMemoryResource.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    const size_t SEG_SIZE = 1024 * 1024;
+
+    // The same container type whichever segment manager is behind the resource
+    void parkBicycles(std::pmr::vector<BicycleImpl>& bicycles, int num)
+    {
+        for (int i = 0; i < num; i++)
+        {
+            bicycles.emplace_back("Bicycle", i, i);
+        }
+    }
+}
+
+TEST(BicyclesMemoryResourceTestSuite, RuntimeChoiceOfSegmentManager)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SegmentMemoryResource<SimpleSegmentManager> simple(makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE));
+    std::unique_ptr<char[]> smallSeg(new char[SEG_SIZE]);
+    SegmentMemoryResource<SmallObjectSegmentManager> small(
+                makeShared<SmallObjectSegmentManager>(smallSeg.get(), SEG_SIZE));
+    SegmentMemoryResource<DummySegmentManager> heap(makeShared<DummySegmentManager>(nullptr, 0, false));
+
+    for (std::pmr::memory_resource* resource : {static_cast<std::pmr::memory_resource*>(&simple),
+                                                static_cast<std::pmr::memory_resource*>(&small),
+                                                static_cast<std::pmr::memory_resource*>(&heap)})
+    {
+        std::pmr::vector<BicycleImpl> bicycles(resource);
+        parkBicycles(bicycles, 100);
+        EXPECT_EQ(bicycles.back().getPressureRear(), 99);
+    }
+
+    // Every allocation went to its segment manager, and was given back:
+    for (const SegmentManagerStats& stats : {simple.getStats(), small.getStats(), heap.getStats()})
+    {
+        EXPECT_GT(stats.allocsNum, 0u);
+        EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    }
+
+    // Node containers too, with the segment manager's sized free:
+    std::pmr::list<int> ints({1, 2, 3}, &small);
+    EXPECT_EQ(small.getStats().allocsNum - small.getStats().freesNum, 3u);
+}
+
+TEST(BicyclesMemoryResourceTestSuite, Alignment)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    SegmentMemoryResource<SimpleSegmentManager> simple(makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE));
+    SegmentMemoryResource<DummySegmentManager> heap(makeShared<DummySegmentManager>(nullptr, 0, false));
+
+    for (std::pmr::memory_resource* resource : {static_cast<std::pmr::memory_resource*>(&simple),
+                                                static_cast<std::pmr::memory_resource*>(&heap)})
+    {
+        for (size_t alignment : {size_t(1), size_t(8), size_t(64), size_t(4096)})
+        {
+            void* mem = resource->allocate(100, alignment);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(mem) % alignment, 0u);
+            resource->deallocate(mem, 100, alignment);
+        }
+    }
+
+    // A segment manager which can't align that strictly fails like any memory_resource does
+    std::unique_ptr<char[]> blocksSeg(new char[SEG_SIZE]);
+    SegmentMemoryResource<FixedBlockSegmentManager<64>> blocks(
+                makeShared<FixedBlockSegmentManager<64>>(blocksSeg.get(), SEG_SIZE));
+    EXPECT_THROW(static_cast<void>(blocks.allocate(64, 128)), std::bad_alloc);
+    EXPECT_THROW(static_cast<void>(blocks.allocate(128)), std::bad_alloc);
+}
+
+TEST(BicyclesMemoryResourceTestSuite, Exhaustion)
+{
+    const size_t segSize = 4096;
+    char seg[segSize];
+    SegmentMemoryResource<SimpleSegmentManager> simple(makeShared<SimpleSegmentManager>(seg, segSize));
+    std::pmr::vector<char> buffer(&simple);
+    EXPECT_THROW(buffer.reserve(2 * segSize), std::bad_alloc);
+    EXPECT_EQ(simple.getStats().failedAllocsNum, 1u);
+}
+
+TEST(BicyclesMemoryResourceTestSuite, Equality)
+{
+    std::unique_ptr<char[]> seg(new char[SEG_SIZE]);
+    auto ssm = makeShared<SimpleSegmentManager>(seg.get(), SEG_SIZE);
+    SegmentMemoryResource<SimpleSegmentManager> resource1(ssm);
+    SegmentMemoryResource<SimpleSegmentManager> resource2(ssm);
+    std::unique_ptr<char[]> otherSeg(new char[SEG_SIZE]);
+    SegmentMemoryResource<SimpleSegmentManager> other(makeShared<SimpleSegmentManager>(otherSeg.get(), SEG_SIZE));
+
+    // Memory from one resource over a segment manager can be given back through another one over it
+    EXPECT_TRUE(resource1 == resource2);
+    EXPECT_TRUE(resource1 != other);
+    EXPECT_TRUE(resource1 != *std::pmr::new_delete_resource());
+
+    // ...which lets containers move their buffers between them instead of their elements
+    std::pmr::vector<BicycleImpl> bicycles(&resource1);
+    parkBicycles(bicycles, 10);
+    const BicycleImpl* data = bicycles.data();
+    std::pmr::vector<BicycleImpl> moved(std::move(bicycles), &resource2);
+    EXPECT_EQ(moved.data(), data);
+    std::pmr::vector<BicycleImpl> copied(std::move(moved), &other);
+    EXPECT_NE(copied.data(), data);
+    EXPECT_EQ(copied.size(), 10u);
+}
@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/RobustMutex.hpp"
+#include "MemoryManagement/SharedMemorySegmentManager.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace testing;
+
+namespace
+{
+    std::string shmName()
+    {
+        return "/mybicycles_tst_" + std::to_string(getpid());
+    }
+
+    // A table kept in shared memory: the rows are referenced by offsets, as every process has its own mapping
+    struct Table
+    {
+        size_t rowsNum;
+        size_t rowOffsets[8];
+    };
+
+    // Random allocs & frees, checking nobody else scribbles over our blocks. Returns the number of failures.
+    int stress(SharedMemorySegmentManager& manager, unsigned seed, int iterations)
+    {
+        struct Block
+        {
+            unsigned char* addr;
+            size_t size;
+            unsigned char pattern;
+        };
+        std::vector<Block> blocks;
+        int failures = 0;
+        std::srand(seed);
+
+        auto release = [&](size_t i) {
+            for (size_t j = 0; j < blocks[i].size; j++)
+            {
+                failures += blocks[i].addr[j] != blocks[i].pattern;
+            }
+            manager.free(blocks[i].addr);
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+        };
+
+        for (int i = 0; i < iterations; i++)
+        {
+            if (!blocks.empty() && (blocks.size() > 64 || std::rand() % 2))
+            {
+                release(std::rand() % blocks.size());
+                continue;
+            }
+            size_t size = 1 + std::rand() % 512;
+            unsigned char* addr = static_cast<unsigned char*>(manager.alloc(size));
+            if (addr != nullptr)
+            {
+                unsigned char pattern = static_cast<unsigned char>(seed + i);
+                std::memset(addr, pattern, size);
+                blocks.push_back(Block{addr, size, pattern});
+            }
+        }
+        while (!blocks.empty())
+        {
+            release(0);
+        }
+        return failures;
+    }
+}
+
+TEST(BicyclesSharedMemorySegmentManagerTestSuite, RobustMutexOwnerDeath)
+{
+    void* mem = mmap(nullptr, sizeof(RobustMutex), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mem, MAP_FAILED);
+    RobustMutex* mutex = static_cast<RobustMutex*>(mem);
+    mutex->init();
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (0 == child)
+    {
+        mutex->lock();
+        _exit(0); // dies holding the mutex
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    EXPECT_FALSE(mutex->lock()); // taken over from the dead owner
+    mutex->unlock();
+    EXPECT_TRUE(mutex->lock()); // and usable as usual afterwards
+    mutex->unlock();
+    munmap(mem, sizeof(RobustMutex));
+}
+
+TEST(BicyclesSharedMemorySegmentManagerTestSuite, RootAndOffsetsAcrossProcesses)
+{
+    const std::string name = shmName();
+    SharedMemorySegmentManager::remove(name);
+    SharedMemorySegmentManager manager(name, 64 * 1024);
+
+    Table* table = static_cast<Table*>(manager.alloc(sizeof(Table)));
+    table->rowsNum = 0;
+    manager.setRoot(table);
+
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (0 == child)
+    {
+        // A mapping of our own, at another address than the inherited one:
+        SharedMemorySegmentManager childManager(name, 0);
+        Table* childTable = static_cast<Table*>(childManager.getRoot());
+        bool ok = childTable != nullptr && childTable != table;
+        for (size_t i = 0; ok && i < 8; i++)
+        {
+            char* row = static_cast<char*>(childManager.alloc(32));
+            ok = row != nullptr;
+            if (ok)
+            {
+                std::strcpy(row, ("row " + std::to_string(i)).c_str());
+                childTable->rowOffsets[i] = childManager.toOffset(row);
+                childTable->rowsNum++;
+            }
+        }
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    ASSERT_EQ(table->rowsNum, 8);
+    for (size_t i = 0; i < table->rowsNum; i++)
+    {
+        char* row = static_cast<char*>(manager.fromOffset(table->rowOffsets[i]));
+        EXPECT_STREQ(row, ("row " + std::to_string(i)).c_str());
+        manager.free(row);
+    }
+    manager.free(table);
+    EXPECT_EQ(manager.getStats().freeBlocksNum, 1);
+    EXPECT_TRUE(SharedMemorySegmentManager::remove(name));
+}
+
+TEST(BicyclesSharedMemorySegmentManagerTestSuite, MultiProcessStress)
+{
+    const std::string name = shmName();
+    const int processesNum = 4;
+    const int iterations = 20000;
+    SharedMemorySegmentManager::remove(name);
+    SharedMemorySegmentManager manager(name, 256 * 1024);
+    const size_t initialFree = manager.getStats().freeBytes;
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < processesNum; p++)
+    {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (0 == child)
+        {
+            SharedMemorySegmentManager childManager(name, 0);
+            _exit(stress(childManager, p + 1, iterations) == 0 ? 0 : 1);
+        }
+        children.push_back(child);
+    }
+    EXPECT_EQ(stress(manager, 0, iterations), 0); // the parent takes part too
+
+    for (pid_t child : children)
+    {
+        int status = 0;
+        waitpid(child, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+
+    SegmentManagerStats stats = manager.getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    EXPECT_EQ(stats.freeBytes, initialFree);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+    EXPECT_TRUE(SharedMemorySegmentManager::remove(name));
+}
+
+TEST(BicyclesSharedMemorySegmentManagerTestSuite, OwnerDeathMidAlloc)
+{
+    const std::string name = shmName();
+    SharedMemorySegmentManager::remove(name);
+    SharedMemorySegmentManager manager(name, 256 * 1024);
+    const size_t segmentBytes = manager.getStats().segmentBytes;
+
+    // Fragment the first half of the heap, so that the children's allocs walk a long free list
+    // to get to the free tail: then they're likely to be killed holding the lock, inside alloc()
+    std::vector<void*> blocks;
+    while (manager.getStats().occupiedBytes < segmentBytes / 2)
+    {
+        blocks.push_back(manager.alloc(16));
+    }
+    for (size_t i = 0; i < blocks.size(); i += 2)
+    {
+        manager.free(blocks[i]);
+    }
+
+    for (int round = 0; round < 20; round++)
+    {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (0 == child)
+        {
+            SharedMemorySegmentManager childManager(name, 0);
+            for (;;)
+            {
+                childManager.free(childManager.alloc(64)); // only fits in the tail
+            }
+        }
+        usleep(1000 + round * 500);
+        kill(child, SIGKILL);
+        int status = 0;
+        waitpid(child, &status, 0);
+        ASSERT_TRUE(WIFSIGNALED(status));
+
+        // The heap is usable & its statistics match the free list, whatever the child was doing:
+        SegmentManagerStats stats = manager.getStats();
+        EXPECT_EQ(stats.freeBytes + stats.occupiedBytes, segmentBytes);
+        EXPECT_LE(stats.largestFreeBlockBytes, stats.freeBytes);
+        void* block = manager.alloc(stats.largestFreeBlockBytes - 16); // -16 its CB
+        ASSERT_NE(block, nullptr);
+        manager.free(block);
+    }
+    EXPECT_TRUE(SharedMemorySegmentManager::remove(name));
+}
@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/DummySegmentManager.hpp"
+#include "MemoryManagement/MmapSegment.hpp"
+#include "MemoryManagement/MonotonicArenaSegmentManager.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SimpleSegmentManager.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+using namespace testing;
+using namespace mybicycles;
+
+namespace
+{
+    bool isAligned(const void* p, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+    }
+
+    // What the kernel says about the pages of [@addr, @addr + @pagesNum pages)
+    size_t residentPagesNum(char* addr, size_t pagesNum)
+    {
+        std::vector<unsigned char> residency(pagesNum);
+        if (0 != mincore(addr, pagesNum * MmapSegment::pageSize(), residency.data()))
+        {
+            return SIZE_MAX;
+        }
+        size_t residentNum = 0;
+        for (unsigned char page : residency)
+        {
+            residentNum += page & 1;
+        }
+        return residentNum;
+    }
+
+    struct alignas(64) CacheLinePaddedCounter
+    {
+        uint64_t value = 0;
+    };
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, AlignedAlloc)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    SimpleSegmentManager ssm(seg.data(), segSize);
+
+    std::vector<void*> blocks;
+    for (size_t alignment : {16, 32, 64, 128, 4096, 64, 16})
+    {
+        void* p = ssm.alloc(40, alignment);
+        ASSERT_NE(p, nullptr);
+        EXPECT_TRUE(isAligned(p, alignment)) << alignment;
+        blocks.push_back(p);
+    }
+
+    EXPECT_EQ(ssm.alloc(16, 48), nullptr); // not a power of 2
+
+    for (void* p : blocks)
+    {
+        ssm.free(p);
+    }
+    // The gaps skipped for alignment were kept free and everything got merged back:
+    void* whole = ssm.alloc(segSize - 64);
+    EXPECT_NE(whole, nullptr);
+    ssm.free(whole);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, AlignmentGapsAreReused)
+{
+    const size_t segSize = 16 * 1024;
+    alignas(4096) static char seg[segSize];
+    SimpleSegmentManager ssm(seg, segSize);
+
+    // The first page-aligned block leaves most of the first page free...
+    void* aligned = ssm.alloc(64, 4096);
+    ASSERT_NE(aligned, nullptr);
+    EXPECT_EQ(aligned, seg + 4096);
+
+    // ... and that's where subsequent small blocks go:
+    void* small = ssm.alloc(64);
+    ASSERT_NE(small, nullptr);
+    EXPECT_LT(small, aligned);
+
+    ssm.free(small);
+    ssm.free(aligned);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, OverAlignedTypesInContainers)
+{
+    const size_t segSize = 16 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<CacheLinePaddedCounter> myal(ssm);
+    std::vector<CacheLinePaddedCounter, MyAllocatorNonOwning<CacheLinePaddedCounter>> counters(myal);
+
+    for (int i = 0; i < 32; i++)
+    {
+        counters.emplace_back();
+        EXPECT_TRUE(isAligned(counters.data(), alignof(CacheLinePaddedCounter)));
+    }
+
+    SharedPtr<DummySegmentManager> dsm = makeShared<DummySegmentManager>(nullptr, 0, false);
+    MyAllocatorNonOwning<CacheLinePaddedCounter, DummySegmentManager> myal2(dsm);
+    CacheLinePaddedCounter* c = myal2.allocate(3);
+    EXPECT_TRUE(isAligned(c, alignof(CacheLinePaddedCounter)));
+    myal2.deallocate(c, 3);
+
+    MonotonicArenaSegmentManager arena(seg.data(), segSize);
+    arena.alloc(8);
+    EXPECT_TRUE(isAligned(arena.alloc(8, 256), 256));
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, ResizeInPlace)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    SimpleSegmentManager ssm(seg.data(), segSize);
+
+    char* p = static_cast<char*>(ssm.alloc(32));
+    ASSERT_NE(p, nullptr);
+    EXPECT_TRUE(ssm.tryExpand(p, 32)); // fits already
+    EXPECT_TRUE(ssm.tryExpand(p, 1024));
+    EXPECT_GE(SimpleSegmentManager::usableSize(p), 1024);
+
+    void* q = ssm.alloc(32); // right after p's block now
+    ASSERT_NE(q, nullptr);
+    EXPECT_GT(q, (void*)(p + 1024));
+    EXPECT_FALSE(ssm.tryExpand(p, 2048));
+    EXPECT_EQ(SimpleSegmentManager::usableSize(p), 1024);
+
+    // Shrinking frees the tail, and the next small block lands there:
+    ssm.shrink(p, 64);
+    EXPECT_EQ(SimpleSegmentManager::usableSize(p), 64);
+    void* r = ssm.alloc(32);
+    EXPECT_GT(r, (void*)p);
+    EXPECT_LT(r, q);
+
+    // realloc keeps the contents when it has to move the block:
+    std::memset(p, 'x', 64);
+    char* moved = static_cast<char*>(ssm.realloc(p, 2048));
+    ASSERT_NE(moved, nullptr);
+    EXPECT_NE(moved, p);
+    EXPECT_EQ(moved[0], 'x');
+    EXPECT_EQ(moved[63], 'x');
+    EXPECT_EQ(ssm.realloc(moved, segSize), nullptr);
+
+    ssm.free(moved);
+    ssm.free(r);
+    ssm.free(q);
+    EXPECT_NE(ssm.alloc(segSize - 64), nullptr);
+
+    EXPECT_THROW(ssm.tryExpand(nullptr, 16), std::invalid_argument);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, Stats)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    SharedPtr<SimpleSegmentManager> ssm = makeShared<SimpleSegmentManager>(seg.data(), segSize);
+
+    SegmentManagerStats stats = ssm->getStats();
+    EXPECT_EQ(stats.segmentBytes, segSize);
+    EXPECT_EQ(stats.freeBytes + stats.occupiedBytes, segSize);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+    EXPECT_EQ(stats.largestFreeBlockBytes, stats.freeBytes);
+    EXPECT_EQ(stats.fragmentation, 0.0);
+    EXPECT_EQ(stats.allocsNum, 0);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 8; i++)
+    {
+        blocks.push_back(ssm->alloc(100));
+    }
+    EXPECT_EQ(ssm->alloc(segSize), nullptr);
+    // Free every other block to punch holes:
+    for (int i = 0; i < 8; i += 2)
+    {
+        ssm->free(blocks[i]);
+    }
+
+    stats = ssm->getStats();
+    EXPECT_EQ(stats.allocsNum, 8);
+    EXPECT_EQ(stats.freesNum, 4);
+    EXPECT_EQ(stats.failedAllocsNum, 1);
+    EXPECT_EQ(stats.freeBytes + stats.occupiedBytes, segSize);
+    EXPECT_EQ(stats.freeBlocksNum, 5); // 4 holes + the tail
+    EXPECT_LT(stats.largestFreeBlockBytes, stats.freeBytes);
+    EXPECT_GT(stats.fragmentation, 0.0);
+    EXPECT_LT(stats.fragmentation, 1.0);
+    EXPECT_EQ(stats.peakOccupiedBytes, stats.occupiedBytes + 4 * 128);
+    EXPECT_EQ(stats.freeBlocksHistogram[3], 4); // 128-byte holes
+    size_t histogramTotal = 0;
+    for (size_t count : stats.freeBlocksHistogram)
+    {
+        histogramTotal += count;
+    }
+    EXPECT_EQ(histogramTotal, stats.freeBlocksNum);
+
+    // The allocators see the same statistics:
+    MyAllocatorNonOwning<int> myal(ssm);
+    EXPECT_EQ(myal.getStats().allocsNum, stats.allocsNum);
+    EXPECT_EQ(MyAllocatorNonOwning<int>().getStats().segmentBytes, 0);
+
+    for (int i = 1; i < 8; i += 2)
+    {
+        ssm->free(blocks[i]);
+    }
+    stats = ssm->getStats();
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+    EXPECT_EQ(stats.fragmentation, 0.0);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, BatchAllocFree)
+{
+    const size_t segSize = 4096;
+    alignas(16) char seg[segSize];
+    SimpleSegmentManager ssm(seg, segSize);
+    const SegmentManagerStats initial = ssm.getStats();
+
+    // Make a hole at the front, so the batch is carved from two free blocks:
+    void* front[3];
+    for (auto& p : front)
+    {
+        p = ssm.alloc(16);
+    }
+    void* guard = ssm.alloc(16);
+    for (auto& p : front)
+    {
+        ssm.free(p);
+    }
+
+    void* blocks[10];
+    ASSERT_EQ(ssm.allocBatch(10, 20, blocks), 10);
+    // The hole of 3 * 32 bytes fits exactly 2 blocks of 32 bytes (20 rounded up) + CB; the rest follow the guard
+    const size_t stride = 32 + SimpleSegmentManager::BLOCK_OVERHEAD;
+    EXPECT_EQ(blocks[0], front[0]);
+    EXPECT_EQ(static_cast<char*>(blocks[1]), static_cast<char*>(blocks[0]) + stride);
+    EXPECT_GT(blocks[2], guard);
+    for (size_t i = 3; i < 10; i++)
+    {
+        EXPECT_EQ(static_cast<char*>(blocks[i]), static_cast<char*>(blocks[i - 1]) + stride);
+        EXPECT_GE(SimpleSegmentManager::usableSize(blocks[i]), 20);
+    }
+    EXPECT_EQ(ssm.getStats().allocsNum, 4 + 10);
+
+    std::swap(blocks[0], blocks[9]); // the order doesn't matter
+    ssm.freeBatch(blocks, 10);
+    ssm.free(guard);
+    SegmentManagerStats stats = ssm.getStats();
+    EXPECT_EQ(stats.freeBytes, initial.freeBytes);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+    EXPECT_EQ(stats.freesNum, 3 + 10 + 1);
+
+    // Running out of memory, a batch is cut short:
+    std::vector<void*> many(segSize / 32);
+    size_t allocated = ssm.allocBatch(many.size(), 16, many.data());
+    EXPECT_LT(allocated, many.size());
+    EXPECT_EQ(ssm.getStats().freeBytes, 0);
+    EXPECT_EQ(ssm.getStats().failedAllocsNum, 1);
+
+    // Bad pointers throw, the ones before them being freed:
+    void* bad[2] = {many[0], many[0]};
+    EXPECT_THROW(ssm.freeBatch(bad, 2), std::runtime_error);
+    ssm.freeBatch(many.data() + 1, allocated - 1);
+    EXPECT_EQ(ssm.getStats().freeBytes, initial.freeBytes);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, PurgeFreePages)
+{
+    const size_t page = MmapSegment::pageSize();
+    const size_t pagesNum = 64;
+    MmapSegment seg(pagesNum * page, pagesNum * page);
+    SimpleSegmentManager ssm(seg.data(), pagesNum * page);
+    ssm.setPurging(SimpleSegmentManager::PurgeMode::DontNeed, std::chrono::milliseconds(0)); // right away
+
+    char* kept = static_cast<char*>(ssm.alloc(100));
+    char* large = static_cast<char*>(ssm.alloc(32 * page));
+    ASSERT_NE(large, nullptr);
+    std::strcpy(kept, "kept");
+    std::memset(large, 'x', 32 * page);
+    EXPECT_EQ(residentPagesNum(seg.data(), pagesNum), pagesNum - 31); // the free tail is untouched
+    SegmentManagerStats stats = ssm.getStats();
+    EXPECT_EQ(stats.residentBytes, stats.committedBytes);
+    EXPECT_EQ(stats.committedBytes, pagesNum * page);
+
+    // The whole pages of the free block (merged with the free tail) go back to the OS, its CB's page stays:
+    ssm.free(large);
+    EXPECT_EQ(residentPagesNum(seg.data(), pagesNum), 1u);
+    stats = ssm.getStats();
+    EXPECT_EQ(stats.committedBytes - stats.residentBytes, (pagesNum - 1) * page);
+    EXPECT_STREQ(kept, "kept");
+
+    // Reusable as usual; purged pages read as zeros until written to:
+    char* again = static_cast<char*>(ssm.alloc(32 * page));
+    ASSERT_EQ(again, large);
+    EXPECT_EQ(again[16 * page], 0);
+    std::memset(again, 'y', 32 * page);
+    stats = ssm.getStats();
+    // The blocks take the first 33 pages, the rest of the free tail stays purged:
+    EXPECT_EQ(stats.committedBytes - stats.residentBytes, (pagesNum - 33) * page);
+    EXPECT_EQ(residentPagesNum(seg.data(), pagesNum), 33u);
+    ssm.free(again);
+    ssm.free(kept);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, PurgeDecay)
+{
+    const size_t page = MmapSegment::pageSize();
+    const size_t pagesNum = 256;
+    MmapSegment seg(pagesNum * page, pagesNum * page);
+    SimpleSegmentManager ssm(seg.data(), pagesNum * page);
+    const auto decayTime = std::chrono::milliseconds(200);
+    ssm.setPurging(SimpleSegmentManager::PurgeMode::DontNeed, decayTime);
+
+    char* spike = static_cast<char*>(ssm.alloc(128 * page));
+    std::memset(spike, 's', 128 * page);
+    ssm.free(spike);
+    auto churn = [&ssm]() {
+        for (size_t i = 0; i < SimpleSegmentManager::PURGE_TICK_FREES; i++)
+        {
+            ssm.free(ssm.alloc(64));
+        }
+    };
+
+    // Right after the spike, the pages it freed are mostly allowed to stay resident...
+    churn();
+    SegmentManagerStats stats = ssm.getStats();
+    EXPECT_LT(stats.committedBytes - stats.residentBytes, 64 * page);
+
+    // ...but not once the decay time has passed:
+    std::this_thread::sleep_for(decayTime + decayTime / 2);
+    churn();
+    stats = ssm.getStats();
+    EXPECT_GE(stats.committedBytes - stats.residentBytes, (pagesNum - 2) * page);
+    EXPECT_LE(residentPagesNum(seg.data(), pagesNum), 2u);
+
+    // An explicit purge doesn't wait for the decay; MADV_FREE pages might stay resident for a while:
+    ssm.setPurging(SimpleSegmentManager::PurgeMode::Free);
+    char* block = static_cast<char*>(ssm.alloc(128 * page));
+    std::memset(block, 'b', 128 * page);
+    ssm.free(block);
+    EXPECT_GE(ssm.purge(), 127 * page);
+    block = static_cast<char*>(ssm.alloc(128 * page));
+    std::memset(block, 'c', 128 * page);
+    EXPECT_EQ(block[100 * page], 'c');
+    ssm.free(block);
+}
+
+TEST(BicyclesSimpleSegmentManagerTestSuite, TryFree)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    SimpleSegmentManager ssm(seg.data(), segSize);
+    char foreign[64];
+
+    void* block = ssm.alloc(100);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(ssm.tryFree(nullptr), AllocError::NullPointer);
+    EXPECT_EQ(ssm.tryFree(foreign), AllocError::InvalidPointer);
+    EXPECT_EQ(ssm.tryFree(static_cast<char*>(block) + 1), AllocError::InvalidPointer);
+    EXPECT_EQ(ssm.getStats().freesNum, 0);
+
+    EXPECT_EQ(ssm.tryFree(block), AllocError::None);
+    EXPECT_EQ(ssm.tryFree(block), AllocError::DoubleFree);
+    SegmentManagerStats stats = ssm.getStats();
+    EXPECT_EQ(stats.freesNum, 1);
+    EXPECT_EQ(stats.freeBlocksNum, 1);
+
+    // free() tells the same by throwing:
+    EXPECT_THROW(ssm.free(nullptr), std::invalid_argument);
+    EXPECT_THROW(ssm.free(foreign), std::runtime_error);
+    EXPECT_THROW(ssm.free(block), std::runtime_error);
+    EXPECT_STREQ(toString(AllocError::DoubleFree), "double free");
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SlabSegmentManager.hpp"
+
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+TEST(BicyclesSlabSegmentManagerTestSuite, ObjectsAndLargeBlocks)
+{
+    const size_t segSize = 256 * 1024;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    SlabSegmentManager slsm(seg.get(), segSize);
+
+    // Objects of a size are packed back to back in their slab, with no header in between:
+    char* p1 = static_cast<char*>(slsm.alloc(48));
+    char* p2 = static_cast<char*>(slsm.alloc(40));
+    char* p3 = static_cast<char*>(slsm.alloc(33, 16));
+    ASSERT_NE(p1, nullptr);
+    EXPECT_EQ(p2, p1 + 48);
+    EXPECT_EQ(p3, p2 + 48);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p1) % SlabSegmentManager::OBJECT_ALIGNMENT, 0);
+    EXPECT_EQ(slsm.getSlabsNum(), 1u);
+
+    // Large & over-aligned blocks come from the backing segment:
+    char* large = static_cast<char*>(slsm.alloc(5000));
+    char* aligned = static_cast<char*>(slsm.alloc(48, 256));
+    ASSERT_NE(large, nullptr);
+    ASSERT_NE(aligned, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0);
+    EXPECT_EQ(slsm.getSlabsNum(), 1u);
+
+    slsm.free(p2);
+    EXPECT_EQ(slsm.alloc(48), p2); // reused first
+    EXPECT_THROW(slsm.free(p1 + 16), std::runtime_error);
+    EXPECT_THROW(slsm.free(p3 + 48), std::runtime_error); // never handed out
+    EXPECT_THROW(slsm.free(nullptr), std::invalid_argument);
+
+    // Resizing within the object size:
+    EXPECT_TRUE(slsm.tryExpand(p1, 48));
+    EXPECT_FALSE(slsm.tryExpand(p1, 49));
+    std::strcpy(p1, "slab object");
+    char* moved = static_cast<char*>(slsm.realloc(p1, 2000));
+    ASSERT_NE(moved, nullptr);
+    EXPECT_STREQ(moved, "slab object");
+
+    slsm.free(moved);
+    slsm.free(p2);
+    slsm.free(p3);
+    slsm.free(large);
+    slsm.free(aligned);
+}
+
+TEST(BicyclesSlabSegmentManagerTestSuite, EmptySlabsGoBack)
+{
+    const size_t segSize = 1024 * 1024;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    SlabSegmentManager slsm(seg.get(), segSize);
+    const SegmentManagerStats initial = slsm.getStats();
+
+    const size_t objectSize = 64;
+    const size_t objectsPerSlab = (SlabSegmentManager::SLAB_SZ - 16 - 64) / objectSize;
+    std::vector<void*> objects;
+    for (size_t i = 0; i < 3 * objectsPerSlab + 1; i++)
+    {
+        objects.push_back(slsm.alloc(objectSize));
+        ASSERT_NE(objects.back(), nullptr);
+    }
+    EXPECT_EQ(slsm.getSlabsNum(), 4u);
+    SegmentManagerStats stats = slsm.getStats();
+    EXPECT_EQ(stats.occupiedBytes + stats.freeBytes, stats.segmentBytes);
+    EXPECT_EQ(stats.allocsNum, objects.size());
+
+    // Slabs are back to back, each in its own SLAB_SZ chunk:
+    std::set<uintptr_t> chunks;
+    for (void* object : objects)
+    {
+        chunks.insert(reinterpret_cast<uintptr_t>(object) / SlabSegmentManager::SLAB_SZ);
+    }
+    EXPECT_EQ(chunks.size(), 4u);
+    EXPECT_EQ(*chunks.rbegin() - *chunks.begin(), 3u);
+
+    // A slab becoming empty is kept as a spare, the next ones go back to the backing segment:
+    for (void* object : objects)
+    {
+        slsm.free(object);
+    }
+    EXPECT_EQ(slsm.getSlabsNum(), SlabSegmentManager::MAX_EMPTY_SLABS);
+    slsm.releaseEmptySlabs();
+    EXPECT_EQ(slsm.getSlabsNum(), 0u);
+
+    stats = slsm.getStats();
+    EXPECT_EQ(stats.occupiedBytes, initial.occupiedBytes);
+    EXPECT_EQ(stats.freeBlocksNum, initial.freeBlocksNum);
+    EXPECT_EQ(stats.freesNum, objects.size());
+
+    // The freed space serves large blocks now:
+    void* large = slsm.alloc(3 * SlabSegmentManager::SLAB_SZ);
+    EXPECT_NE(large, nullptr);
+    slsm.free(large);
+}
+
+TEST(BicyclesSlabSegmentManagerTestSuite, CacheColouring)
+{
+    const size_t segSize = 1024 * 1024;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    SlabSegmentManager slsm(seg.get(), segSize);
+
+    // 240-byte objects leave a few cache lines of a slab unused, so consecutive slabs start their objects
+    // at different cache lines:
+    const size_t objectSize = 240;
+    const size_t objectsPerSlab = (SlabSegmentManager::SLAB_SZ - 16 - 64) / objectSize;
+    std::vector<uintptr_t> firstOffsets;
+    for (size_t slab = 0; slab < 4; slab++)
+    {
+        for (size_t i = 0; i < objectsPerSlab; i++)
+        {
+            uintptr_t object = reinterpret_cast<uintptr_t>(slsm.alloc(objectSize));
+            ASSERT_NE(object, 0u);
+            if (0 == i)
+            {
+                firstOffsets.push_back(object % SlabSegmentManager::SLAB_SZ);
+            }
+        }
+    }
+    EXPECT_EQ(std::set<uintptr_t>(firstOffsets.begin(), firstOffsets.end()).size(), firstOffsets.size());
+    for (size_t i = 1; i < firstOffsets.size(); i++)
+    {
+        EXPECT_EQ((firstOffsets[i] - firstOffsets[0]) % SlabSegmentManager::CACHE_LINE_SZ, 0u);
+    }
+}
+
+TEST(BicyclesSlabSegmentManagerTestSuite, ContainersFromThreads)
+{
+    const size_t segSize = 16 * 1024 * 1024;
+    std::unique_ptr<char[]> seg(new char[segSize]);
+    SharedPtr<SlabSegmentManager> slsm = makeShared<SlabSegmentManager>(seg.get(), segSize);
+
+    using BicyclesMap = std::map<int, BicycleImpl, std::less<int>,
+                                 MyAllocatorNonOwning<std::pair<const int, BicycleImpl>, SlabSegmentManager>>;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&slsm, t]() {
+            BicyclesMap bicycles(slsm);
+            std::list<int, MyAllocatorNonOwning<int, SlabSegmentManager>> ids(slsm);
+            for (int i = 0; i < 5000; i++)
+            {
+                bicycles.emplace(i, BicycleImpl("Bicycle", t, t));
+                ids.push_back(i);
+                if (i % 3 == 0)
+                {
+                    bicycles.erase(i / 2);
+                    ids.pop_front();
+                }
+            }
+            for (const auto& [id, bicycle] : bicycles)
+            {
+                ASSERT_EQ(bicycle.getPressureFront(), t);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    SegmentManagerStats stats = slsm->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+    slsm->releaseEmptySlabs();
+    EXPECT_EQ(slsm->getSlabsNum(), 0u);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "BicycleImpl.hpp"
+#include "MemoryManagement/MyAllocatorNonOwning.hpp"
+#include "MemoryManagement/SmallObjectSegmentManager.hpp"
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace testing;
+using namespace mybicycles;
+
+TEST(BicyclesSmallObjectSegmentManagerTestSuite, HeaderlessBlocks)
+{
+    const size_t segSize = 64 * 1024;
+    alignas(16) char seg[segSize];
+    SmallObjectSegmentManager sosm(seg, segSize);
+
+    // Blocks of a size class are packed back to back, with no header in between:
+    char* p1 = static_cast<char*>(sosm.alloc(32));
+    char* p2 = static_cast<char*>(sosm.alloc(30));
+    char* p3 = static_cast<char*>(sosm.alloc(17, 16));
+    ASSERT_NE(p1, nullptr);
+    EXPECT_EQ(p2, p1 + 32);
+    EXPECT_EQ(p3, p2 + 32);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(sosm.alloc(48)) % 16, 0);
+
+    // Large & over-aligned blocks come from the large-object region:
+    char* large = static_cast<char*>(sosm.alloc(1000));
+    char* aligned = static_cast<char*>(sosm.alloc(32, 64));
+    ASSERT_NE(large, nullptr);
+    ASSERT_NE(aligned, nullptr);
+    EXPECT_GE(large, seg + segSize / 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+
+    sosm.free(p2, 30);
+    EXPECT_EQ(sosm.alloc(32), p2); // reused first
+    sosm.free(p2); // unsized free works as well
+    EXPECT_THROW(sosm.free(p1, 33), std::invalid_argument);
+    EXPECT_THROW(sosm.free(p1 + 16), std::runtime_error);
+    EXPECT_THROW(sosm.free(seg + segSize / 4), std::runtime_error); // an unassigned run
+    sosm.free(p1, 32);
+    sosm.free(p3, 17);
+    sosm.free(large, 1000);
+    sosm.free(aligned);
+}
+
+TEST(BicyclesSmallObjectSegmentManagerTestSuite, ResizeAndStats)
+{
+    const size_t segSize = 64 * 1024;
+    alignas(16) char seg[segSize];
+    SmallObjectSegmentManager sosm(seg, segSize);
+    const SegmentManagerStats initial = sosm.getStats();
+    EXPECT_EQ(initial.occupiedBytes + initial.freeBytes, initial.segmentBytes);
+
+    char* p = static_cast<char*>(sosm.alloc(20));
+    EXPECT_TRUE(sosm.tryExpand(p, 32));
+    EXPECT_FALSE(sosm.tryExpand(p, 33));
+    std::strcpy(p, "small object");
+    char* q = static_cast<char*>(sosm.realloc(p, 500));
+    ASSERT_NE(q, nullptr);
+    EXPECT_STREQ(q, "small object");
+    sosm.shrink(q, 100);
+    sosm.free(q, 100);
+
+    SegmentManagerStats stats = sosm.getStats();
+    EXPECT_EQ(stats.occupiedBytes + stats.freeBytes, stats.segmentBytes);
+    EXPECT_EQ(stats.allocsNum, 2);
+    EXPECT_EQ(stats.freesNum, 2);
+    // Blocks back on a size class free list count as free:
+    EXPECT_EQ(stats.freeBytes, initial.freeBytes);
+}
+
+TEST(BicyclesSmallObjectSegmentManagerTestSuite, SmallRegionExhausted)
+{
+    const size_t segSize = 16 * 1024;
+    alignas(16) char seg[segSize];
+    SmallObjectSegmentManager sosm(seg, segSize, false, 0.3); // a single run
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < SmallObjectSegmentManager::RUN_SZ / 64 + 10; i++)
+    {
+        void* block = sosm.alloc(64);
+        ASSERT_NE(block, nullptr);
+        blocks.push_back(block);
+    }
+    EXPECT_GE(static_cast<char*>(blocks.back()), seg + segSize * 3 / 10); // spilled into the large region
+    for (void* block : blocks)
+    {
+        sosm.free(block, 64);
+    }
+    EXPECT_THROW(SmallObjectSegmentManager(seg, segSize, false, 1.0), std::invalid_argument);
+}
+
+TEST(BicyclesSmallObjectSegmentManagerTestSuite, AllocatorUsesSizedFree)
+{
+    static_assert(HasSizedFree<SmallObjectSegmentManager>::value, "Sized free not detected");
+    static_assert(!HasSizedFree<SimpleSegmentManager>::value, "Sized free detected by mistake");
+
+    const size_t segSize = 512 * 1024;
+    std::vector<char> seg(segSize);
+    SharedPtr<SmallObjectSegmentManager> manager = makeShared<SmallObjectSegmentManager>(seg.data(), segSize);
+    MyAllocatorNonOwning<BicycleImpl, SmallObjectSegmentManager> myal(manager);
+    {
+        std::list<BicycleImpl, MyAllocatorNonOwning<BicycleImpl, SmallObjectSegmentManager>> lst(myal);
+        std::map<int, BicycleImpl, std::less<int>,
+                 MyAllocatorNonOwning<std::pair<const int, BicycleImpl>, SmallObjectSegmentManager>> mp(myal);
+        for (int i = 0; i < 1000; i++)
+        {
+            lst.emplace_back("Bicycle");
+            mp.emplace(i, BicycleImpl("Bicycle"));
+        }
+        EXPECT_EQ(lst.size(), 1000);
+        EXPECT_EQ(mp.size(), 1000);
+        EXPECT_EQ(mp.at(500).getVendor(), "Bicycle");
+    }
+    SegmentManagerStats stats = manager->getStats();
+    EXPECT_EQ(stats.allocsNum, stats.freesNum);
+}
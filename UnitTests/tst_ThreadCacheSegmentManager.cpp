@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include "MemoryManagement/ThreadCacheSegmentManager.hpp"
+
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+TEST(BicyclesThreadCacheSegmentManagerTestSuite, FreedBlockIsReusedBySameThread)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    ThreadCacheSegmentManager tcsm(seg.data(), segSize);
+
+    void* p1 = tcsm.alloc(32);
+    ASSERT_NE(p1, nullptr);
+    tcsm.free(p1);
+    void* p2 = tcsm.alloc(32);
+    EXPECT_EQ(p1, p2);
+    tcsm.free(p2);
+
+    // Large blocks bypass the caches:
+    void* big = tcsm.alloc(ThreadCacheSegmentManager::MAX_CACHED_SZ + 1);
+    ASSERT_NE(big, nullptr);
+    tcsm.free(big);
+
+    EXPECT_THROW(tcsm.free(nullptr), std::invalid_argument);
+    char foreign[32];
+    EXPECT_THROW(tcsm.free(foreign + 16), std::runtime_error);
+
+    SegmentManagerStats stats = tcsm.getStats();
+    EXPECT_EQ(stats.allocsNum, 3);
+    EXPECT_EQ(stats.freesNum, 3);
+    EXPECT_EQ(stats.failedAllocsNum, 0);
+    EXPECT_EQ(stats.segmentBytes, segSize);
+}
+
+TEST(BicyclesThreadCacheSegmentManagerTestSuite, BlocksAreDistinct)
+{
+    const size_t segSize = 64 * 1024;
+    std::vector<char> seg(segSize);
+    ThreadCacheSegmentManager tcsm(seg.data(), segSize);
+
+    std::set<void*> blocks;
+    for (size_t i = 0; i < 200; i++)
+    {
+        void* p = tcsm.alloc(16 + (i % 4) * 16);
+        ASSERT_NE(p, nullptr);
+        EXPECT_TRUE(blocks.insert(p).second);
+    }
+    for (void* p : blocks)
+    {
+        tcsm.free(p);
+    }
+}
+
+TEST(BicyclesThreadCacheSegmentManagerTestSuite, CachedMemoryIsReclaimedOnExhaustion)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    ThreadCacheSegmentManager tcsm(seg.data(), segSize);
+
+    // Scatter small cached blocks over the segment...
+    std::vector<void*> blocks;
+    while (void* p = tcsm.alloc(16))
+    {
+        blocks.push_back(p);
+    }
+    for (void* p : blocks)
+    {
+        tcsm.free(p);
+    }
+    // ... and make sure they're coalesced back when a large block is needed:
+    void* big = tcsm.alloc(segSize / 2);
+    EXPECT_NE(big, nullptr);
+    tcsm.free(big);
+}
+
+TEST(BicyclesThreadCacheSegmentManagerTestSuite, DoubleFree)
+{
+    const size_t segSize = 4096;
+    std::vector<char> seg(segSize);
+    ThreadCacheSegmentManager tcsm(seg.data(), segSize);
+
+    // Freed again while still cached:
+    void* p1 = tcsm.alloc(32);
+    ASSERT_NE(p1, nullptr);
+    tcsm.free(p1);
+    EXPECT_THROW(tcsm.free(p1), std::runtime_error);
+    void* p2 = tcsm.alloc(32);
+    void* p3 = tcsm.alloc(32);
+    EXPECT_EQ(p1, p2);
+    EXPECT_NE(p2, p3);
+    tcsm.free(p3);
+    tcsm.free(p2);
+
+    // Freed again after going back to the shared manager: caught on flush, and the cache stays usable.
+    // The block's neighbours stay allocated, so that it isn't merged into a large free block.
+    tcsm.flushAll();
+    void* neighbours[3] = {tcsm.alloc(32), tcsm.alloc(32), tcsm.alloc(32)};
+    std::sort(neighbours, neighbours + 3);
+    void* q = neighbours[1];
+    tcsm.free(q);
+    tcsm.flushAll();
+    tcsm.free(q);
+    EXPECT_THROW(tcsm.flushAll(), std::runtime_error);
+    tcsm.flushAll();
+    tcsm.free(neighbours[0]);
+    tcsm.free(neighbours[2]);
+
+    std::set<void*> blocks;
+    while (void* p = tcsm.alloc(32))
+    {
+        EXPECT_TRUE(blocks.insert(p).second);
+    }
+    for (void* p : blocks)
+    {
+        tcsm.free(p);
+    }
+
+    // Nothing has leaked or been lost
+    void* big = tcsm.alloc(segSize - 256);
+    EXPECT_NE(big, nullptr);
+    tcsm.free(big);
+}
+
+TEST(BicyclesThreadCacheSegmentManagerTestSuite, RemoteFrees)
+{
+    const size_t segSize = 256 * 1024;
+    const size_t itemsNum = 20000;
+    std::vector<char> seg(segSize);
+    ThreadCacheSegmentManager tcsm(seg.data(), segSize);
+
+    // Producer allocates, consumer frees: every free is a remote one
+    std::vector<void*> queue(itemsNum, nullptr);
+    std::atomic<size_t> produced(0);
+
+    std::thread producer([&]() {
+        for (size_t i = 0; i < itemsNum; i++)
+        {
+            void* p = nullptr;
+            while (nullptr == (p = tcsm.alloc(48)))
+            {
+                std::this_thread::yield();
+            }
+            queue[i] = p;
+            produced.store(i + 1, std::memory_order_release);
+        }
+    });
+    std::thread consumer([&]() {
+        for (size_t i = 0; i < itemsNum; i++)
+        {
+            while (produced.load(std::memory_order_acquire) <= i)
+            {
+                std::this_thread::yield();
+            }
+            tcsm.free(queue[i]);
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    // Nothing has leaked: almost the whole segment can be allocated again
+    void* big = tcsm.alloc(segSize - 1024);
+    EXPECT_NE(big, nullptr);
+    tcsm.free(big);
+}